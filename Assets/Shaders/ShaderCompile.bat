@@ -1,3 +0,0 @@
-C:/VulkanSDK/Bin32/glslangValidator.exe -V shader.vert
-C:/VulkanSDK/Bin32/glslangValidator.exe -V shader.frag
-pause
\ No newline at end of file
@@ -1,6 +1,17 @@
 #version 450
 
+layout (push_constant) uniform DrawConstants
+{
+	mat4 model;
+	vec4 positionScale;
+	vec4 positionOffset;
+} draw;
+
+#ifdef PACKED_VERTICES
+layout (location = 0) in vec4 inPackedPosition;
+#else
 layout (location = 0) in vec3 inPosition;
+#endif
 
 layout (binding = 0) uniform UBO 
 {
@@ -14,5 +25,8 @@ out gl_PerVertex
 
 void main()
 {
-	gl_Position =  ubo.WorldLightViewProjection * vec4(inPosition, 1.0);
+#ifdef PACKED_VERTICES
+	vec3 inPosition = draw.positionOffset.xyz + draw.positionScale.xyz * inPackedPosition.xyz;
+#endif
+	gl_Position =  ubo.WorldLightViewProjection * draw.model * vec4(inPosition, 1.0);
 }
\ No newline at end of file
@@ -2,18 +2,31 @@
 #extension GL_ARB_separate_shader_objects : enable
 
 layout(binding = 0) uniform ProxyModelUniformBufferObject {
-    mat4 mvp;
+    mat4 viewProjection;
 } pmubo;
 
+layout(push_constant) uniform DrawConstants {
+	mat4 model;
+	vec4 positionScale;
+	vec4 positionOffset;
+} draw;
+
+#ifdef PACKED_VERTICES
+layout(location = 0) in vec4 inPackedPosition;
+#else
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
 layout(location = 3) in vec3 inNormal;
+#endif
 
 layout(location = 0) out vec3 fragColor;
 
 void main()
 {
-    gl_Position = pmubo.mvp * vec4(inPosition, 1.0);
+#ifdef PACKED_VERTICES
+	vec3 inPosition = draw.positionOffset.xyz + draw.positionScale.xyz * inPackedPosition.xyz;
+#endif
+    gl_Position = pmubo.viewProjection * draw.model * vec4(inPosition, 1.0);
     fragColor = vec3(0.5,0.0,0.0);
 }
\ No newline at end of file
@@ -29,6 +29,15 @@ layout(location = 8) in vec3 fragLightVectorForShadow;
 
 layout(location = 0) out vec4 outColor;
 
+// Feature toggles specialised per pipeline permutation. Branches on them are folded when pipeline is created,
+// so disabled features cost no fragment ALU & their textures are never sampled.
+layout(constant_id = 0) const bool PROJECTOR_ENABLED = true;
+layout(constant_id = 1) const bool SHADOW_ENABLED = true;
+layout(constant_id = 2) const bool POINT_LIGHT_ENABLED = true;
+layout(constant_id = 3) const bool SPECULAR_ENABLED = true;
+// 0 compares a single shadow map texel, 1 filters 3x3 texels ( PCF )
+layout(constant_id = 4) const int SHADOW_FILTER_MODE = 0;
+
 float textureProj(vec4 shadowCoord, vec2 off)
 {
 	float shadow = 1.0;
@@ -43,38 +52,75 @@ float textureProj(vec4 shadowCoord, vec2 off)
 	return shadow;
 }
 
+float shadowMapLit(vec3 shadowCoordinate, vec2 offset)
+{
+	float sampledDepth = texture(ShadowMapSampler, shadowCoordinate.xy + offset).x + 0.05;
+	return shadowCoordinate.z > sampledDepth ? 0.0 : 1.0;
+}
+
+float shadowLit(vec3 shadowCoordinate)
+{
+	if (SHADOW_FILTER_MODE == 0)
+	{
+		return shadowMapLit(shadowCoordinate, vec2(0.0));
+	}
+
+	vec2 texelSize = 1.0 / vec2(textureSize(ShadowMapSampler, 0));
+	float lit = 0.0;
+	for (int y = -1; y <= 1; ++y)
+	{
+		for (int x = -1; x <= 1; ++x)
+		{
+			lit += shadowMapLit(shadowCoordinate, vec2(x, y) * texelSize);
+		}
+	}
+	return lit / 9.0;
+}
+
 void main() 
 {
 	//vec4 whiteColor = vec4(0,0,1,1);
 	//vec4 blackColor = vec4(0,1,0,1);
 	vec4 whiteColor = vec4(1,1,1,1);
 	vec4 blackColor = vec4(0.71,0.71,0.71,0.5);
-	vec3 pointLightDirection = normalize(fbo.pointLightPosition - fragWorldPosition);
-	vec3 viewDirection = normalize(fbo.cameraPosition - fragWorldPosition);
 
 	vec3 normal = normalize(fragNormal);
 	vec3 lightDirection = normalize(fragLightDirection);
 
 	float n_dot_l = dot(lightDirection, normal);
-	float n_dot_l_pointLight = dot(pointLightDirection, normal);
-	float n_dot_l_lightForShadow = dot(fragLightVectorForShadow, normal);
-
-	vec3 halfVector = normalize(pointLightDirection + viewDirection);
-	float n_dot_h_pointLight = dot(normal, halfVector);
 
 	vec4 sampledColor = texture(texSampler, fragTexCoord);
 	vec3 ambient = fbo.ambientColor.rgb * sampledColor.rgb;
 	vec3 diffuse = clamp(fbo.lightColor.rgb * n_dot_l * sampledColor.rgb, 0.0f, 1.0f);
 
-	vec3 diffusePointLight = clamp(fbo.pointLightColor.rgb * n_dot_l_pointLight * sampledColor.rgb, 0.0f, 1.0f) * fragPointLightAttenuation;
-	vec3 specular = fbo.specularColor.rgb * min(pow(clamp(n_dot_h_pointLight, 0.0f, 1.0f), fbo.specularPower), sampledColor.w) * fragPointLightAttenuation;
+	outColor.rgb = ambient + diffuse;
+	outColor.a = sampledColor.a;
 
-	vec3 diffuseLightForShadow = clamp(fbo.lightColor.rgb * n_dot_l_lightForShadow * sampledColor.rgb, 0.0f, 1.0f)*fragPointLightAttenuation;
+	if (POINT_LIGHT_ENABLED)
+	{
+		vec3 pointLightDirection = normalize(fbo.pointLightPosition - fragWorldPosition);
+		float n_dot_l_pointLight = dot(pointLightDirection, normal);
+		vec3 diffusePointLight = clamp(fbo.pointLightColor.rgb * n_dot_l_pointLight * sampledColor.rgb, 0.0f, 1.0f) * fragPointLightAttenuation;
+		outColor.rgb += diffusePointLight;
 
-	outColor.rgb = ambient + diffuse + diffusePointLight + diffuseLightForShadow + specular;
-	outColor.a = sampledColor.a;
+		if (SPECULAR_ENABLED)
+		{
+			vec3 viewDirection = normalize(fbo.cameraPosition - fragWorldPosition);
+			vec3 halfVector = normalize(pointLightDirection + viewDirection);
+			float n_dot_h_pointLight = dot(normal, halfVector);
+			vec3 specular = fbo.specularColor.rgb * min(pow(clamp(n_dot_h_pointLight, 0.0f, 1.0f), fbo.specularPower), sampledColor.w) * fragPointLightAttenuation;
+			outColor.rgb += specular;
+		}
+	}
+
+	if (SHADOW_ENABLED)
+	{
+		float n_dot_l_lightForShadow = dot(fragLightVectorForShadow, normal);
+		vec3 diffuseLightForShadow = clamp(fbo.lightColor.rgb * n_dot_l_lightForShadow * sampledColor.rgb, 0.0f, 1.0f)*fragPointLightAttenuation;
+		outColor.rgb += diffuseLightForShadow;
+	}
 
-	if(fragProjectedTextureCoordinate.w <= 0.0f)
+	if(PROJECTOR_ENABLED && fragProjectedTextureCoordinate.w <= 0.0f)
 	{
 		vec2 projectedTextureCoordinate = fragProjectedTextureCoordinate.xy / fragProjectedTextureCoordinate.w;
 		vec3 sampledProjectedTexColor = texture(projectedTexSampler, projectedTextureCoordinate.xy).rgb;
@@ -84,12 +130,10 @@ void main()
 	//float shadow = textureProj(fragShadowCoordinate / fragShadowCoordinate.w, vec2(0.0));
 	//outColor.rgb *= shadow;
 
-	if(fragShadowCoordinate.w <= 0.0f)
+	if(SHADOW_ENABLED && fragShadowCoordinate.w <= 0.0f)
 	{
 		vec3 shadowCoordinate = fragShadowCoordinate.xyz / fragShadowCoordinate.w;
-		float pixelDepth = shadowCoordinate.z;
-		float sampledDepth = texture(ShadowMapSampler, shadowCoordinate.xy).x + 0.05;
-		vec3 shadow = (pixelDepth > sampledDepth ? blackColor.rgb : whiteColor.rgb);
+		vec3 shadow = mix(blackColor.rgb, whiteColor.rgb, shadowLit(shadowCoordinate));
 		outColor.rgb *= shadow;
 	}
 	
@@ -2,7 +2,6 @@
 #extension GL_ARB_separate_shader_objects : enable
 
 layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
     mat4 view;
     mat4 proj;
 	vec3 lightDirection;
@@ -13,10 +12,23 @@ layout(binding = 0) uniform UniformBufferObject {
 	vec3 lightPositionForShadow;
 } ubo;
 
+// Object's world matrix, dequantisation of packed positions is identity for float vertices
+layout(push_constant) uniform DrawConstants {
+	mat4 model;
+	vec4 positionScale;
+	vec4 positionOffset;
+} draw;
+
+#ifdef PACKED_VERTICES
+layout(location = 0) in vec4 inPackedPosition;
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec2 inPackedNormal;
+#else
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
 layout(location = 3) in vec3 inNormal;
+#endif
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
@@ -36,20 +48,30 @@ const mat4 biasMat = mat4(
 
 void main() 
 {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+#ifdef PACKED_VERTICES
+	vec3 inPosition = draw.positionOffset.xyz + draw.positionScale.xyz * inPackedPosition.xyz;
+	// Octahedral normal, lower hemisphere is folded over diagonals
+	vec3 inNormal = vec3(inPackedNormal, 1.0 - abs(inPackedNormal.x) - abs(inPackedNormal.y));
+	float fold = max(-inNormal.z, 0.0);
+	inNormal.x += inNormal.x >= 0.0 ? -fold : fold;
+	inNormal.y += inNormal.y >= 0.0 ? -fold : fold;
+	inNormal = normalize(inNormal);
+	vec3 inColor = vec3(1.0);
+#endif
+	fragWorldPosition = (draw.model * vec4(inPosition, 1.0)).xyz;
+    gl_Position = ubo.proj * ubo.view * vec4(fragWorldPosition, 1.0);
     fragColor = inColor;
     fragTexCoord = inTexCoord;
-	fragNormal = (ubo.model * vec4(inNormal, 0.0f)).xyz;
-	fragWorldPosition = (ubo.model * vec4(inPosition, 1.0)).xyz;
+	fragNormal = (draw.model * vec4(inNormal, 0.0f)).xyz;
 	fragLightDirection = -ubo.lightDirection;
 
 	vec3 pointLightDirection = ubo.pointLightPosition - fragWorldPosition;
 	fragPointLightAttenuation = clamp(1.0f - (length(pointLightDirection) / ubo.pointLightRadius), 0.0f, 1.0f);
 
-	fragProjectedTextureCoordinate = (vec4(inPosition, 1.0f) * ubo.projectiveTextureMatrix).xyzw;
+	fragProjectedTextureCoordinate = (vec4(fragWorldPosition, 1.0f) * ubo.projectiveTextureMatrix).xyzw;
 
 	//fragLightVectorForShadow = normalize(ubo.lightPositionForShadow - inPosition);
 	//fragShadowCoordinate =  (biasMat * ubo.WorldLightViewProjection * ubo.model)*vec4(inPosition, 1.0);
 	fragLightVectorForShadow = normalize(ubo.lightPositionForShadow - fragWorldPosition);
-	fragShadowCoordinate =  vec4(inPosition, 1.0) * ubo.WorldLightViewProjection;
+	fragShadowCoordinate =  vec4(fragWorldPosition, 1.0) * ubo.WorldLightViewProjection;
 }
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "AssetFileSystem.h"
+#include <filesystem>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace AlphonsoGraphicsEngine
+{
+	const char* const AssetFileSystem::AssetDirectoryName = "Assets";
+	const char* const AssetFileSystem::PackName = "Assets.pack";
+
+	AssetFileSystem::File::operator bool() const
+	{
+		return data != nullptr;
+	}
+
+	uint64_t AssetFileSystem::File::ContentHash() const
+	{
+		return packed ? contentHash : SourceFingerprint::Hash(data, size);
+	}
+
+	bool AssetFileSystem::File::Fingerprint(SourceFingerprint& fingerprint) const
+	{
+		if (packed)
+		{
+			// Packed entries have no time of their own, so only size & content hash identify them
+			fingerprint.size = size;
+			fingerprint.modifiedTime = 0;
+			fingerprint.hash = contentHash;
+			return true;
+		}
+		return SourceFingerprint::Capture(loosePath, fingerprint);
+	}
+
+	bool AssetFileSystem::File::Matches(const SourceFingerprint& fingerprint) const
+	{
+		if (packed)
+		{
+			return fingerprint.size == size && fingerprint.hash == contentHash;
+		}
+		return fingerprint.Matches(loosePath);
+	}
+
+	bool AssetFileSystem::Initialize()
+	{
+		Shutdown();
+
+		// Nearest directory holding a pack or an Assets directory wins, so both always come from same install
+		std::error_code error;
+		std::filesystem::path startDirectories[] = { ExecutableDirectory(), std::filesystem::current_path(error) };
+		for (const std::filesystem::path& startDirectory : startDirectories)
+		{
+			for (std::filesystem::path directory = startDirectory; !directory.empty(); directory = directory.parent_path())
+			{
+				std::filesystem::path packPath = directory / PackName;
+				std::filesystem::path assetRoot = directory / AssetDirectoryName;
+				bool hasPack = std::filesystem::is_regular_file(packPath, error);
+				bool hasAssetRoot = std::filesystem::is_directory(assetRoot, error);
+				if (hasPack || hasAssetRoot)
+				{
+					mPackPath = packPath.string();
+					mAssetRoot = hasAssetRoot ? assetRoot.string() : std::string();
+					// A pack of another version is ignored, loose files are read instead
+					mPack.Open(mPackPath);
+					return true;
+				}
+
+				if (directory == directory.root_path())
+				{
+					break;
+				}
+			}
+		}
+		return false;
+	}
+
+	void AssetFileSystem::Shutdown()
+	{
+		mPack.Close();
+		mAssetRoot.clear();
+		mPackPath.clear();
+	}
+
+	AssetFileSystem::File AssetFileSystem::Read(const std::string& name, Lookup lookup) const
+	{
+		File file = lookup == Lookup::PackFirst ? ReadPacked(name) : ReadLoose(name);
+		if (!file)
+		{
+			file = lookup == Lookup::PackFirst ? ReadLoose(name) : ReadPacked(name);
+		}
+		return file;
+	}
+
+	AssetFileSystem::File AssetFileSystem::ReadPacked(const std::string& name) const
+	{
+		File file;
+
+		AssetPack::Entry entry;
+		if (mPack.Find(name, entry))
+		{
+			file.data = entry.data;
+			file.size = entry.size;
+			file.packed = true;
+			file.contentHash = entry.contentHash;
+		}
+		return file;
+	}
+
+	AssetFileSystem::File AssetFileSystem::ReadLoose(const std::string& name) const
+	{
+		File file;
+		if (mAssetRoot.empty())
+		{
+			return file;
+		}
+
+		auto mapping = std::make_shared<MappedFile>();
+		std::string loosePath = LoosePath(name);
+		if (mapping->Open(loosePath))
+		{
+			file.data = mapping->Data();
+			file.size = mapping->Size();
+			file.loosePath = loosePath;
+			file.looseMapping = mapping;
+		}
+		return file;
+	}
+
+	std::string AssetFileSystem::LoosePath(const std::string& name) const
+	{
+		if (mAssetRoot.empty())
+		{
+			return std::string();
+		}
+		return (std::filesystem::path(mAssetRoot) / std::filesystem::path(name).make_preferred()).string();
+	}
+
+	const std::string& AssetFileSystem::AssetRoot() const
+	{
+		return mAssetRoot;
+	}
+
+	const std::string& AssetFileSystem::PackPath() const
+	{
+		return mPackPath;
+	}
+
+	std::string AssetFileSystem::ExecutableDirectory()
+	{
+#ifdef _WIN32
+		char path[MAX_PATH];
+		DWORD length = GetModuleFileNameA(nullptr, path, MAX_PATH);
+		if (length == 0 || length == MAX_PATH)
+		{
+			return std::string();
+		}
+		return std::filesystem::path(std::string(path, length)).parent_path().string();
+#else
+		std::error_code error;
+		std::filesystem::path path = std::filesystem::read_symlink("/proc/self/exe", error);
+		return error ? std::string() : path.parent_path().string();
+#endif
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <memory>
+#include "AssetPack.h"
+#include "MappedFile.h"
+#include "SourceFingerprint.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Read-only view of engine assets by name, e.g. "Shaders/shader.frag". Names are looked up in asset pack first &
+	/// in loose Assets directory second unless asked otherwise, so a file added since pack was built is still found. Both are searched for
+	/// upwards from executable's directory, so engine no longer depends on working directory.
+	/// Reads only touch immutable state & may run on any thread.
+	/// </summary>
+	class AssetFileSystem final
+	{
+	public:
+		/// <summary>Where a name is looked up first.</summary>
+		enum class Lookup
+		{
+			PackFirst,
+			// For assets edited while engine runs, e.g. shader sources, & assets cooked at runtime
+			LooseFirst
+		};
+
+		/// <summary>Contents of an asset, pointing into pack or into a mapping of its loose file.</summary>
+		struct File
+		{
+			const uint8_t* data = nullptr;
+			size_t size = 0;
+			// Content hash of packed entries, loose files are fingerprinted through their path instead
+			bool packed = false;
+			uint64_t contentHash = 0;
+			std::string loosePath;
+			// Keeps a loose file mapped while any copy of File is alive
+			std::shared_ptr<const MappedFile> looseMapping;
+
+			explicit operator bool() const;
+
+			/// <summary>Gets content hash, same as SourceFingerprint::Hash. Loose files are hashed on every call.</summary>
+			uint64_t ContentHash() const;
+
+			/// <summary>Fingerprints contents, so assets cooked from them can be checked for staleness.</summary>
+			/// <param name="fingerprint">Receives fingerprint.</param>
+			/// <returns>False if loose file can't be read.</returns>
+			bool Fingerprint(SourceFingerprint& fingerprint) const;
+
+			/// <summary>Checks whether contents still are what a fingerprint was captured from.</summary>
+			bool Matches(const SourceFingerprint& fingerprint) const;
+		};
+
+		AssetFileSystem() = default;
+		AssetFileSystem(const AssetFileSystem&) = delete;
+		AssetFileSystem& operator=(const AssetFileSystem&) = delete;
+		AssetFileSystem(AssetFileSystem&&) = delete;
+		AssetFileSystem& operator=(AssetFileSystem&&) = delete;
+		~AssetFileSystem() = default;
+
+		/// <summary>Locates & maps asset pack & locates loose Assets directory.</summary>
+		/// <returns>False if neither was found.</returns>
+		bool Initialize();
+
+		/// <summary>Unmaps asset pack. Files read from it become invalid.</summary>
+		void Shutdown();
+
+		/// <summary>Reads an asset without copying it.</summary>
+		/// <param name="name">Name of asset, relative to asset root with '/' separators.</param>
+		/// <param name="lookup">Whether pack or loose Assets directory is looked in first.</param>
+		/// <returns>Contents of asset, empty if it wasn't found.</returns>
+		File Read(const std::string& name, Lookup lookup = Lookup::PackFirst) const;
+
+		/// <summary>
+		/// Gets path of an asset in loose Assets directory, e.g. where assets cooked at runtime are written.
+		/// Cooked assets are read LooseFirst, so a fresh cook beats a stale pack entry, & while their fingerprint still matches
+		/// their source they are used straight from pack or their mapping without touching source.
+		/// Cooking is best effort: without loose Assets directory, e.g. in a read-only install, next launch just cooks again.
+		/// </summary>
+		/// <returns>Path, empty if there is no loose Assets directory.</returns>
+		std::string LoosePath(const std::string& name) const;
+
+		/// <summary>Gets loose Assets directory, empty if none was found.</summary>
+		const std::string& AssetRoot() const;
+
+		/// <summary>Gets path asset pack is mapped from, or is built to when none was found.</summary>
+		const std::string& PackPath() const;
+
+		static const char* const AssetDirectoryName;
+		static const char* const PackName;
+
+	private:
+		File ReadPacked(const std::string& name) const;
+		File ReadLoose(const std::string& name) const;
+		static std::string ExecutableDirectory();
+
+		AssetPack mPack;
+		std::string mAssetRoot;
+		std::string mPackPath;
+	};
+}
@@ -0,0 +1,212 @@
+#include "AssetPack.h"
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "SourceFingerprint.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	// "APAK"
+	const uint32_t AssetPack::Magic = 0x4B415041;
+	const uint32_t AssetPack::Version = 1;
+	// Covers cooked mesh streams, KTX2 levels & SPIR-V words, & keeps payloads off each other's cache lines
+	const uint64_t AssetPack::PayloadAlignment = 64;
+
+	bool AssetPack::Open(const std::string& path)
+	{
+		Close();
+
+		if (!mFile.Open(path) || mFile.Size() < sizeof(Header))
+		{
+			mFile.Close();
+			return false;
+		}
+
+		const Header* header = reinterpret_cast<const Header*>(mFile.Data());
+		if (header->magic != Magic || header->version != Version
+			|| header->tocOffset % alignof(TocEntry) != 0
+			|| header->tocOffset + static_cast<uint64_t>(header->entryCount) * sizeof(TocEntry) > mFile.Size()
+			|| header->namesOffset + header->namesSize > mFile.Size())
+		{
+			mFile.Close();
+			return false;
+		}
+
+		const TocEntry* toc = reinterpret_cast<const TocEntry*>(mFile.Data() + header->tocOffset);
+		for (uint32_t i = 0; i < header->entryCount; ++i)
+		{
+			if (toc[i].dataOffset + toc[i].dataSize > mFile.Size() || static_cast<uint64_t>(toc[i].nameOffset) + toc[i].nameLength > header->namesSize
+				|| (i > 0 && toc[i].nameHash < toc[i - 1].nameHash))
+			{
+				mFile.Close();
+				return false;
+			}
+		}
+
+		mHeader = header;
+		mToc = toc;
+		mNames = reinterpret_cast<const char*>(mFile.Data() + header->namesOffset);
+		return true;
+	}
+
+	void AssetPack::Close()
+	{
+		mFile.Close();
+		mHeader = nullptr;
+		mToc = nullptr;
+		mNames = nullptr;
+	}
+
+	bool AssetPack::IsOpen() const
+	{
+		return mHeader != nullptr;
+	}
+
+	bool AssetPack::Find(const std::string& name, Entry& entry) const
+	{
+		if (mHeader == nullptr)
+		{
+			return false;
+		}
+
+		// Names sharing a hash sit next to each other, so only those are compared
+		uint64_t nameHash = HashName(name.data(), name.size());
+		const TocEntry* end = mToc + mHeader->entryCount;
+		const TocEntry* candidate = std::lower_bound(mToc, end, nameHash, [](const TocEntry& tocEntry, uint64_t hash) { return tocEntry.nameHash < hash; });
+		for (; candidate != end && candidate->nameHash == nameHash; ++candidate)
+		{
+			if (candidate->nameLength == name.size() && memcmp(mNames + candidate->nameOffset, name.data(), name.size()) == 0)
+			{
+				entry.data = mFile.Data() + candidate->dataOffset;
+				entry.size = static_cast<size_t>(candidate->dataSize);
+				entry.contentHash = candidate->contentHash;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool AssetPack::Build(const std::string& assetRoot, const std::string& packPath)
+	{
+		struct Source
+		{
+			std::string name;
+			std::filesystem::path path;
+			TocEntry tocEntry;
+		};
+
+		std::error_code error;
+		std::filesystem::path packFile = std::filesystem::absolute(packPath, error);
+		std::vector<Source> sources;
+		for (auto iterator = std::filesystem::recursive_directory_iterator(assetRoot, error); !error && iterator != std::filesystem::recursive_directory_iterator(); iterator.increment(error))
+		{
+			std::error_code fileError;
+			if (!iterator->is_regular_file(fileError) || iterator->path().extension() == ".tmp" || std::filesystem::equivalent(iterator->path(), packFile, fileError))
+			{
+				continue;
+			}
+
+			Source source;
+			source.name = std::filesystem::relative(iterator->path(), assetRoot).generic_string();
+			source.path = iterator->path();
+			source.tocEntry = {};
+			source.tocEntry.nameHash = HashName(source.name.data(), source.name.size());
+			sources.push_back(std::move(source));
+		}
+		if (error)
+		{
+			return false;
+		}
+
+		// Sorted by name within a hash too, so same tree always packs to same bytes
+		std::sort(sources.begin(), sources.end(), [](const Source& left, const Source& right)
+		{
+			return left.tocEntry.nameHash != right.tocEntry.nameHash ? left.tocEntry.nameHash < right.tocEntry.nameHash : left.name < right.name;
+		});
+
+		std::string names;
+		for (Source& source : sources)
+		{
+			source.tocEntry.nameOffset = static_cast<uint32_t>(names.size());
+			source.tocEntry.nameLength = static_cast<uint32_t>(source.name.size());
+			names += source.name;
+		}
+
+		std::string temporaryPath = packPath + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!file)
+			{
+				return false;
+			}
+
+			// Header is rewritten once offsets of table of contents & names are known
+			Header header = {};
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+			const char padding[64] = {};
+			uint64_t written = sizeof(header);
+			bool readFailed = false;
+			for (Source& source : sources)
+			{
+				uint64_t offset = (written + PayloadAlignment - 1) & ~(PayloadAlignment - 1);
+				file.write(padding, static_cast<std::streamsize>(offset - written));
+				source.tocEntry.dataOffset = offset;
+
+				// Empty files can't be mapped & have nothing to copy
+				MappedFile payload;
+				std::error_code sizeError;
+				if (std::filesystem::file_size(source.path, sizeError) != 0 || sizeError)
+				{
+					if (!payload.Open(source.path.string()))
+					{
+						readFailed = true;
+						break;
+					}
+					file.write(reinterpret_cast<const char*>(payload.Data()), static_cast<std::streamsize>(payload.Size()));
+				}
+				source.tocEntry.dataSize = payload.Size();
+				source.tocEntry.contentHash = SourceFingerprint::Hash(payload.Data(), payload.Size());
+				written = offset + payload.Size();
+			}
+
+			header.magic = Magic;
+			header.version = Version;
+			header.entryCount = static_cast<uint32_t>(sources.size());
+			header.tocOffset = (written + alignof(TocEntry) - 1) & ~static_cast<uint64_t>(alignof(TocEntry) - 1);
+			header.namesOffset = header.tocOffset + sources.size() * sizeof(TocEntry);
+			header.namesSize = names.size();
+
+			file.write(padding, static_cast<std::streamsize>(header.tocOffset - written));
+			for (const Source& source : sources)
+			{
+				file.write(reinterpret_cast<const char*>(&source.tocEntry), sizeof(TocEntry));
+			}
+			file.write(names.data(), static_cast<std::streamsize>(names.size()));
+			file.seekp(0);
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+			if (readFailed || !file)
+			{
+				file.close();
+				std::filesystem::remove(temporaryPath, error);
+				return false;
+			}
+		}
+
+		std::filesystem::rename(temporaryPath, packPath, error);
+		if (error)
+		{
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	uint64_t AssetPack::HashName(const char* name, size_t length)
+	{
+		return SourceFingerprint::Hash(reinterpret_cast<const uint8_t*>(name), length);
+	}
+}
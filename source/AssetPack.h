@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "MappedFile.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Every file of an asset tree in one memory mapped file. Layout is a header, payloads each 64 byte aligned,
+	/// a table of contents sorted by hash of entry name & a table of names. Names are paths relative to asset root
+	/// with '/' separators, e.g. "Shaders/shader.frag". Lookups binary search table of contents & return pointers
+	/// into the mapping, so nothing is copied or read until it is touched.
+	/// </summary>
+	class AssetPack final
+	{
+	public:
+		/// <summary>Payload of one entry, valid while pack stays open.</summary>
+		struct Entry
+		{
+			const uint8_t* data = nullptr;
+			size_t size = 0;
+			// Content hash of payload, same as SourceFingerprint::Hash
+			uint64_t contentHash = 0;
+		};
+
+		AssetPack() = default;
+		AssetPack(const AssetPack&) = delete;
+		AssetPack& operator=(const AssetPack&) = delete;
+		AssetPack(AssetPack&&) = delete;
+		AssetPack& operator=(AssetPack&&) = delete;
+		~AssetPack() = default;
+
+		/// <summary>Maps pack & validates its header & table of contents.</summary>
+		/// <param name="path">Path of pack.</param>
+		/// <returns>False if pack is missing, of another version or truncated.</returns>
+		bool Open(const std::string& path);
+
+		/// <summary>Unmaps pack. Entries found before become invalid.</summary>
+		void Close();
+
+		bool IsOpen() const;
+
+		/// <summary>Looks up an entry by name.</summary>
+		/// <param name="name">Name of entry, relative to asset root.</param>
+		/// <param name="entry">Receives payload of entry.</param>
+		/// <returns>False if pack has no such entry.</returns>
+		bool Find(const std::string& name, Entry& entry) const;
+
+		/// <summary>
+		/// Packs every file below asset root, skipping temporary files. Pack is written to a temporary file & renamed,
+		/// so a running engine never maps half of it.
+		/// </summary>
+		/// <param name="assetRoot">Directory packed files are taken from.</param>
+		/// <param name="packPath">Path of pack.</param>
+		/// <returns>False if a file couldn't be read or pack couldn't be written.</returns>
+		static bool Build(const std::string& assetRoot, const std::string& packPath);
+
+	private:
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t entryCount;
+			uint32_t reserved;
+			uint64_t tocOffset;
+			uint64_t namesOffset;
+			uint64_t namesSize;
+		};
+
+		struct TocEntry
+		{
+			uint64_t nameHash;
+			uint64_t dataOffset;
+			uint64_t dataSize;
+			uint64_t contentHash;
+			uint32_t nameOffset;
+			uint32_t nameLength;
+		};
+
+		static uint64_t HashName(const char* name, size_t length);
+
+		static const uint32_t Magic;
+		static const uint32_t Version;
+		static const uint64_t PayloadAlignment;
+
+		MappedFile mFile;
+		const Header* mHeader = nullptr;
+		const TocEntry* mToc = nullptr;
+		const char* mNames = nullptr;
+	};
+}
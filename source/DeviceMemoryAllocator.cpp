@@ -0,0 +1,332 @@
+#include "DeviceMemoryAllocator.h"
+#include <stdexcept>
+#include <algorithm>
+
+namespace AlphonsoGraphicsEngine
+{
+	const VkDeviceSize DeviceMemoryAllocator::DefaultBlockSize = 64ull * 1024ull * 1024ull;
+	const VkDeviceSize DeviceMemoryAllocator::MinNodeSize = 256;
+
+	void DeviceMemoryAllocator::Initialize(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize preferredBlockSize)
+	{
+		mDevice = device;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &mMemoryProperties);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		mBufferImageGranularity = properties.limits.bufferImageGranularity;
+		mMaxAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+		// Two pools per memory type, one for linear & one for optimal resources
+		mPools.resize(static_cast<size_t>(mMemoryProperties.memoryTypeCount) * 2);
+		for (uint32_t memoryType = 0; memoryType < mMemoryProperties.memoryTypeCount; ++memoryType)
+		{
+			// Small heaps, e.g. 256MB host visible device local memory, get smaller blocks so one block can't exhaust them
+			VkDeviceSize heapSize = mMemoryProperties.memoryHeaps[mMemoryProperties.memoryTypes[memoryType].heapIndex].size;
+			VkDeviceSize blockSize = std::min(preferredBlockSize, heapSize / 8);
+			VkDeviceSize powerOfTwo = NextPowerOfTwo(blockSize);
+			blockSize = std::max(powerOfTwo == blockSize ? blockSize : powerOfTwo / 2, MinNodeSize);
+
+			for (uint32_t kind = 0; kind < 2; ++kind)
+			{
+				Pool& pool = mPools[memoryType * 2 + kind];
+				pool.memoryType = memoryType;
+				pool.blockSize = blockSize;
+			}
+		}
+	}
+
+	void DeviceMemoryAllocator::Shutdown()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		for (Pool& pool : mPools)
+		{
+			for (std::unique_ptr<Block>& block : pool.blocks)
+			{
+				FreeDeviceMemory(block->memory);
+			}
+			pool.blocks.clear();
+		}
+
+		for (VkDeviceMemory memory : mDedicatedMemory)
+		{
+			FreeDeviceMemory(memory);
+		}
+		mDedicatedMemory.clear();
+		mDedicatedBytes = 0;
+	}
+
+	DeviceMemoryAllocator::Allocation DeviceMemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceKind kind, bool dedicated)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		uint32_t memoryType = FindMemoryType(requirements.memoryTypeBits, properties);
+		uint32_t poolIndex = PoolIndex(memoryType, kind);
+		Pool& pool = mPools[poolIndex];
+
+		Allocation allocation;
+		allocation.pool = poolIndex;
+		allocation.size = requirements.size;
+
+		// Buddy nodes are aligned to their own size, so rounding up to alignment satisfies it
+		VkDeviceSize nodeSize = std::max({ NextPowerOfTwo(requirements.size), NextPowerOfTwo(requirements.alignment), MinNodeSize });
+		if (dedicated || nodeSize > pool.blockSize / 2)
+		{
+			uint8_t* mappedData = nullptr;
+			allocation.memory = AllocateDeviceMemory(requirements.size, memoryType, mappedData);
+			allocation.mappedData = mappedData;
+			allocation.dedicated = true;
+			mDedicatedMemory.insert(allocation.memory);
+			mDedicatedBytes += requirements.size;
+			return allocation;
+		}
+
+		uint32_t level = 0;
+		while ((pool.blockSize >> level) > nodeSize)
+		{
+			++level;
+		}
+
+		Block* target = nullptr;
+		VkDeviceSize offset = 0;
+		for (std::unique_ptr<Block>& block : pool.blocks)
+		{
+			if (TryAllocateFromBlock(*block, pool.blockSize, level, offset))
+			{
+				target = block.get();
+				break;
+			}
+		}
+
+		if (target == nullptr)
+		{
+			std::unique_ptr<Block> block = std::make_unique<Block>();
+			block->memory = AllocateDeviceMemory(pool.blockSize, memoryType, block->mappedData);
+			block->freeNodes.resize(LevelCount(pool.blockSize));
+			block->freeNodes[0].insert(0);
+
+			TryAllocateFromBlock(*block, pool.blockSize, level, offset);
+			target = block.get();
+			pool.blocks.push_back(std::move(block));
+		}
+
+		target->bytesAllocated += pool.blockSize >> level;
+		target->allocationCount++;
+
+		allocation.memory = target->memory;
+		allocation.offset = offset;
+		allocation.level = level;
+		allocation.mappedData = target->mappedData != nullptr ? target->mappedData + offset : nullptr;
+		return allocation;
+	}
+
+	void DeviceMemoryAllocator::Free(Allocation& allocation)
+	{
+		if (allocation.memory == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		if (allocation.dedicated)
+		{
+			mDedicatedMemory.erase(allocation.memory);
+			mDedicatedBytes -= allocation.size;
+			FreeDeviceMemory(allocation.memory);
+			allocation = Allocation();
+			return;
+		}
+
+		Pool& pool = mPools[allocation.pool];
+		auto it = std::find_if(pool.blocks.begin(), pool.blocks.end(), [&allocation](const std::unique_ptr<Block>& block)
+		{
+			return block->memory == allocation.memory;
+		});
+		if (it == pool.blocks.end())
+		{
+			throw std::runtime_error("failed to find block of freed device memory allocation!");
+		}
+
+		Block& block = **it;
+		FreeToBlock(block, pool.blockSize, allocation.offset, allocation.level);
+		block.bytesAllocated -= pool.blockSize >> allocation.level;
+		block.allocationCount--;
+
+		// Keep last empty block of a pool around, so alternating allocate & free doesn't hit vkAllocateMemory each time
+		if (block.allocationCount == 0 && pool.blocks.size() > 1)
+		{
+			FreeDeviceMemory(block.memory);
+			pool.blocks.erase(it);
+		}
+
+		allocation = Allocation();
+	}
+
+	DeviceMemoryAllocator::Allocation DeviceMemoryAllocator::AllocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties)
+	{
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(mDevice, buffer, &memRequirements);
+
+		Allocation allocation = Allocate(memRequirements, properties, ResourceKind::Linear);
+		vkBindBufferMemory(mDevice, buffer, allocation.memory, allocation.offset);
+		return allocation;
+	}
+
+	DeviceMemoryAllocator::Allocation DeviceMemoryAllocator::AllocateForImage(VkImage image, VkImageTiling tiling, VkMemoryPropertyFlags properties, bool dedicated)
+	{
+		VkMemoryRequirements memRequirements;
+		vkGetImageMemoryRequirements(mDevice, image, &memRequirements);
+
+		Allocation allocation = Allocate(memRequirements, properties, tiling == VK_IMAGE_TILING_OPTIMAL ? ResourceKind::Optimal : ResourceKind::Linear, dedicated);
+		vkBindImageMemory(mDevice, image, allocation.memory, allocation.offset);
+		return allocation;
+	}
+
+	uint32_t DeviceMemoryAllocator::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; i++)
+		{
+			if ((typeFilter & (1 << i)) && (mMemoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				return i;
+			}
+		}
+
+		throw std::runtime_error("failed to find suitable memory type!");
+	}
+
+	DeviceMemoryAllocator::Stats DeviceMemoryAllocator::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		Stats stats;
+		for (const Pool& pool : mPools)
+		{
+			for (const std::unique_ptr<Block>& block : pool.blocks)
+			{
+				stats.blockCount++;
+				stats.allocationCount += block->allocationCount;
+				stats.bytesReserved += pool.blockSize;
+				stats.bytesAllocated += block->bytesAllocated;
+			}
+		}
+
+		stats.dedicatedAllocationCount = static_cast<uint32_t>(mDedicatedMemory.size());
+		stats.allocationCount += stats.dedicatedAllocationCount;
+		stats.bytesReserved += mDedicatedBytes;
+		stats.bytesAllocated += mDedicatedBytes;
+		return stats;
+	}
+
+	bool DeviceMemoryAllocator::TryAllocateFromBlock(Block& block, VkDeviceSize blockSize, uint32_t level, VkDeviceSize& offset)
+	{
+		// Smallest free node at least as big as requested one
+		uint32_t source = level;
+		while (block.freeNodes[source].empty())
+		{
+			if (source == 0)
+			{
+				return false;
+			}
+			--source;
+		}
+
+		offset = *block.freeNodes[source].begin();
+		block.freeNodes[source].erase(block.freeNodes[source].begin());
+
+		// Split down to requested level, keeping left halves & freeing right buddies
+		while (source < level)
+		{
+			++source;
+			block.freeNodes[source].insert(offset + (blockSize >> source));
+		}
+		return true;
+	}
+
+	void DeviceMemoryAllocator::FreeToBlock(Block& block, VkDeviceSize blockSize, VkDeviceSize offset, uint32_t level)
+	{
+		// Merge with buddy for as long as it is free too
+		while (level > 0)
+		{
+			VkDeviceSize buddy = offset ^ (blockSize >> level);
+			auto it = block.freeNodes[level].find(buddy);
+			if (it == block.freeNodes[level].end())
+			{
+				break;
+			}
+			block.freeNodes[level].erase(it);
+			offset = std::min(offset, buddy);
+			--level;
+		}
+		block.freeNodes[level].insert(offset);
+	}
+
+	VkDeviceMemory DeviceMemoryAllocator::AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, uint8_t*& mappedData)
+	{
+		if (mMaxAllocationCount != 0 && mDeviceMemoryCount >= mMaxAllocationCount)
+		{
+			throw std::runtime_error("device memory allocation count limit reached!");
+		}
+
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryType;
+
+		VkDeviceMemory memory;
+		if (vkAllocateMemory(mDevice, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate device memory!");
+		}
+		mDeviceMemoryCount++;
+
+		mappedData = nullptr;
+		if (mMemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			void* data;
+			if (vkMapMemory(mDevice, memory, 0, VK_WHOLE_SIZE, 0, &data) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to map device memory!");
+			}
+			mappedData = static_cast<uint8_t*>(data);
+		}
+
+		return memory;
+	}
+
+	void DeviceMemoryAllocator::FreeDeviceMemory(VkDeviceMemory memory)
+	{
+		// Freeing memory implicitly unmaps it
+		vkFreeMemory(mDevice, memory, nullptr);
+		mDeviceMemoryCount--;
+	}
+
+	uint32_t DeviceMemoryAllocator::PoolIndex(uint32_t memoryType, ResourceKind kind) const
+	{
+		// With granularity of 1 linear & optimal resources may share pages, so they share blocks too
+		bool separateOptimal = mBufferImageGranularity > 1 && kind == ResourceKind::Optimal;
+		return memoryType * 2 + (separateOptimal ? 1 : 0);
+	}
+
+	uint32_t DeviceMemoryAllocator::LevelCount(VkDeviceSize blockSize)
+	{
+		uint32_t count = 1;
+		while ((blockSize >> (count - 1)) > MinNodeSize)
+		{
+			++count;
+		}
+		return count;
+	}
+
+	VkDeviceSize DeviceMemoryAllocator::NextPowerOfTwo(VkDeviceSize value)
+	{
+		VkDeviceSize result = 1;
+		while (result < value)
+		{
+			result <<= 1;
+		}
+		return result;
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+#include <set>
+#include <memory>
+#include <mutex>
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Sub-allocates device memory out of large blocks reserved per memory type, using a buddy allocator per block.
+	/// Linear resources (buffers) & optimally tiled images are kept in separate blocks when device reports
+	/// bufferImageGranularity above 1, so they never share a granularity page. Requests too big for a block,
+	/// or explicitly asking for it, get a dedicated VkDeviceMemory. Host visible memory is persistently mapped.
+	/// </summary>
+	class DeviceMemoryAllocator final
+	{
+	public:
+		enum class ResourceKind
+		{
+			Linear,
+			Optimal
+		};
+
+		struct Allocation
+		{
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			VkDeviceSize offset = 0;
+			VkDeviceSize size = 0;
+			// Pointer to offset within persistently mapped memory, null unless memory is host visible
+			void* mappedData = nullptr;
+
+			// Bookkeeping used by Free()
+			uint32_t pool = UINT32_MAX;
+			uint32_t level = 0;
+			bool dedicated = false;
+		};
+
+		struct Stats
+		{
+			uint32_t blockCount = 0;
+			uint32_t dedicatedAllocationCount = 0;
+			uint32_t allocationCount = 0;
+			VkDeviceSize bytesReserved = 0;
+			VkDeviceSize bytesAllocated = 0;
+		};
+
+		DeviceMemoryAllocator() = default;
+		DeviceMemoryAllocator(const DeviceMemoryAllocator&) = delete;
+		DeviceMemoryAllocator& operator=(const DeviceMemoryAllocator&) = delete;
+		DeviceMemoryAllocator(DeviceMemoryAllocator&&) = delete;
+		DeviceMemoryAllocator& operator=(DeviceMemoryAllocator&&) = delete;
+		~DeviceMemoryAllocator() = default;
+
+		/// <summary>Caches memory properties & limits of device.</summary>
+		/// <param name="physicalDevice">Physical device queried for memory types & limits.</param>
+		/// <param name="device">Logical device.</param>
+		/// <param name="preferredBlockSize">Size of blocks reserved per memory type. Rounded down to a power of two & capped to 1/8 of heap.</param>
+		void Initialize(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize preferredBlockSize = DefaultBlockSize);
+
+		/// <summary>Frees every block & dedicated allocation. All resources bound to them must already be destroyed.</summary>
+		void Shutdown();
+
+		/// <summary>Allocates memory satisfying requirements.</summary>
+		/// <param name="requirements">Size, alignment & memory types allowed for resource.</param>
+		/// <param name="properties">Required memory property flags.</param>
+		/// <param name="kind">Whether memory backs a buffer or an optimally tiled image.</param>
+		/// <param name="dedicated">Forces a dedicated VkDeviceMemory, e.g. for large render targets.</param>
+		/// <returns>Allocation to bind resource to, at its offset.</returns>
+		Allocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceKind kind, bool dedicated = false);
+
+		/// <summary>Returns allocation to its block. Does nothing for an empty allocation.</summary>
+		/// <param name="allocation">Allocation to free. Reset to empty.</param>
+		void Free(Allocation& allocation);
+
+		/// <summary>Allocates & binds memory for buffer.</summary>
+		Allocation AllocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+
+		/// <summary>Allocates & binds memory for image.</summary>
+		Allocation AllocateForImage(VkImage image, VkImageTiling tiling, VkMemoryPropertyFlags properties, bool dedicated = false);
+
+		/// <summary>Finds first memory type allowed by typeFilter which has all properties, using cached memory properties.</summary>
+		uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+		Stats GetStats() const;
+
+		static const VkDeviceSize DefaultBlockSize;
+		static const VkDeviceSize MinNodeSize;
+
+	private:
+		struct Block
+		{
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			uint8_t* mappedData = nullptr;
+			// Free node offsets per level, level 0 being whole block
+			std::vector<std::set<VkDeviceSize>> freeNodes;
+			VkDeviceSize bytesAllocated = 0;
+			uint32_t allocationCount = 0;
+		};
+
+		struct Pool
+		{
+			uint32_t memoryType = 0;
+			VkDeviceSize blockSize = 0;
+			std::vector<std::unique_ptr<Block>> blocks;
+		};
+
+		bool TryAllocateFromBlock(Block& block, VkDeviceSize blockSize, uint32_t level, VkDeviceSize& offset);
+		void FreeToBlock(Block& block, VkDeviceSize blockSize, VkDeviceSize offset, uint32_t level);
+		VkDeviceMemory AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, uint8_t*& mappedData);
+		void FreeDeviceMemory(VkDeviceMemory memory);
+		uint32_t PoolIndex(uint32_t memoryType, ResourceKind kind) const;
+		static uint32_t LevelCount(VkDeviceSize blockSize);
+		static VkDeviceSize NextPowerOfTwo(VkDeviceSize value);
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		VkPhysicalDeviceMemoryProperties mMemoryProperties = {};
+		VkDeviceSize mBufferImageGranularity = 1;
+		uint32_t mMaxAllocationCount = 0;
+
+		mutable std::mutex mMutex;
+		std::vector<Pool> mPools;
+		std::set<VkDeviceMemory> mDedicatedMemory;
+		VkDeviceSize mDedicatedBytes = 0;
+		uint32_t mDeviceMemoryCount = 0;
+	};
+}
@@ -6,8 +6,6 @@ namespace AlphonsoGraphicsEngine
 	const float FirstPersonCamera::DefaultRotationRate = radians(30.0f);
 	const float FirstPersonCamera::DefaultMovementRate = 2.0f;
 	const float FirstPersonCamera::DefaultMouseSensitivity = 9.0f;
-	float FirstPersonCamera::deltaTime = 0.0f;
-	float FirstPersonCamera::lastFrame = 0.0f;
 
 	FirstPersonCamera::FirstPersonCamera(RendererC& renderer) :
 		Camera(renderer), mWindow(renderer.Window()),
@@ -45,39 +43,42 @@ namespace AlphonsoGraphicsEngine
 		glfwGetCursorPos(mWindow, &mLastCursorX, &mLastCursorY);
 	}
 
+	void FirstPersonCamera::SetInput(const InputState& input)
+	{
+		mInput = input;
+	}
+
 	void FirstPersonCamera::Update(const GameTime& gameTime)
 	{
-		float currentFrame = static_cast<float>(glfwGetTime());
-		deltaTime = currentFrame - lastFrame;
-		lastFrame = currentFrame;
+		float deltaTime = gameTime.ElapsedGameTimeSeconds().count();
 
 		vec2 movementAmount = vec2(0.0f, 0.0f);
-		if (glfwGetKey(mWindow, GLFW_KEY_W))
+		if (mInput.IsKeyDown(GLFW_KEY_W))
 		{
 			movementAmount.y = 1.0f;
 		}
 
-		if (glfwGetKey(mWindow, GLFW_KEY_S))
+		if (mInput.IsKeyDown(GLFW_KEY_S))
 		{
 			movementAmount.y = -1.0f;
 		}
 
-		if (glfwGetKey(mWindow, GLFW_KEY_A))
+		if (mInput.IsKeyDown(GLFW_KEY_A))
 		{
 			movementAmount.x = -1.0f;
 		}
 
-		if (glfwGetKey(mWindow, GLFW_KEY_D))
+		if (mInput.IsKeyDown(GLFW_KEY_D))
 		{
 			movementAmount.x = 1.0f;
 		}
 		
 		vec2 rotationAmount = vec2(0.0f, 0.0f);
 
-		double x, y;
-		glfwGetCursorPos(mWindow, &x, &y);
+		double x = mInput.CursorX();
+		double y = mInput.CursorY();
 
-		if (glfwGetMouseButton(mWindow, GLFW_MOUSE_BUTTON_LEFT))
+		if (mInput.IsMouseButtonDown(GLFW_MOUSE_BUTTON_LEFT))
 		{
 			rotationAmount.x = static_cast<float>(mLastCursorX - x) * mMouseSensitivity;
 			rotationAmount.y = static_cast<float>(mLastCursorY - y) * mMouseSensitivity;
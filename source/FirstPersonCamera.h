@@ -1,5 +1,6 @@
 #pragma once
 #include "Camera.h"
+#include "InputState.h"
 
 namespace AlphonsoGraphicsEngine
 {
@@ -21,11 +22,13 @@ namespace AlphonsoGraphicsEngine
 		virtual void Initialize() override;
 		virtual void Update(const GameTime& gameTime) override;
 
+		/// <summary>Sets input consumed by next Update().</summary>
+		/// <param name="input">Input sampled on main thread.</param>
+		void SetInput(const InputState& input);
+
 		static const float DefaultMouseSensitivity;
 		static const float DefaultRotationRate;
 		static const float DefaultMovementRate;
-		static float deltaTime;			// Time between current frame and last frame
-		static float lastFrame;			// Time of last frame
 
 	protected:
 		float mMouseSensitivity;
@@ -36,5 +39,6 @@ namespace AlphonsoGraphicsEngine
 		double mLastCursorX;
 		double mLastCursorY;
 		GLFWwindow* mWindow;
+		InputState mInput;
 	};
 }
\ No newline at end of file
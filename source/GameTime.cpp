@@ -14,22 +14,22 @@ namespace AlphonsoGraphicsEngine
 		mCurrentTime = currentTime;
 	}
 
-	const milliseconds& GameTime::TotalGameTime() const
+	const high_resolution_clock::duration& GameTime::TotalGameTime() const
 	{
 		return mTotalGameTime;
 	}
 
-	void GameTime::SetTotalGameTime(const milliseconds& totalGameTime)
+	void GameTime::SetTotalGameTime(const high_resolution_clock::duration& totalGameTime)
 	{
 		mTotalGameTime = totalGameTime;
 	}
 
-	const milliseconds& GameTime::ElapsedGameTime() const
+	const high_resolution_clock::duration& GameTime::ElapsedGameTime() const
 	{
 		return mElapsedGameTime;
 	}
 
-	void GameTime::SetElapsedGameTime(const milliseconds& elapsedGameTime)
+	void GameTime::SetElapsedGameTime(const high_resolution_clock::duration& elapsedGameTime)
 	{
 		mElapsedGameTime = elapsedGameTime;
 	}
@@ -0,0 +1,220 @@
+#include "GeometryPool.h"
+#include <stdexcept>
+#include <iterator>
+
+namespace AlphonsoGraphicsEngine
+{
+	const uint32_t GeometryPool::RangeAllocator::InvalidOffset = UINT32_MAX;
+
+	void GeometryPool::Initialize(VkDevice device, DeviceMemoryAllocator& allocator, UploadManager& uploadManager, uint32_t vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity)
+	{
+		mDevice = device;
+		mAllocator = &allocator;
+		mUploadManager = &uploadManager;
+		mVertexStride = vertexStride;
+
+		CreateBuffer(static_cast<VkDeviceSize>(vertexStride) * vertexCapacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, mVertexBuffer, mVertexAllocation);
+		CreateBuffer(static_cast<VkDeviceSize>(sizeof(uint32_t)) * indexCapacity, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, mIndexBuffer, mIndexAllocation);
+
+		mVertexRanges.Reset(vertexCapacity);
+		mIndexRanges.Reset(indexCapacity);
+	}
+
+	void GeometryPool::Shutdown()
+	{
+		vkDestroyBuffer(mDevice, mIndexBuffer, nullptr);
+		mAllocator->Free(mIndexAllocation);
+		vkDestroyBuffer(mDevice, mVertexBuffer, nullptr);
+		mAllocator->Free(mVertexAllocation);
+		mIndexBuffer = VK_NULL_HANDLE;
+		mVertexBuffer = VK_NULL_HANDLE;
+
+		mVertexRanges.Reset(0);
+		mIndexRanges.Reset(0);
+	}
+
+	GeometryPool::MeshHandle GeometryPool::AddMesh(const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount)
+	{
+		uint32_t vertexOffset = mVertexRanges.Allocate(vertexCount);
+		if (vertexOffset == RangeAllocator::InvalidOffset)
+		{
+			throw std::runtime_error("failed to allocate vertices from geometry pool!");
+		}
+
+		// Indices are relative to mesh's first vertex, so any mesh with few enough vertices fits in 16 bits
+		bool shortIndices = vertexCount <= 65536;
+		uint32_t indexSize = static_cast<uint32_t>(shortIndices ? sizeof(uint16_t) : sizeof(uint32_t));
+
+		// Index ranges are allocated in 32 bit units, two 16 bit indices each
+		uint32_t indexElements = shortIndices ? (indexCount + 1) / 2 : indexCount;
+		uint32_t firstElement = mIndexRanges.Allocate(indexElements);
+		if (firstElement == RangeAllocator::InvalidOffset)
+		{
+			mVertexRanges.Free(vertexOffset, vertexCount);
+			throw std::runtime_error("failed to allocate indices from geometry pool!");
+		}
+
+		VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(mVertexStride) * vertexCount;
+		mUploadManager->UploadBuffer(vertices, vertexBytes, mVertexBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+			static_cast<VkDeviceSize>(mVertexStride) * vertexOffset);
+
+		VkDeviceSize indexBytes = static_cast<VkDeviceSize>(indexSize) * indexCount;
+		VkDeviceSize indexOffset = static_cast<VkDeviceSize>(sizeof(uint32_t)) * firstElement;
+		if (shortIndices)
+		{
+			UploadManager::StagingRegion staging = mUploadManager->ReserveStaging(indexBytes);
+			uint16_t* shortIndexData = static_cast<uint16_t*>(staging.data);
+			for (uint32_t i = 0; i < indexCount; ++i)
+			{
+				shortIndexData[i] = static_cast<uint16_t>(indices[i]);
+			}
+			mUploadManager->UploadBuffer(staging, mIndexBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT, indexOffset);
+		}
+		else
+		{
+			mUploadManager->UploadBuffer(indices, indexBytes, mIndexBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT, indexOffset);
+		}
+
+		MeshHandle mesh;
+		mesh.firstIndex = shortIndices ? firstElement * 2 : firstElement;
+		mesh.indexCount = indexCount;
+		mesh.vertexOffset = static_cast<int32_t>(vertexOffset);
+		mesh.vertexCount = vertexCount;
+		mesh.indexType = shortIndices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+		return mesh;
+	}
+
+	void GeometryPool::RemoveMesh(MeshHandle& mesh)
+	{
+		mVertexRanges.Free(static_cast<uint32_t>(mesh.vertexOffset), mesh.vertexCount);
+		if (mesh.indexType == VK_INDEX_TYPE_UINT16)
+		{
+			mIndexRanges.Free(mesh.firstIndex / 2, (mesh.indexCount + 1) / 2);
+		}
+		else
+		{
+			mIndexRanges.Free(mesh.firstIndex, mesh.indexCount);
+		}
+		mesh = MeshHandle();
+	}
+
+	void GeometryPool::Bind(VkCommandBuffer commandBuffer, VkIndexType indexType) const
+	{
+		VkDeviceSize offset = 0;
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &mVertexBuffer, &offset);
+		vkCmdBindIndexBuffer(commandBuffer, mIndexBuffer, 0, indexType);
+	}
+
+	void GeometryPool::BindIndexType(VkCommandBuffer commandBuffer, const MeshHandle& mesh, VkIndexType& boundIndexType) const
+	{
+		if (mesh.indexType != boundIndexType)
+		{
+			vkCmdBindIndexBuffer(commandBuffer, mIndexBuffer, 0, mesh.indexType);
+			boundIndexType = mesh.indexType;
+		}
+	}
+
+	VkBuffer GeometryPool::VertexBuffer() const
+	{
+		return mVertexBuffer;
+	}
+
+	VkBuffer GeometryPool::IndexBuffer() const
+	{
+		return mIndexBuffer;
+	}
+
+	uint32_t GeometryPool::VerticesInUse() const
+	{
+		return mVertexRanges.InUse();
+	}
+
+	uint32_t GeometryPool::IndicesInUse() const
+	{
+		return mIndexRanges.InUse();
+	}
+
+	void GeometryPool::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, DeviceMemoryAllocator::Allocation& allocation)
+	{
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (vkCreateBuffer(mDevice, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create geometry pool buffer!");
+		}
+
+		allocation = mAllocator->AllocateForBuffer(buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	}
+
+	void GeometryPool::RangeAllocator::Reset(uint32_t capacity)
+	{
+		mFreeRanges.clear();
+		if (capacity > 0)
+		{
+			mFreeRanges[0] = capacity;
+		}
+		mInUse = 0;
+	}
+
+	uint32_t GeometryPool::RangeAllocator::Allocate(uint32_t count)
+	{
+		for (auto it = mFreeRanges.begin(); it != mFreeRanges.end(); ++it)
+		{
+			if (it->second < count)
+			{
+				continue;
+			}
+
+			uint32_t offset = it->first;
+			uint32_t remaining = it->second - count;
+			mFreeRanges.erase(it);
+			if (remaining > 0)
+			{
+				mFreeRanges[offset + count] = remaining;
+			}
+			mInUse += count;
+			return offset;
+		}
+		return InvalidOffset;
+	}
+
+	void GeometryPool::RangeAllocator::Free(uint32_t offset, uint32_t count)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+		mInUse -= count;
+
+		auto next = mFreeRanges.lower_bound(offset);
+
+		// Merge with following free range
+		if (next != mFreeRanges.end() && offset + count == next->first)
+		{
+			count += next->second;
+			next = mFreeRanges.erase(next);
+		}
+
+		// Merge with preceding free range
+		if (next != mFreeRanges.begin())
+		{
+			auto previous = std::prev(next);
+			if (previous->first + previous->second == offset)
+			{
+				previous->second += count;
+				return;
+			}
+		}
+
+		mFreeRanges[offset] = count;
+	}
+
+	uint32_t GeometryPool::RangeAllocator::InUse() const
+	{
+		return mInUse;
+	}
+}
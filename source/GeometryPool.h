@@ -0,0 +1,109 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <map>
+#include "DeviceMemoryAllocator.h"
+#include "UploadManager.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Single vertex buffer & single index buffer every mesh is sub-allocated from.
+	/// Both are bound once per pass; meshes only differ in draw offsets, which is what multi-draw indirect needs.
+	/// Meshes with at most 65536 vertices store 16 bit indices, so index buffer only has to be rebound when index type changes.
+	/// </summary>
+	class GeometryPool final
+	{
+	public:
+		/// <summary>Range of pool a mesh occupies. Fields map directly onto vkCmdDrawIndexed arguments.</summary>
+		struct MeshHandle
+		{
+			// In units of indexType, so relative to index buffer bound with that type
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+			int32_t vertexOffset = 0;
+			uint32_t vertexCount = 0;
+			VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+		};
+
+		GeometryPool() = default;
+		GeometryPool(const GeometryPool&) = delete;
+		GeometryPool& operator=(const GeometryPool&) = delete;
+		GeometryPool(GeometryPool&&) = delete;
+		GeometryPool& operator=(GeometryPool&&) = delete;
+		~GeometryPool() = default;
+
+		/// <summary>Creates device local vertex & index buffers.</summary>
+		/// <param name="device">Logical device.</param>
+		/// <param name="allocator">Allocator buffer memory is taken from.</param>
+		/// <param name="uploadManager">Upload manager mesh data is copied through.</param>
+		/// <param name="vertexStride">Size of one vertex in bytes.</param>
+		/// <param name="vertexCapacity">Number of vertices pool can hold.</param>
+		/// <param name="indexCapacity">Number of 32 bit indices pool can hold, or twice as many 16 bit ones.</param>
+		void Initialize(VkDevice device, DeviceMemoryAllocator& allocator, UploadManager& uploadManager, uint32_t vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity);
+
+		/// <summary>Destroys both buffers. GPU must be done reading from them.</summary>
+		void Shutdown();
+
+		/// <summary>Sub-allocates mesh & queues upload of its data. Indices are relative to mesh's first vertex.</summary>
+		/// <param name="vertices">Vertex data, vertexCount * vertexStride bytes.</param>
+		/// <param name="vertexCount">Number of vertices.</param>
+		/// <param name="indices">Index data.</param>
+		/// <param name="indexCount">Number of indices.</param>
+		/// <returns>Handle of mesh.</returns>
+		MeshHandle AddMesh(const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+
+		/// <summary>Returns mesh's ranges to pool. GPU must be done drawing it.</summary>
+		void RemoveMesh(MeshHandle& mesh);
+
+		/// <summary>Binds vertex buffer to binding 0 & index buffer.</summary>
+		/// <param name="commandBuffer">Command buffer to record into.</param>
+		/// <param name="indexType">Index type of first mesh drawn.</param>
+		void Bind(VkCommandBuffer commandBuffer, VkIndexType indexType = VK_INDEX_TYPE_UINT32) const;
+
+		/// <summary>Rebinds index buffer when mesh's index type differs from bound one.</summary>
+		/// <param name="commandBuffer">Command buffer to record into.</param>
+		/// <param name="mesh">Mesh about to be drawn.</param>
+		/// <param name="boundIndexType">Index type currently bound, updated on rebind.</param>
+		void BindIndexType(VkCommandBuffer commandBuffer, const MeshHandle& mesh, VkIndexType& boundIndexType) const;
+
+		VkBuffer VertexBuffer() const;
+		VkBuffer IndexBuffer() const;
+		uint32_t VerticesInUse() const;
+		/// <summary>Gets used space of index buffer, in 32 bit indices.</summary>
+		uint32_t IndicesInUse() const;
+
+	private:
+		/// <summary>First-fit allocator of element ranges, coalescing neighbouring free ranges.</summary>
+		class RangeAllocator final
+		{
+		public:
+			static const uint32_t InvalidOffset;
+
+			void Reset(uint32_t capacity);
+			uint32_t Allocate(uint32_t count);
+			void Free(uint32_t offset, uint32_t count);
+			uint32_t InUse() const;
+
+		private:
+			// Free ranges keyed by first element, mapped to element count
+			std::map<uint32_t, uint32_t> mFreeRanges;
+			uint32_t mInUse = 0;
+		};
+
+		void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, DeviceMemoryAllocator::Allocation& allocation);
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		DeviceMemoryAllocator* mAllocator = nullptr;
+		UploadManager* mUploadManager = nullptr;
+		uint32_t mVertexStride = 0;
+
+		VkBuffer mVertexBuffer = VK_NULL_HANDLE;
+		DeviceMemoryAllocator::Allocation mVertexAllocation;
+		VkBuffer mIndexBuffer = VK_NULL_HANDLE;
+		DeviceMemoryAllocator::Allocation mIndexAllocation;
+
+		RangeAllocator mVertexRanges;
+		RangeAllocator mIndexRanges;
+	};
+}
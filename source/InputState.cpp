@@ -0,0 +1,40 @@
+#include "InputState.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	void InputState::Sample(GLFWwindow* window)
+	{
+		// GLFW_KEY_SPACE is lowest valid key code
+		for (int key = GLFW_KEY_SPACE; key <= GLFW_KEY_LAST; ++key)
+		{
+			mKeys[key] = glfwGetKey(window, key) == GLFW_PRESS;
+		}
+
+		for (int button = 0; button <= GLFW_MOUSE_BUTTON_LAST; ++button)
+		{
+			mMouseButtons[button] = glfwGetMouseButton(window, button) == GLFW_PRESS;
+		}
+
+		glfwGetCursorPos(window, &mCursorX, &mCursorY);
+	}
+
+	bool InputState::IsKeyDown(int key) const
+	{
+		return key >= 0 && key <= GLFW_KEY_LAST && mKeys[key];
+	}
+
+	bool InputState::IsMouseButtonDown(int button) const
+	{
+		return button >= 0 && button <= GLFW_MOUSE_BUTTON_LAST && mMouseButtons[button];
+	}
+
+	double InputState::CursorX() const
+	{
+		return mCursorX;
+	}
+
+	double InputState::CursorY() const
+	{
+		return mCursorY;
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <GLFW/glfw3.h>
+#include <array>
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Copy of keyboard & mouse state sampled on main thread.
+	/// GLFW input may only be queried from main thread, so simulation reads this copy instead.
+	/// </summary>
+	class InputState final
+	{
+	public:
+		/// <summary>Samples every key, mouse button & cursor position of window. Main thread only.</summary>
+		/// <param name="window">Window to sample.</param>
+		void Sample(GLFWwindow* window);
+
+		bool IsKeyDown(int key) const;
+		bool IsMouseButtonDown(int button) const;
+		double CursorX() const;
+		double CursorY() const;
+
+	private:
+		std::array<bool, GLFW_KEY_LAST + 1> mKeys = {};
+		std::array<bool, GLFW_MOUSE_BUTTON_LAST + 1> mMouseButtons = {};
+		double mCursorX = 0.0;
+		double mCursorY = 0.0;
+	};
+}
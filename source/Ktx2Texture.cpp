@@ -0,0 +1,278 @@
+#include "Ktx2Texture.h"
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <algorithm>
+#include "TextureCompressor.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	// "«KTX 20»\r\n\x1A\n"
+	const uint8_t Ktx2Texture::Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+	const char* const Ktx2Texture::SourceKey = "AlphonsoSource";
+
+	bool Ktx2Texture::Load(const uint8_t* data, size_t size)
+	{
+		mData = nullptr;
+		mHeader = nullptr;
+		mLevels = nullptr;
+		mHasSource = false;
+
+		if (data == nullptr || size < sizeof(Header))
+		{
+			return false;
+		}
+
+		const Header* header = reinterpret_cast<const Header*>(data);
+		if (memcmp(header->identifier, Identifier, sizeof(Identifier)) != 0
+			|| header->pixelWidth == 0 || header->pixelHeight == 0 || header->pixelDepth != 0 || header->layerCount > 1 || header->faceCount != 1
+			|| header->levelCount == 0 || header->supercompressionScheme != 0
+			|| sizeof(Header) + static_cast<uint64_t>(header->levelCount) * sizeof(LevelIndex) > size
+			|| static_cast<uint64_t>(header->kvdByteOffset) + header->kvdByteLength > size)
+		{
+			return false;
+		}
+
+		const LevelIndex* levels = reinterpret_cast<const LevelIndex*>(data + sizeof(Header));
+		for (uint32_t level = 0; level < header->levelCount; ++level)
+		{
+			if (levels[level].byteOffset + levels[level].byteLength > size)
+			{
+				return false;
+			}
+		}
+
+		// Key/value entries: length, null terminated key, value, padding to 4 bytes
+		const uint8_t* entry = data + header->kvdByteOffset;
+		const uint8_t* entriesEnd = entry + header->kvdByteLength;
+		while (entry + sizeof(uint32_t) <= entriesEnd)
+		{
+			uint32_t length;
+			memcpy(&length, entry, sizeof(length));
+			const uint8_t* key = entry + sizeof(uint32_t);
+			if (length > static_cast<size_t>(entriesEnd - key))
+			{
+				break;
+			}
+
+			size_t keyLength = strlen(SourceKey) + 1;
+			if (length == keyLength + sizeof(SourceFingerprint) && memcmp(key, SourceKey, keyLength) == 0)
+			{
+				memcpy(&mSource, key + keyLength, sizeof(SourceFingerprint));
+				mHasSource = true;
+			}
+			entry = key + ((static_cast<size_t>(length) + 3) & ~static_cast<size_t>(3));
+		}
+
+		mData = data;
+		mHeader = header;
+		mLevels = levels;
+		return true;
+	}
+
+	bool Ktx2Texture::Write(const std::string& path, VkFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels, const SourceFingerprint& source)
+	{
+		bool compressed = format != VK_FORMAT_R8G8B8A8_UNORM;
+
+		Header header = {};
+		memcpy(header.identifier, Identifier, sizeof(Identifier));
+		header.vkFormat = static_cast<uint32_t>(format);
+		header.typeSize = 1;
+		header.pixelWidth = width;
+		header.pixelHeight = height;
+		header.faceCount = 1;
+		header.levelCount = static_cast<uint32_t>(levels.size());
+
+		std::vector<uint32_t> dataFormatDescriptor = BuildDataFormatDescriptor(format);
+		header.dfdByteOffset = static_cast<uint32_t>(sizeof(Header) + levels.size() * sizeof(LevelIndex));
+		header.dfdByteLength = static_cast<uint32_t>(dataFormatDescriptor.size() * sizeof(uint32_t));
+
+		// Entries sorted by key
+		std::vector<uint8_t> keyValueData;
+		auto addEntry = [&keyValueData](const char* key, const void* value, size_t valueSize)
+		{
+			uint32_t length = static_cast<uint32_t>(strlen(key) + 1 + valueSize);
+			const uint8_t* lengthBytes = reinterpret_cast<const uint8_t*>(&length);
+			keyValueData.insert(keyValueData.end(), lengthBytes, lengthBytes + sizeof(length));
+			keyValueData.insert(keyValueData.end(), key, key + strlen(key) + 1);
+			keyValueData.insert(keyValueData.end(), static_cast<const uint8_t*>(value), static_cast<const uint8_t*>(value) + valueSize);
+			keyValueData.resize((keyValueData.size() + 3) & ~static_cast<size_t>(3), 0);
+		};
+		const char writer[] = "Alphonso Graphics Engine";
+		addEntry(SourceKey, &source, sizeof(source));
+		addEntry("KTXwriter", writer, sizeof(writer));
+		header.kvdByteOffset = header.dfdByteOffset + header.dfdByteLength;
+		header.kvdByteLength = static_cast<uint32_t>(keyValueData.size());
+
+		// Levels are stored smallest first, each aligned to least common multiple of texel block size & 4
+		uint64_t levelAlignment = compressed ? TextureCompressor::BlockSize(format) : 4;
+		std::vector<LevelIndex> levelIndex(levels.size());
+		uint64_t offset = header.kvdByteOffset + header.kvdByteLength;
+		for (size_t level = levels.size(); level-- > 0;)
+		{
+			offset = (offset + levelAlignment - 1) & ~(levelAlignment - 1);
+			levelIndex[level].byteOffset = offset;
+			levelIndex[level].byteLength = levels[level].size();
+			levelIndex[level].uncompressedByteLength = levels[level].size();
+			offset += levels[level].size();
+		}
+
+		std::string temporaryPath = path + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!file)
+			{
+				return false;
+			}
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(levelIndex.data()), static_cast<std::streamsize>(levelIndex.size() * sizeof(LevelIndex)));
+			file.write(reinterpret_cast<const char*>(dataFormatDescriptor.data()), static_cast<std::streamsize>(header.dfdByteLength));
+			file.write(reinterpret_cast<const char*>(keyValueData.data()), static_cast<std::streamsize>(keyValueData.size()));
+
+			uint64_t written = header.kvdByteOffset + header.kvdByteLength;
+			const char padding[16] = {};
+			for (size_t level = levels.size(); level-- > 0;)
+			{
+				file.write(padding, static_cast<std::streamsize>(levelIndex[level].byteOffset - written));
+				file.write(reinterpret_cast<const char*>(levels[level].data()), static_cast<std::streamsize>(levels[level].size()));
+				written = levelIndex[level].byteOffset + levels[level].size();
+			}
+
+			if (!file)
+			{
+				file.close();
+				std::error_code error;
+				std::filesystem::remove(temporaryPath, error);
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, path, error);
+		if (error)
+		{
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	std::string Ktx2Texture::CachePath(const std::string& sourcePath)
+	{
+		return sourcePath + ".ktx2";
+	}
+
+	VkFormat Ktx2Texture::Format() const
+	{
+		return static_cast<VkFormat>(mHeader->vkFormat);
+	}
+
+	uint32_t Ktx2Texture::Width() const
+	{
+		return mHeader->pixelWidth;
+	}
+
+	uint32_t Ktx2Texture::Height() const
+	{
+		return mHeader->pixelHeight;
+	}
+
+	uint32_t Ktx2Texture::MipLevels() const
+	{
+		return mHeader->levelCount;
+	}
+
+	const uint8_t* Ktx2Texture::LevelData(uint32_t level) const
+	{
+		return mData + mLevels[level].byteOffset;
+	}
+
+	size_t Ktx2Texture::LevelSize(uint32_t level) const
+	{
+		return static_cast<size_t>(mLevels[level].byteLength);
+	}
+
+	const SourceFingerprint* Ktx2Texture::Source() const
+	{
+		return mHasSource ? &mSource : nullptr;
+	}
+
+	std::vector<uint32_t> Ktx2Texture::BuildDataFormatDescriptor(VkFormat format)
+	{
+		// Khronos Data Format basic descriptor block: colour model & one sample per channel
+		struct Sample
+		{
+			uint32_t bitOffset;
+			uint32_t bitLength;
+			uint32_t channel;
+		};
+
+		uint32_t colorModel;
+		uint32_t blockExtent = 4;
+		uint32_t bytesPerBlock = 16;
+		uint32_t upper = 0xFFFFFFFF;
+		std::vector<Sample> samples;
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			colorModel = 128;
+			bytesPerBlock = 8;
+			samples = { { 0, 64, 0 } };
+			break;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			colorModel = 130;
+			samples = { { 0, 64, 15 }, { 64, 64, 0 } };
+			break;
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+			colorModel = 131;
+			bytesPerBlock = 8;
+			samples = { { 0, 64, 0 } };
+			break;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+			colorModel = 132;
+			samples = { { 0, 64, 0 }, { 64, 64, 1 } };
+			break;
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			colorModel = 134;
+			samples = { { 0, 128, 0 } };
+			break;
+		default:
+			// RGBA8, RGBSDA model
+			colorModel = 1;
+			blockExtent = 1;
+			bytesPerBlock = 4;
+			upper = 255;
+			samples = { { 0, 8, 0 }, { 8, 8, 1 }, { 16, 8, 2 }, { 24, 8, 15 } };
+			break;
+		}
+
+		bool srgb = format == VK_FORMAT_BC1_RGB_SRGB_BLOCK || format == VK_FORMAT_BC3_SRGB_BLOCK || format == VK_FORMAT_BC7_SRGB_BLOCK;
+		uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+
+		std::vector<uint32_t> words;
+		words.push_back(4 + blockSize);
+		// Khronos vendor, basic descriptor type
+		words.push_back(0);
+		// Version 1.3 of specification, block size
+		words.push_back(2 | (blockSize << 16));
+		// Colour model, BT.709 primaries, linear or sRGB transfer, straight alpha
+		words.push_back(colorModel | (1 << 8) | ((srgb ? 2u : 1u) << 16));
+		words.push_back((blockExtent - 1) | ((blockExtent - 1) << 8));
+		words.push_back(bytesPerBlock);
+		words.push_back(0);
+		for (const Sample& sample : samples)
+		{
+			// Alpha is flagged linear even in sRGB images
+			uint32_t qualifiers = srgb && sample.channel == 15 ? 0x10 : 0;
+			words.push_back(sample.bitOffset | ((sample.bitLength - 1) << 16) | ((sample.channel | qualifiers) << 24));
+			words.push_back(0);
+			words.push_back(0);
+			words.push_back(upper);
+		}
+		return words;
+	}
+}
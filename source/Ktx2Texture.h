@@ -0,0 +1,96 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "SourceFingerprint.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Reader & writer of single 2D images in KTX2 container, uncompressed by any supercompression scheme.
+	/// Cooked textures store fingerprint of their source image under key "AlphonsoSource", so a stale one is recooked.
+	/// Levels are read straight from memory texture was loaded from, e.g. a span of asset pack.
+	/// </summary>
+	class Ktx2Texture final
+	{
+	public:
+		Ktx2Texture() = default;
+		Ktx2Texture(const Ktx2Texture&) = delete;
+		Ktx2Texture& operator=(const Ktx2Texture&) = delete;
+		Ktx2Texture(Ktx2Texture&&) = delete;
+		Ktx2Texture& operator=(Ktx2Texture&&) = delete;
+		~Ktx2Texture() = default;
+
+		/// <summary>Validates header & level index of a texture already in memory. Data must outlive texture.</summary>
+		/// <param name="data">Contents of KTX2 file.</param>
+		/// <param name="size">Size of contents.</param>
+		/// <returns>False if data is truncated, isn't a 2D KTX2 image or is supercompressed.</returns>
+		bool Load(const uint8_t* data, size_t size);
+
+		/// <summary>
+		/// Writes texture. File is written to a temporary file & renamed, so readers never see half of it.
+		/// </summary>
+		/// <param name="path">Path of KTX2 file.</param>
+		/// <param name="format">Format of level data, either a BCn format or VK_FORMAT_R8G8B8A8_UNORM.</param>
+		/// <param name="width">Width of level 0.</param>
+		/// <param name="height">Height of level 0.</param>
+		/// <param name="levels">Data of every level, largest first.</param>
+		/// <param name="source">Fingerprint of source image.</param>
+		/// <returns>False if file couldn't be written.</returns>
+		static bool Write(const std::string& path, VkFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels, const SourceFingerprint& source);
+
+		/// <summary>Gets name textures cooked from a source image are stored under, works for paths & asset names alike.</summary>
+		static std::string CachePath(const std::string& sourcePath);
+
+		VkFormat Format() const;
+		uint32_t Width() const;
+		uint32_t Height() const;
+		uint32_t MipLevels() const;
+		const uint8_t* LevelData(uint32_t level) const;
+		size_t LevelSize(uint32_t level) const;
+
+		/// <summary>Gets fingerprint of source image, or nullptr if texture wasn't cooked by engine.</summary>
+		const SourceFingerprint* Source() const;
+
+	private:
+		struct Header
+		{
+			uint8_t identifier[12];
+			uint32_t vkFormat;
+			uint32_t typeSize;
+			uint32_t pixelWidth;
+			uint32_t pixelHeight;
+			uint32_t pixelDepth;
+			uint32_t layerCount;
+			uint32_t faceCount;
+			uint32_t levelCount;
+			uint32_t supercompressionScheme;
+			uint32_t dfdByteOffset;
+			uint32_t dfdByteLength;
+			uint32_t kvdByteOffset;
+			uint32_t kvdByteLength;
+			uint64_t sgdByteOffset;
+			uint64_t sgdByteLength;
+		};
+
+		struct LevelIndex
+		{
+			uint64_t byteOffset;
+			uint64_t byteLength;
+			uint64_t uncompressedByteLength;
+		};
+
+		static std::vector<uint32_t> BuildDataFormatDescriptor(VkFormat format);
+
+		static const uint8_t Identifier[12];
+		static const char* const SourceKey;
+
+		const uint8_t* mData = nullptr;
+		const Header* mHeader = nullptr;
+		const LevelIndex* mLevels = nullptr;
+		SourceFingerprint mSource;
+		bool mHasSource = false;
+	};
+}
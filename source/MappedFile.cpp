@@ -0,0 +1,141 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace AlphonsoGraphicsEngine
+{
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+#ifdef _WIN32
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		mFileHandle = file;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			Close();
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			Close();
+			return false;
+		}
+		mMappingHandle = mapping;
+
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (data == nullptr)
+		{
+			Close();
+			return false;
+		}
+
+		mData = static_cast<const uint8_t*>(data);
+		mSize = static_cast<size_t>(size.QuadPart);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (mData != nullptr)
+		{
+			UnmapViewOfFile(mData);
+		}
+		if (mMappingHandle != nullptr)
+		{
+			CloseHandle(mMappingHandle);
+		}
+		if (mFileHandle != nullptr)
+		{
+			CloseHandle(mFileHandle);
+		}
+
+		mData = nullptr;
+		mSize = 0;
+		mMappingHandle = nullptr;
+		mFileHandle = nullptr;
+	}
+#else
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+
+		mFileDescriptor = open(path.c_str(), O_RDONLY);
+		if (mFileDescriptor < 0)
+		{
+			return false;
+		}
+
+		struct stat fileStatus;
+		if (fstat(mFileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+		{
+			Close();
+			return false;
+		}
+
+		void* data = mmap(nullptr, static_cast<size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, mFileDescriptor, 0);
+		if (data == MAP_FAILED)
+		{
+			Close();
+			return false;
+		}
+
+		mData = static_cast<const uint8_t*>(data);
+		mSize = static_cast<size_t>(fileStatus.st_size);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (mData != nullptr)
+		{
+			munmap(const_cast<uint8_t*>(mData), mSize);
+		}
+		if (mFileDescriptor >= 0)
+		{
+			close(mFileDescriptor);
+		}
+
+		mData = nullptr;
+		mSize = 0;
+		mFileDescriptor = -1;
+	}
+#endif
+
+	bool MappedFile::IsOpen() const
+	{
+		return mData != nullptr;
+	}
+
+	const uint8_t* MappedFile::Data() const
+	{
+		return mData;
+	}
+
+	size_t MappedFile::Size() const
+	{
+		return mSize;
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Read-only memory mapping of a whole file. Pages are faulted in by OS on first access,
+	/// so opening a large file costs next to nothing until its contents are touched.
+	/// </summary>
+	class MappedFile final
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&&) = delete;
+		MappedFile& operator=(MappedFile&&) = delete;
+		~MappedFile();
+
+		/// <summary>Maps file into memory, closing previously mapped one.</summary>
+		/// <param name="path">Path of file.</param>
+		/// <returns>False if file doesn't exist, is empty or can't be mapped.</returns>
+		bool Open(const std::string& path);
+
+		/// <summary>Unmaps file. Pointers returned by Data() become invalid.</summary>
+		void Close();
+
+		bool IsOpen() const;
+		const uint8_t* Data() const;
+		size_t Size() const;
+
+	private:
+		const uint8_t* mData = nullptr;
+		size_t mSize = 0;
+
+#ifdef _WIN32
+		void* mFileHandle = nullptr;
+		void* mMappingHandle = nullptr;
+#else
+		int mFileDescriptor = -1;
+#endif
+	};
+}
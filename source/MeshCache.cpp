@@ -0,0 +1,129 @@
+#include "MeshCache.h"
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <vector>
+
+namespace AlphonsoGraphicsEngine
+{
+	// "AMSH"
+	const uint32_t MeshCache::Magic = 0x48534D41;
+	const uint32_t MeshCache::Version = 2;
+	const uint64_t MeshCache::StreamAlignment = 16;
+
+	bool MeshCache::Load(const uint8_t* data, size_t size, uint32_t vertexStride)
+	{
+		mData = nullptr;
+		mHeader = nullptr;
+
+		if (data == nullptr || size < sizeof(Header))
+		{
+			return false;
+		}
+
+		const Header* header = reinterpret_cast<const Header*>(data);
+		uint64_t vertexBytes = static_cast<uint64_t>(header->vertexCount) * header->vertexStride;
+		uint64_t indexBytes = static_cast<uint64_t>(header->indexCount) * sizeof(uint32_t);
+		if (header->magic != Magic || header->version != Version || header->vertexStride != vertexStride
+			|| header->vertexDataOffset + vertexBytes > size || header->indexDataOffset + indexBytes > size)
+		{
+			return false;
+		}
+
+		mData = data;
+		mHeader = header;
+		return true;
+	}
+
+	bool MeshCache::Write(const std::string& cachePath, const void* vertices, uint32_t vertexCount, uint32_t vertexStride, const uint32_t* indices, uint32_t indexCount,
+		const glm::vec3& boundsMin, const glm::vec3& boundsMax, const SourceFingerprint& source)
+	{
+		Header header = {};
+		header.magic = Magic;
+		header.version = Version;
+		header.vertexStride = vertexStride;
+		header.vertexCount = vertexCount;
+		header.indexCount = indexCount;
+		header.source = source;
+
+		memcpy(header.boundsMin, &boundsMin, sizeof(header.boundsMin));
+		memcpy(header.boundsMax, &boundsMax, sizeof(header.boundsMax));
+
+		uint64_t vertexBytes = static_cast<uint64_t>(vertexCount) * vertexStride;
+		uint64_t indexBytes = static_cast<uint64_t>(indexCount) * sizeof(uint32_t);
+		header.vertexDataOffset = (sizeof(Header) + StreamAlignment - 1) & ~(StreamAlignment - 1);
+		header.indexDataOffset = (header.vertexDataOffset + vertexBytes + StreamAlignment - 1) & ~(StreamAlignment - 1);
+
+		std::string temporaryPath = cachePath + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!file)
+			{
+				return false;
+			}
+
+			std::vector<char> padding(static_cast<size_t>(StreamAlignment), 0);
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(padding.data(), static_cast<std::streamsize>(header.vertexDataOffset - sizeof(header)));
+			file.write(static_cast<const char*>(vertices), static_cast<std::streamsize>(vertexBytes));
+			file.write(padding.data(), static_cast<std::streamsize>(header.indexDataOffset - header.vertexDataOffset - vertexBytes));
+			file.write(reinterpret_cast<const char*>(indices), static_cast<std::streamsize>(indexBytes));
+			if (!file)
+			{
+				file.close();
+				std::error_code error;
+				std::filesystem::remove(temporaryPath, error);
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, cachePath, error);
+		if (error)
+		{
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	std::string MeshCache::CachePath(const std::string& sourcePath)
+	{
+		return sourcePath + ".mesh";
+	}
+
+	const void* MeshCache::Vertices() const
+	{
+		return mData + mHeader->vertexDataOffset;
+	}
+
+	const SourceFingerprint& MeshCache::Source() const
+	{
+		return mHeader->source;
+	}
+
+	uint32_t MeshCache::VertexCount() const
+	{
+		return mHeader->vertexCount;
+	}
+
+	const uint32_t* MeshCache::Indices() const
+	{
+		return reinterpret_cast<const uint32_t*>(mData + mHeader->indexDataOffset);
+	}
+
+	uint32_t MeshCache::IndexCount() const
+	{
+		return mHeader->indexCount;
+	}
+
+	glm::vec3 MeshCache::BoundsMin() const
+	{
+		return glm::vec3(mHeader->boundsMin[0], mHeader->boundsMin[1], mHeader->boundsMin[2]);
+	}
+
+	glm::vec3 MeshCache::BoundsMax() const
+	{
+		return glm::vec3(mHeader->boundsMax[0], mHeader->boundsMax[1], mHeader->boundsMax[2]);
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <glm/glm.hpp>
+#include "SourceFingerprint.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Cooked binary form of a mesh, written next to its source model as "&lt;source&gt;.mesh".
+	/// Layout is a header, vertex stream & index stream, each stream 16 byte aligned, so a memory mapped
+	/// cache is handed to upload as is. Cache is stale once vertex layout, format version or source model changes;
+	/// caller compares source against Source(), as source may come from asset pack or a loose file.
+	/// </summary>
+	class MeshCache final
+	{
+	public:
+		MeshCache() = default;
+		MeshCache(const MeshCache&) = delete;
+		MeshCache& operator=(const MeshCache&) = delete;
+		MeshCache(MeshCache&&) = delete;
+		MeshCache& operator=(MeshCache&&) = delete;
+		~MeshCache() = default;
+
+		/// <summary>Validates a cache already in memory, e.g. a span of asset pack. Data must outlive cache.</summary>
+		/// <param name="data">Contents of cache.</param>
+		/// <param name="size">Size of contents.</param>
+		/// <param name="vertexStride">Size of one vertex expected by caller.</param>
+		/// <returns>False if cache is truncated or of another version or vertex layout, source must be parsed then.</returns>
+		bool Load(const uint8_t* data, size_t size, uint32_t vertexStride);
+
+		/// <summary>Writes cache of source model. Cache is written to a temporary file & renamed, so readers never see half of it.</summary>
+		/// <param name="cachePath">Path of cache.</param>
+		/// <param name="vertices">Vertex data, vertexCount * vertexStride bytes.</param>
+		/// <param name="vertexCount">Number of vertices.</param>
+		/// <param name="vertexStride">Size of one vertex.</param>
+		/// <param name="indices">Index data.</param>
+		/// <param name="indexCount">Number of indices.</param>
+		/// <param name="boundsMin">Minimum of source positions, also what quantised positions are relative to.</param>
+		/// <param name="boundsMax">Maximum of source positions.</param>
+		/// <param name="source">Fingerprint of source model.</param>
+		/// <returns>False if cache couldn't be written, e.g. in a read-only asset directory.</returns>
+		static bool Write(const std::string& cachePath, const void* vertices, uint32_t vertexCount, uint32_t vertexStride, const uint32_t* indices, uint32_t indexCount,
+			const glm::vec3& boundsMin, const glm::vec3& boundsMax, const SourceFingerprint& source);
+
+		/// <summary>Gets name caches of a source model are stored under, works for paths & asset names alike.</summary>
+		static std::string CachePath(const std::string& sourcePath);
+
+		/// <summary>Gets fingerprint of source model cache was cooked from.</summary>
+		const SourceFingerprint& Source() const;
+
+		const void* Vertices() const;
+		uint32_t VertexCount() const;
+		const uint32_t* Indices() const;
+		uint32_t IndexCount() const;
+		glm::vec3 BoundsMin() const;
+		glm::vec3 BoundsMax() const;
+
+	private:
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t vertexStride;
+			uint32_t vertexCount;
+			uint32_t indexCount;
+			uint32_t reserved;
+			SourceFingerprint source;
+			float boundsMin[3];
+			float boundsMax[3];
+			uint64_t vertexDataOffset;
+			uint64_t indexDataOffset;
+		};
+
+		static const uint32_t Magic;
+		static const uint32_t Version;
+		static const uint64_t StreamAlignment;
+
+		const uint8_t* mData = nullptr;
+		const Header* mHeader = nullptr;
+	};
+}
@@ -0,0 +1,305 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace AlphonsoGraphicsEngine
+{
+	std::vector<uint32_t> MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+	{
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		std::vector<uint32_t> clusters;
+		if (triangleCount == 0)
+		{
+			return clusters;
+		}
+
+		// Triangles using each vertex, as offsets into one flat list
+		std::vector<uint32_t> liveTriangles(vertexCount, 0);
+		for (uint32_t index : indices)
+		{
+			liveTriangles[index]++;
+		}
+
+		std::vector<uint32_t> adjacencyOffsets(static_cast<size_t>(vertexCount) + 1, 0);
+		for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+		{
+			adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + liveTriangles[vertex];
+		}
+
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32_t triangle = 0; triangle < triangleCount; ++triangle)
+		{
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				adjacency[fill[indices[triangle * 3 + corner]]++] = triangle;
+			}
+		}
+
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> deadEnd;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+
+		uint32_t timestamp = cacheSize + 1;
+		uint32_t nextInputVertex = 0;
+		uint32_t fanningVertex = 0;
+		bool jumped = true;
+
+		for (;;)
+		{
+			if (jumped)
+			{
+				clusters.push_back(static_cast<uint32_t>(output.size() / 3));
+				jumped = false;
+			}
+
+			// Emit every remaining triangle around fanning vertex
+			candidates.clear();
+			for (uint32_t i = adjacencyOffsets[fanningVertex]; i < adjacencyOffsets[fanningVertex + 1]; ++i)
+			{
+				uint32_t triangle = adjacency[i];
+				if (emitted[triangle])
+				{
+					continue;
+				}
+
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					uint32_t vertex = indices[triangle * 3 + corner];
+					output.push_back(vertex);
+					deadEnd.push_back(vertex);
+					candidates.push_back(vertex);
+					liveTriangles[vertex]--;
+					if (timestamp - cacheTimestamps[vertex] > cacheSize)
+					{
+						cacheTimestamps[vertex] = timestamp++;
+					}
+				}
+				emitted[triangle] = true;
+			}
+
+			// Next fanning vertex is the one which stays in cache longest while all its triangles are emitted
+			int64_t bestPriority = -1;
+			int64_t bestVertex = -1;
+			for (uint32_t vertex : candidates)
+			{
+				if (liveTriangles[vertex] == 0)
+				{
+					continue;
+				}
+
+				int64_t priority = 0;
+				int64_t age = static_cast<int64_t>(timestamp) - cacheTimestamps[vertex];
+				if (age + 2 * static_cast<int64_t>(liveTriangles[vertex]) <= cacheSize)
+				{
+					priority = age;
+				}
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					bestVertex = vertex;
+				}
+			}
+
+			if (bestVertex < 0)
+			{
+				// Dead end, fall back to a recently used vertex & then to input order. Either way next triangles
+				// share little with cache, so this is a hard boundary where clusters can be reordered for free.
+				jumped = true;
+				while (!deadEnd.empty() && bestVertex < 0)
+				{
+					uint32_t vertex = deadEnd.back();
+					deadEnd.pop_back();
+					if (liveTriangles[vertex] > 0)
+					{
+						bestVertex = vertex;
+					}
+				}
+
+				while (nextInputVertex < vertexCount && bestVertex < 0)
+				{
+					if (liveTriangles[nextInputVertex] > 0)
+					{
+						bestVertex = nextInputVertex;
+					}
+					++nextInputVertex;
+				}
+
+				if (bestVertex < 0)
+				{
+					break;
+				}
+			}
+
+			fanningVertex = static_cast<uint32_t>(bestVertex);
+		}
+
+		indices.swap(output);
+		return clusters;
+	}
+
+	void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<uint32_t>& clusters, const float* positions, size_t positionStride)
+	{
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		if (clusters.size() < 2)
+		{
+			return;
+		}
+
+		auto position = [positions, positionStride](uint32_t vertex, float* value)
+		{
+			memcpy(value, reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride, sizeof(float) * 3);
+		};
+
+		struct Cluster
+		{
+			uint32_t firstTriangle = 0;
+			uint32_t triangleCount = 0;
+			float centroid[3] = {};
+			float normal[3] = {};
+			float area = 0.0f;
+			float sortKey = 0.0f;
+		};
+
+		// Area weighted centroid & normal of each cluster
+		std::vector<Cluster> sortedClusters(clusters.size());
+		float meshCentroid[3] = {};
+		float meshArea = 0.0f;
+		for (size_t i = 0; i < clusters.size(); ++i)
+		{
+			Cluster& cluster = sortedClusters[i];
+			cluster.firstTriangle = clusters[i];
+			cluster.triangleCount = (i + 1 < clusters.size() ? clusters[i + 1] : triangleCount) - clusters[i];
+
+			for (uint32_t triangle = cluster.firstTriangle; triangle < cluster.firstTriangle + cluster.triangleCount; ++triangle)
+			{
+				float p0[3], p1[3], p2[3];
+				position(indices[triangle * 3 + 0], p0);
+				position(indices[triangle * 3 + 1], p1);
+				position(indices[triangle * 3 + 2], p2);
+
+				float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+				float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+				float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+				float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) * 0.5f;
+
+				for (uint32_t axis = 0; axis < 3; ++axis)
+				{
+					cluster.centroid[axis] += (p0[axis] + p1[axis] + p2[axis]) * (area / 3.0f);
+					cluster.normal[axis] += n[axis];
+				}
+				cluster.area += area;
+			}
+
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				meshCentroid[axis] += cluster.centroid[axis];
+			}
+			meshArea += cluster.area;
+
+			if (cluster.area > 0.0f)
+			{
+				for (uint32_t axis = 0; axis < 3; ++axis)
+				{
+					cluster.centroid[axis] /= cluster.area;
+				}
+			}
+		}
+
+		if (meshArea > 0.0f)
+		{
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				meshCentroid[axis] /= meshArea;
+			}
+		}
+
+		// How far cluster faces outward from mesh centre (Nehab, Barczak & Sander 2006)
+		for (Cluster& cluster : sortedClusters)
+		{
+			float length = std::sqrt(cluster.normal[0] * cluster.normal[0] + cluster.normal[1] * cluster.normal[1] + cluster.normal[2] * cluster.normal[2]);
+			if (length > 0.0f)
+			{
+				for (uint32_t axis = 0; axis < 3; ++axis)
+				{
+					cluster.sortKey += (cluster.centroid[axis] - meshCentroid[axis]) * cluster.normal[axis] / length;
+				}
+			}
+		}
+
+		std::stable_sort(sortedClusters.begin(), sortedClusters.end(), [](const Cluster& a, const Cluster& b)
+		{
+			return a.sortKey > b.sortKey;
+		});
+
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+		for (const Cluster& cluster : sortedClusters)
+		{
+			output.insert(output.end(), indices.begin() + cluster.firstTriangle * 3, indices.begin() + (cluster.firstTriangle + cluster.triangleCount) * 3);
+		}
+		indices.swap(output);
+	}
+
+	uint32_t MeshOptimizer::OptimizeVertexFetch(void* vertices, uint32_t vertexCount, uint32_t vertexStride, std::vector<uint32_t>& indices)
+	{
+		const uint32_t Unused = UINT32_MAX;
+		std::vector<uint32_t> remap(vertexCount, Unused);
+		uint32_t usedCount = 0;
+		for (uint32_t& index : indices)
+		{
+			if (remap[index] == Unused)
+			{
+				remap[index] = usedCount++;
+			}
+			index = remap[index];
+		}
+
+		uint8_t* vertexData = static_cast<uint8_t*>(vertices);
+		std::vector<uint8_t> reordered(static_cast<size_t>(usedCount) * vertexStride);
+		for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+		{
+			if (remap[vertex] != Unused)
+			{
+				memcpy(reordered.data() + static_cast<size_t>(remap[vertex]) * vertexStride, vertexData + static_cast<size_t>(vertex) * vertexStride, vertexStride);
+			}
+		}
+		memcpy(vertexData, reordered.data(), reordered.size());
+		return usedCount;
+	}
+
+	MeshOptimizer::CacheStatistics MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+	{
+		CacheStatistics statistics;
+		if (indices.empty())
+		{
+			return statistics;
+		}
+
+		// A vertex is in FIFO cache while fewer than cacheSize misses happened since it was loaded
+		std::vector<uint64_t> loadedAt(vertexCount, UINT64_MAX);
+		std::vector<bool> referenced(vertexCount, false);
+		uint64_t misses = 0;
+		uint32_t referencedCount = 0;
+		for (uint32_t index : indices)
+		{
+			if (loadedAt[index] == UINT64_MAX || misses - loadedAt[index] >= cacheSize)
+			{
+				loadedAt[index] = misses++;
+			}
+			if (!referenced[index])
+			{
+				referenced[index] = true;
+				referencedCount++;
+			}
+		}
+
+		statistics.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+		statistics.atvr = static_cast<float>(misses) / static_cast<float>(referencedCount);
+		return statistics;
+	}
+}
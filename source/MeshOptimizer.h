@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Reorders indexed triangle lists for GPU vertex processing: Tipsify triangle order for post-transform cache reuse,
+	/// cluster order against overdraw, & vertex order matching first use for fetch locality.
+	/// None of these change what is drawn, only the order it is drawn in.
+	/// </summary>
+	class MeshOptimizer final
+	{
+	public:
+		struct CacheStatistics
+		{
+			// Average cache miss ratio, transformed vertices per triangle. 0.5 is ideal for large regular meshes, 3 is worst.
+			float acmr = 0.0f;
+			// Average transform to vertex ratio, transformed vertices per referenced vertex. 1 is ideal.
+			float atvr = 0.0f;
+		};
+
+		/// <summary>Reorders triangles for post-transform vertex cache reuse using Tipsify (Sander, Nehab & Barczak 2007).</summary>
+		/// <param name="indices">Triangle list, reordered in place.</param>
+		/// <param name="vertexCount">Number of vertices indices refer to.</param>
+		/// <param name="cacheSize">Assumed cache size in vertices.</param>
+		/// <returns>First triangle of every cluster, i.e. spots where order had to jump to an unrelated part of mesh.</returns>
+		static std::vector<uint32_t> OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize);
+
+		/// <summary>
+		/// Sorts clusters of a cache optimised triangle list so clusters facing away from mesh centre are drawn first,
+		/// letting them occlude inner ones from most view directions. Order within a cluster is kept, so cache reuse is too.
+		/// </summary>
+		/// <param name="indices">Triangle list, reordered in place.</param>
+		/// <param name="clusters">Clusters returned by OptimizeVertexCache().</param>
+		/// <param name="positions">First position, three floats.</param>
+		/// <param name="positionStride">Bytes between consecutive positions.</param>
+		static void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<uint32_t>& clusters, const float* positions, size_t positionStride);
+
+		/// <summary>Reorders vertices into order of first use by indices & drops unreferenced ones.</summary>
+		/// <param name="vertices">Vertex data, reordered in place.</param>
+		/// <param name="vertexCount">Number of vertices.</param>
+		/// <param name="vertexStride">Size of one vertex.</param>
+		/// <param name="indices">Triangle list, remapped to new vertex order.</param>
+		/// <returns>Number of vertices left.</returns>
+		static uint32_t OptimizeVertexFetch(void* vertices, uint32_t vertexCount, uint32_t vertexStride, std::vector<uint32_t>& indices);
+
+		/// <summary>Simulates a FIFO post-transform cache over triangle list.</summary>
+		/// <param name="indices">Triangle list.</param>
+		/// <param name="vertexCount">Number of vertices indices refer to.</param>
+		/// <param name="cacheSize">Simulated cache size in vertices.</param>
+		/// <returns>Cache statistics of triangle list.</returns>
+		static CacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize);
+	};
+}
@@ -0,0 +1,115 @@
+#include "MipGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace AlphonsoGraphicsEngine
+{
+	const uint32_t MipGenerator::RowsPerTask = 32;
+
+	uint32_t MipGenerator::MipLevelCount(uint32_t width, uint32_t height)
+	{
+		uint32_t levels = 1;
+		for (uint32_t extent = std::max(width, height); extent > 1; extent >>= 1)
+		{
+			++levels;
+		}
+		return levels;
+	}
+
+	uint32_t MipGenerator::MipExtent(uint32_t extent, uint32_t level)
+	{
+		return std::max(extent >> level, 1u);
+	}
+
+	size_t MipGenerator::ChainSize(uint32_t width, uint32_t height, uint32_t mipLevels)
+	{
+		size_t size = 0;
+		for (uint32_t level = 0; level < mipLevels; ++level)
+		{
+			size += static_cast<size_t>(MipExtent(width, level)) * MipExtent(height, level) * 4;
+		}
+		return size;
+	}
+
+	void MipGenerator::GenerateRgba8(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t mipLevels, ThreadPool& threadPool, uint8_t* chain)
+	{
+		memcpy(chain, pixels, static_cast<size_t>(width) * height * 4);
+
+		uint8_t* source = chain;
+		for (uint32_t level = 1; level < mipLevels; ++level)
+		{
+			uint32_t sourceWidth = MipExtent(width, level - 1);
+			uint32_t sourceHeight = MipExtent(height, level - 1);
+			uint32_t destinationWidth = MipExtent(width, level);
+			uint32_t destinationHeight = MipExtent(height, level);
+			uint8_t* destination = source + static_cast<size_t>(sourceWidth) * sourceHeight * 4;
+
+			Footprint horizontal = BuildFootprint(sourceWidth, destinationWidth);
+			Footprint vertical = BuildFootprint(sourceHeight, destinationHeight);
+
+			uint32_t taskCount = (destinationHeight + RowsPerTask - 1) / RowsPerTask;
+			threadPool.ParallelFor(taskCount, [&](uint32_t task)
+			{
+				uint32_t rowEnd = std::min((task + 1) * RowsPerTask, destinationHeight);
+				for (uint32_t y = task * RowsPerTask; y < rowEnd; ++y)
+				{
+					for (uint32_t x = 0; x < destinationWidth; ++x)
+					{
+						float sum[4] = {};
+						for (uint32_t i = vertical.offsets[y]; i < vertical.offsets[y + 1]; ++i)
+						{
+							const Tap& row = vertical.taps[i];
+							const uint8_t* sourceRow = source + static_cast<size_t>(row.source) * sourceWidth * 4;
+							for (uint32_t j = horizontal.offsets[x]; j < horizontal.offsets[x + 1]; ++j)
+							{
+								const Tap& column = horizontal.taps[j];
+								const uint8_t* texel = sourceRow + static_cast<size_t>(column.source) * 4;
+								float weight = row.weight * column.weight;
+								for (uint32_t channel = 0; channel < 4; ++channel)
+								{
+									sum[channel] += texel[channel] * weight;
+								}
+							}
+						}
+
+						uint8_t* texel = destination + (static_cast<size_t>(y) * destinationWidth + x) * 4;
+						for (uint32_t channel = 0; channel < 4; ++channel)
+						{
+							texel[channel] = static_cast<uint8_t>(std::min(sum[channel] + 0.5f, 255.0f));
+						}
+					}
+				}
+			});
+
+			source = destination;
+		}
+	}
+
+	MipGenerator::Footprint MipGenerator::BuildFootprint(uint32_t sourceExtent, uint32_t destinationExtent)
+	{
+		Footprint footprint;
+		footprint.offsets.reserve(static_cast<size_t>(destinationExtent) + 1);
+		footprint.offsets.push_back(0);
+
+		// Destination texel i covers source interval [i * scale, (i + 1) * scale), each source texel weighted by its overlap
+		float scale = static_cast<float>(sourceExtent) / static_cast<float>(destinationExtent);
+		for (uint32_t i = 0; i < destinationExtent; ++i)
+		{
+			float begin = i * scale;
+			float end = (i + 1) * scale;
+			uint32_t first = static_cast<uint32_t>(begin);
+			uint32_t last = std::min(static_cast<uint32_t>(std::ceil(end)), sourceExtent);
+			for (uint32_t source = first; source < last; ++source)
+			{
+				float overlap = std::min(end, source + 1.0f) - std::max(begin, static_cast<float>(source));
+				if (overlap > 0.0f)
+				{
+					footprint.taps.push_back({ source, overlap / scale });
+				}
+			}
+			footprint.offsets.push_back(static_cast<uint32_t>(footprint.taps.size()));
+		}
+		return footprint;
+	}
+}
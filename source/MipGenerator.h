@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "ThreadPool.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Builds mip chains of RGBA8 images on CPU. Levels are laid out tightly packed one after another, largest first,
+	/// which is what UploadManager::UploadImage() expects for a multi-level upload.
+	/// </summary>
+	class MipGenerator final
+	{
+	public:
+		/// <summary>Gets number of levels of a full chain down to 1x1.</summary>
+		static uint32_t MipLevelCount(uint32_t width, uint32_t height);
+
+		/// <summary>Gets size of one level.</summary>
+		static uint32_t MipExtent(uint32_t extent, uint32_t level);
+
+		/// <summary>Gets bytes needed for levels [0, mipLevels) of an RGBA8 image.</summary>
+		static size_t ChainSize(uint32_t width, uint32_t height, uint32_t mipLevels);
+
+		/// <summary>
+		/// Writes level 0 & every smaller level into chain. Each level is box filtered from previous one over exact footprint
+		/// of a destination texel, so odd sizes blend three source texels instead of dropping last row or column.
+		/// </summary>
+		/// <param name="pixels">Level 0, width * height RGBA8 texels.</param>
+		/// <param name="width">Width of level 0.</param>
+		/// <param name="height">Height of level 0.</param>
+		/// <param name="mipLevels">Number of levels to write.</param>
+		/// <param name="threadPool">Pool rows of each level are filtered on.</param>
+		/// <param name="chain">Destination of ChainSize() bytes, e.g. mapped staging memory.</param>
+		static void GenerateRgba8(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t mipLevels, ThreadPool& threadPool, uint8_t* chain);
+
+	private:
+		struct Tap
+		{
+			uint32_t source;
+			float weight;
+		};
+
+		// Taps of every destination texel along one axis, as offsets into one flat list
+		struct Footprint
+		{
+			std::vector<uint32_t> offsets;
+			std::vector<Tap> taps;
+		};
+
+		static Footprint BuildFootprint(uint32_t sourceExtent, uint32_t destinationExtent);
+
+		static const uint32_t RowsPerTask;
+	};
+}
@@ -0,0 +1,256 @@
+#include "ObjParser.h"
+#include <stdexcept>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace AlphonsoGraphicsEngine
+{
+	const size_t ObjParser::MinChunkSize = 1024 * 1024;
+
+	namespace
+	{
+		bool IsSpace(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		const char* SkipSpaces(const char* cursor, const char* end)
+		{
+			while (cursor < end && IsSpace(*cursor))
+			{
+				++cursor;
+			}
+			return cursor;
+		}
+	}
+
+	void ObjParser::Parse(const char* text, size_t size, ThreadPool& threadPool, Mesh& mesh)
+	{
+		// A few chunks per worker evens out chunks which happen to be mostly faces
+		size_t maxChunkCount = std::max<size_t>(threadPool.ThreadCount(), 1) * 4;
+		size_t chunkCount = std::clamp<size_t>(size / MinChunkSize, 1, maxChunkCount);
+
+		// Move every split point past next line break, so no line straddles two chunks
+		std::vector<Chunk> chunks(chunkCount);
+		const char* end = text + size;
+		const char* begin = text;
+		for (size_t i = 0; i < chunkCount; ++i)
+		{
+			const char* split = end;
+			if (i + 1 < chunkCount)
+			{
+				split = std::max(text + size * (i + 1) / chunkCount, begin);
+				const char* lineBreak = static_cast<const char*>(memchr(split, '\n', static_cast<size_t>(end - split)));
+				split = lineBreak != nullptr ? lineBreak + 1 : end;
+			}
+
+			chunks[i].begin = begin;
+			chunks[i].end = split;
+			begin = split;
+		}
+
+		threadPool.ParallelFor(static_cast<uint32_t>(chunkCount), [&chunks](uint32_t i)
+		{
+			ParseChunk(chunks[i]);
+		});
+
+		// Offsets of each chunk's attributes & corners in stitched mesh
+		struct ChunkOffsets
+		{
+			size_t positions = 0;
+			size_t normals = 0;
+			size_t texCoords = 0;
+			size_t corners = 0;
+		};
+		std::vector<ChunkOffsets> offsets(chunkCount + 1);
+		for (size_t i = 0; i < chunkCount; ++i)
+		{
+			offsets[i + 1].positions = offsets[i].positions + chunks[i].positions.size();
+			offsets[i + 1].normals = offsets[i].normals + chunks[i].normals.size();
+			offsets[i + 1].texCoords = offsets[i].texCoords + chunks[i].texCoords.size();
+			offsets[i + 1].corners = offsets[i].corners + chunks[i].corners.size();
+		}
+
+		mesh.positions.resize(offsets[chunkCount].positions);
+		mesh.normals.resize(offsets[chunkCount].normals);
+		mesh.texCoords.resize(offsets[chunkCount].texCoords);
+		mesh.corners.resize(offsets[chunkCount].corners);
+
+		// Resolved indices are checked against whole file's attributes, so malformed or truncated files never index past them
+		const int32_t positionCount = static_cast<int32_t>(mesh.positions.size() / 3);
+		const int32_t texCoordCount = static_cast<int32_t>(mesh.texCoords.size() / 2);
+		const int32_t normalCount = static_cast<int32_t>(mesh.normals.size() / 3);
+
+		threadPool.ParallelFor(static_cast<uint32_t>(chunkCount), [&chunks, &offsets, &mesh, positionCount, texCoordCount, normalCount](uint32_t i)
+		{
+			const Chunk& chunk = chunks[i];
+			const ChunkOffsets& offset = offsets[i];
+			std::copy(chunk.positions.begin(), chunk.positions.end(), mesh.positions.begin() + offset.positions);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), mesh.normals.begin() + offset.normals);
+			std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), mesh.texCoords.begin() + offset.texCoords);
+
+			int32_t positionBase = static_cast<int32_t>(offset.positions / 3);
+			int32_t texCoordBase = static_cast<int32_t>(offset.texCoords / 2);
+			int32_t normalBase = static_cast<int32_t>(offset.normals / 3);
+			for (size_t j = 0; j < chunk.corners.size(); ++j)
+			{
+				const RawCorner& raw = chunk.corners[j];
+				Corner& corner = mesh.corners[offset.corners + j];
+				corner.position = raw.corner.position + ((raw.relativeMask & 1) ? positionBase : 0);
+				corner.texCoord = raw.corner.texCoord + ((raw.relativeMask & 2) ? texCoordBase : 0);
+				corner.normal = raw.corner.normal + ((raw.relativeMask & 4) ? normalBase : 0);
+
+				// Absent texture coordinates & normals stay -1, a relative index resolving there is out of range
+				if (corner.position < 0 || corner.position >= positionCount
+					|| ((corner.texCoord != -1 || (raw.relativeMask & 2)) && (corner.texCoord < 0 || corner.texCoord >= texCoordCount))
+					|| ((corner.normal != -1 || (raw.relativeMask & 4)) && (corner.normal < 0 || corner.normal >= normalCount)))
+				{
+					throw std::runtime_error("failed to parse OBJ face, index out of range!");
+				}
+			}
+		});
+	}
+
+	void ObjParser::ParseChunk(Chunk& chunk)
+	{
+		std::vector<RawCorner> polygon;
+
+		const char* cursor = chunk.begin;
+		while (cursor < chunk.end)
+		{
+			const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', static_cast<size_t>(chunk.end - cursor)));
+			if (lineEnd == nullptr)
+			{
+				lineEnd = chunk.end;
+			}
+
+			const char* line = SkipSpaces(cursor, lineEnd);
+			if (lineEnd - line >= 2)
+			{
+				if (line[0] == 'v' && IsSpace(line[1]))
+				{
+					ParseFloats(line + 2, lineEnd, 3, chunk.positions);
+				}
+				else if (line[0] == 'v' && line[1] == 'n' && lineEnd - line >= 3 && IsSpace(line[2]))
+				{
+					ParseFloats(line + 3, lineEnd, 3, chunk.normals);
+				}
+				else if (line[0] == 'v' && line[1] == 't' && lineEnd - line >= 3 && IsSpace(line[2]))
+				{
+					ParseFloats(line + 3, lineEnd, 2, chunk.texCoords);
+				}
+				else if (line[0] == 'f' && IsSpace(line[1]))
+				{
+					ParseFace(line + 2, lineEnd, chunk, polygon);
+				}
+			}
+
+			cursor = lineEnd + 1;
+		}
+	}
+
+	void ObjParser::ParseFace(const char* cursor, const char* end, Chunk& chunk, std::vector<RawCorner>& polygon)
+	{
+		// Counts of attributes read so far in this chunk, which negative indices are relative to
+		const int32_t counts[3] = {
+			static_cast<int32_t>(chunk.positions.size() / 3),
+			static_cast<int32_t>(chunk.texCoords.size() / 2),
+			static_cast<int32_t>(chunk.normals.size() / 3)
+		};
+
+		polygon.clear();
+		for (;;)
+		{
+			cursor = SkipSpaces(cursor, end);
+			if (cursor == end || *cursor == '#')
+			{
+				break;
+			}
+
+			// Corner is "v", "v/vt", "v//vn" or "v/vt/vn"
+			RawCorner raw;
+			int32_t* components[3] = { &raw.corner.position, &raw.corner.texCoord, &raw.corner.normal };
+			for (uint32_t component = 0; component < 3; ++component)
+			{
+				if (component > 0)
+				{
+					if (cursor == end || *cursor != '/')
+					{
+						break;
+					}
+					++cursor;
+				}
+
+				int32_t index = 0;
+				std::from_chars_result result = std::from_chars(cursor, end, index);
+				if (result.ptr == cursor)
+				{
+					// Empty texture coordinate of "v//vn"
+					if (component == 0)
+					{
+						throw std::runtime_error("failed to parse OBJ face!");
+					}
+					continue;
+				}
+				cursor = result.ptr;
+
+				if (index > 0)
+				{
+					*components[component] = index - 1;
+				}
+				else if (index < 0)
+				{
+					*components[component] = counts[component] + index;
+					raw.relativeMask |= static_cast<uint8_t>(1 << component);
+				}
+				else
+				{
+					throw std::runtime_error("failed to parse OBJ face!");
+				}
+			}
+
+			if (cursor != end && !IsSpace(*cursor) && *cursor != '#')
+			{
+				throw std::runtime_error("failed to parse OBJ face!");
+			}
+			polygon.push_back(raw);
+		}
+
+		for (size_t i = 1; i + 1 < polygon.size(); ++i)
+		{
+			chunk.corners.push_back(polygon[0]);
+			chunk.corners.push_back(polygon[i]);
+			chunk.corners.push_back(polygon[i + 1]);
+		}
+	}
+
+	const char* ObjParser::ParseFloats(const char* cursor, const char* end, uint32_t count, std::vector<float>& values)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			cursor = SkipSpaces(cursor, end);
+			if (cursor != end && *cursor == '+')
+			{
+				++cursor;
+			}
+
+			// Missing trailing components, e.g. "vt u", default to zero
+			float value = 0.0f;
+			std::from_chars_result result = std::from_chars(cursor, end, value);
+			if (result.ec == std::errc::invalid_argument)
+			{
+				if (cursor != end && *cursor != '#')
+				{
+					throw std::runtime_error("failed to parse OBJ number!");
+				}
+			}
+			else
+			{
+				cursor = result.ptr;
+			}
+			values.push_back(value);
+		}
+		return cursor;
+	}
+}
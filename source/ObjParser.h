@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "ThreadPool.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Wavefront OBJ parser splitting text into line aligned chunks which are parsed on worker threads.
+	/// Reads positions, normals, texture coordinates & faces; polygons are fan triangulated & everything else is skipped.
+	/// Chunks are stitched in file order, so output doesn't depend on number of threads.
+	/// </summary>
+	class ObjParser final
+	{
+	public:
+		/// <summary>Attribute indices of one triangle corner, zero based. -1 if corner has no such attribute.</summary>
+		struct Corner
+		{
+			int32_t position = -1;
+			int32_t texCoord = -1;
+			int32_t normal = -1;
+		};
+
+		struct Mesh
+		{
+			// Three floats per position & normal, two per texture coordinate
+			std::vector<float> positions;
+			std::vector<float> normals;
+			std::vector<float> texCoords;
+			// Three corners per triangle
+			std::vector<Corner> corners;
+		};
+
+		/// <summary>Parses OBJ text.</summary>
+		/// <param name="text">Text, need not be null terminated.</param>
+		/// <param name="size">Length of text.</param>
+		/// <param name="threadPool">Pool chunks are parsed on.</param>
+		/// <param name="mesh">Parsed mesh.</param>
+		static void Parse(const char* text, size_t size, ThreadPool& threadPool, Mesh& mesh);
+
+	private:
+		// Face corner as written in file. Negative indices count back from the attributes read so far, so until chunk
+		// offsets are known they are kept relative to chunk's own first attribute & flagged in relativeMask.
+		struct RawCorner
+		{
+			Corner corner;
+			uint8_t relativeMask = 0;
+		};
+
+		struct Chunk
+		{
+			const char* begin = nullptr;
+			const char* end = nullptr;
+			std::vector<float> positions;
+			std::vector<float> normals;
+			std::vector<float> texCoords;
+			std::vector<RawCorner> corners;
+		};
+
+		static const size_t MinChunkSize;
+
+		static void ParseChunk(Chunk& chunk);
+		static void ParseFace(const char* cursor, const char* end, Chunk& chunk, std::vector<RawCorner>& polygon);
+		static const char* ParseFloats(const char* cursor, const char* end, uint32_t count, std::vector<float>& values);
+	};
+}
@@ -0,0 +1,166 @@
+#include "PipelineCache.h"
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include "MappedFile.h"
+#include "SourceFingerprint.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	// "APSO"
+	const uint32_t PipelineCache::Magic = 0x4F535041;
+	const uint32_t PipelineCache::Version = 1;
+
+	void PipelineCache::Initialize(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& path)
+	{
+		mDevice = device;
+		mPath = path;
+		mLoaded = false;
+		vkGetPhysicalDeviceProperties(physicalDevice, &mProperties);
+
+		MappedFile file;
+		const uint8_t* initialData = nullptr;
+		size_t initialDataSize = 0;
+		if (!mPath.empty() && file.Open(mPath) && IsCompatible(file.Data(), file.Size()))
+		{
+			initialData = file.Data() + sizeof(FileHeader);
+			initialDataSize = file.Size() - sizeof(FileHeader);
+		}
+
+		VkPipelineCacheCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		createInfo.initialDataSize = initialDataSize;
+		createInfo.pInitialData = initialData;
+		if (vkCreatePipelineCache(mDevice, &createInfo, nullptr, &mCache) != VK_SUCCESS)
+		{
+			// Driver may still refuse data it wrote itself, an empty cache only costs a cold start
+			createInfo.initialDataSize = 0;
+			createInfo.pInitialData = nullptr;
+			if (vkCreatePipelineCache(mDevice, &createInfo, nullptr, &mCache) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create pipeline cache!");
+			}
+			initialDataSize = 0;
+		}
+		mLoaded = initialDataSize > 0;
+	}
+
+	void PipelineCache::Shutdown()
+	{
+		if (mCache == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		Save();
+		vkDestroyPipelineCache(mDevice, mCache, nullptr);
+		mCache = VK_NULL_HANDLE;
+	}
+
+	bool PipelineCache::Save() const
+	{
+		if (mPath.empty() || mCache == VK_NULL_HANDLE)
+		{
+			return false;
+		}
+
+		// Cache may grow between both calls, incomplete data is simply asked for again
+		std::vector<uint8_t> data;
+		VkResult result;
+		do
+		{
+			size_t dataSize = 0;
+			if (vkGetPipelineCacheData(mDevice, mCache, &dataSize, nullptr) != VK_SUCCESS)
+			{
+				return false;
+			}
+			data.resize(dataSize);
+			result = vkGetPipelineCacheData(mDevice, mCache, &dataSize, data.data());
+			data.resize(dataSize);
+		} while (result == VK_INCOMPLETE);
+
+		if (result != VK_SUCCESS || data.empty())
+		{
+			return false;
+		}
+
+		FileHeader header = {};
+		header.magic = Magic;
+		header.version = Version;
+		header.vendorID = mProperties.vendorID;
+		header.deviceID = mProperties.deviceID;
+		header.driverVersion = mProperties.driverVersion;
+		memcpy(header.pipelineCacheUUID, mProperties.pipelineCacheUUID, VK_UUID_SIZE);
+		header.dataSize = data.size();
+		header.dataHash = SourceFingerprint::Hash(data.data(), data.size());
+
+		std::string temporaryPath = mPath + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!file)
+			{
+				return false;
+			}
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+			if (!file)
+			{
+				file.close();
+				std::error_code error;
+				std::filesystem::remove(temporaryPath, error);
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, mPath, error);
+		if (error)
+		{
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	VkPipelineCache PipelineCache::Handle() const
+	{
+		return mCache;
+	}
+
+	bool PipelineCache::WasLoaded() const
+	{
+		return mLoaded;
+	}
+
+	bool PipelineCache::IsCompatible(const uint8_t* data, size_t size) const
+	{
+		if (size < sizeof(FileHeader) + sizeof(DriverHeader))
+		{
+			return false;
+		}
+
+		const FileHeader* header = reinterpret_cast<const FileHeader*>(data);
+		if (header->magic != Magic || header->version != Version || header->vendorID != mProperties.vendorID || header->deviceID != mProperties.deviceID
+			|| header->driverVersion != mProperties.driverVersion || memcmp(header->pipelineCacheUUID, mProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0
+			|| header->dataSize != size - sizeof(FileHeader))
+		{
+			return false;
+		}
+
+		// Driver's own header is checked too, some drivers crash on data of another device instead of rejecting it
+		const uint8_t* cacheData = data + sizeof(FileHeader);
+		DriverHeader driverHeader;
+		memcpy(&driverHeader, cacheData, sizeof(driverHeader));
+		if (driverHeader.headerSize < sizeof(DriverHeader) || driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			|| driverHeader.vendorID != mProperties.vendorID || driverHeader.deviceID != mProperties.deviceID
+			|| memcmp(driverHeader.pipelineCacheUUID, mProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			return false;
+		}
+
+		return SourceFingerprint::Hash(cacheData, static_cast<size_t>(header->dataSize)) == header->dataHash;
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// VkPipelineCache persisted across runs. Saved data is prefixed with vendor, device, driver version & cache UUID of device
+	/// it came from plus a hash of driver's blob, so data from another GPU, driver or a torn write is dropped instead of handed
+	/// to driver. File is written to a temporary file & renamed, so a crash while saving never leaves half of it.
+	/// </summary>
+	class PipelineCache final
+	{
+	public:
+		PipelineCache() = default;
+		PipelineCache(const PipelineCache&) = delete;
+		PipelineCache& operator=(const PipelineCache&) = delete;
+		PipelineCache(PipelineCache&&) = delete;
+		PipelineCache& operator=(PipelineCache&&) = delete;
+		~PipelineCache() = default;
+
+		/// <summary>Creates cache, seeded from file if it was saved on same device & driver.</summary>
+		/// <param name="physicalDevice">Physical device pipelines are compiled for.</param>
+		/// <param name="device">Logical device.</param>
+		/// <param name="path">Path of cache file, empty to never load or save.</param>
+		void Initialize(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& path);
+
+		/// <summary>Saves cache & destroys it. No pipeline may be compiling against it.</summary>
+		void Shutdown();
+
+		/// <summary>Writes current contents of cache to its file.</summary>
+		/// <returns>False if there is no file or it couldn't be written.</returns>
+		bool Save() const;
+
+		/// <summary>Gets cache every pipeline is created against.</summary>
+		VkPipelineCache Handle() const;
+
+		/// <summary>Gets whether cache was seeded from a previous run.</summary>
+		bool WasLoaded() const;
+
+	private:
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t vendorID;
+			uint32_t deviceID;
+			uint32_t driverVersion;
+			uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+			uint32_t reserved;
+			uint64_t dataSize;
+			uint64_t dataHash;
+		};
+
+		// Header Vulkan requires at start of every driver's cache data
+		struct DriverHeader
+		{
+			uint32_t headerSize;
+			uint32_t headerVersion;
+			uint32_t vendorID;
+			uint32_t deviceID;
+			uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		};
+
+		bool IsCompatible(const uint8_t* data, size_t size) const;
+
+		static const uint32_t Magic;
+		static const uint32_t Version;
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		VkPhysicalDeviceProperties mProperties = {};
+		VkPipelineCache mCache = VK_NULL_HANDLE;
+		std::string mPath;
+		bool mLoaded = false;
+	};
+}
@@ -0,0 +1,265 @@
+#include "PipelineCompiler.h"
+#include <stdexcept>
+#include <chrono>
+
+namespace AlphonsoGraphicsEngine
+{
+	const PipelineCompiler::PipelineHandle PipelineCompiler::NoPipeline = UINT32_MAX;
+
+	void PipelineCompiler::Initialize(VkDevice device, VkPipelineCache pipelineCache, uint32_t threadCount)
+	{
+		mDevice = device;
+		mPipelineCache = pipelineCache;
+		mCompilePool = std::make_unique<ThreadPool>(threadCount);
+	}
+
+	void PipelineCompiler::Shutdown()
+	{
+		DestroyAll();
+		mCompilePool.reset();
+	}
+
+	PipelineCompiler::PipelineHandle PipelineCompiler::Request(Description description, PipelineHandle fallback)
+	{
+		PipelineHandle handle;
+		if (mFreeHandles.empty())
+		{
+			handle = static_cast<PipelineHandle>(mPipelines.size());
+			mPipelines.emplace_back();
+		}
+		else
+		{
+			handle = mFreeHandles.back();
+			mFreeHandles.pop_back();
+		}
+
+		Pipeline& pipeline = mPipelines[handle];
+		pipeline.fallback = fallback;
+		pipeline.live = true;
+		pipeline.job = std::make_unique<Job>();
+		pipeline.job->description = std::move(description);
+
+		// Jobs are owned by their slot, so slots growing doesn't move what a running job writes to
+		Job* job = pipeline.job.get();
+		job->done = mCompilePool->Enqueue([this, job] { RunJob(*job); });
+		return handle;
+	}
+
+	void PipelineCompiler::WaitAll()
+	{
+		for (Pipeline& pipeline : mPipelines)
+		{
+			if (pipeline.job)
+			{
+				FinishJob(pipeline);
+			}
+		}
+	}
+
+	bool PipelineCompiler::Update()
+	{
+		bool changed = false;
+		for (PipelineHandle handle = 0; handle < mPipelines.size(); ++handle)
+		{
+			Pipeline& pipeline = mPipelines[handle];
+			if (pipeline.job && pipeline.job->done.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+			{
+				FinishJob(pipeline);
+				changed = changed || !pipeline.retired;
+			}
+
+			if (pipeline.live && pipeline.retired && !pipeline.job && pipeline.releaseFrame <= mFrame)
+			{
+				Destroy(pipeline, handle);
+			}
+		}
+
+		++mFrame;
+		return changed;
+	}
+
+	VkPipeline PipelineCompiler::Get(PipelineHandle pipeline) const
+	{
+		// Fallbacks may have fallbacks of their own
+		while (pipeline != NoPipeline && pipeline < mPipelines.size() && mPipelines[pipeline].live)
+		{
+			if (mPipelines[pipeline].pipeline != VK_NULL_HANDLE)
+			{
+				return mPipelines[pipeline].pipeline;
+			}
+			pipeline = mPipelines[pipeline].fallback;
+		}
+		return VK_NULL_HANDLE;
+	}
+
+	bool PipelineCompiler::IsReady(PipelineHandle pipeline) const
+	{
+		return pipeline != NoPipeline && pipeline < mPipelines.size() && mPipelines[pipeline].pipeline != VK_NULL_HANDLE;
+	}
+
+	void PipelineCompiler::Retire(PipelineHandle pipeline, uint32_t framesInFlight)
+	{
+		if (pipeline == NoPipeline || pipeline >= mPipelines.size() || !mPipelines[pipeline].live)
+		{
+			return;
+		}
+
+		mPipelines[pipeline].retired = true;
+		mPipelines[pipeline].releaseFrame = mFrame + framesInFlight;
+
+		// Nothing may fall back to a pipeline about to be destroyed
+		for (Pipeline& other : mPipelines)
+		{
+			if (other.fallback == pipeline)
+			{
+				other.fallback = NoPipeline;
+			}
+		}
+	}
+
+	void PipelineCompiler::DestroyAll()
+	{
+		for (PipelineHandle handle = 0; handle < mPipelines.size(); ++handle)
+		{
+			Pipeline& pipeline = mPipelines[handle];
+			if (pipeline.job)
+			{
+				// Failure of a pipeline nobody will draw with any more doesn't matter
+				pipeline.job->done.wait();
+				pipeline.pipeline = pipeline.job->pipeline;
+				pipeline.job.reset();
+			}
+			if (pipeline.live)
+			{
+				Destroy(pipeline, handle);
+			}
+		}
+	}
+
+	void PipelineCompiler::RunJob(Job& job) const
+	{
+		const Description& description = job.description;
+
+		// Modules are only needed while pipeline is created, each job makes its own
+		std::vector<VkShaderModule> modules;
+		std::vector<VkPipelineShaderStageCreateInfo> stages;
+		// Reserved up front, stages point into it
+		std::vector<VkSpecializationInfo> specializations;
+		specializations.reserve(description.stages.size());
+		for (const ShaderStage& stage : description.stages)
+		{
+			VkShaderModuleCreateInfo moduleInfo = {};
+			moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			moduleInfo.codeSize = stage.spirv.size() * sizeof(uint32_t);
+			moduleInfo.pCode = stage.spirv.data();
+
+			VkShaderModule module;
+			if (vkCreateShaderModule(mDevice, &moduleInfo, nullptr, &module) != VK_SUCCESS)
+			{
+				for (VkShaderModule created : modules)
+				{
+					vkDestroyShaderModule(mDevice, created, nullptr);
+				}
+				throw std::runtime_error("failed to create shader module!");
+			}
+			modules.push_back(module);
+
+			VkPipelineShaderStageCreateInfo stageInfo = {};
+			stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			stageInfo.stage = stage.stage;
+			stageInfo.module = module;
+			stageInfo.pName = "main";
+			if (!stage.specializationEntries.empty())
+			{
+				VkSpecializationInfo specialization = {};
+				specialization.mapEntryCount = static_cast<uint32_t>(stage.specializationEntries.size());
+				specialization.pMapEntries = stage.specializationEntries.data();
+				specialization.dataSize = stage.specializationData.size();
+				specialization.pData = stage.specializationData.data();
+				specializations.push_back(specialization);
+				stageInfo.pSpecializationInfo = &specializations.back();
+			}
+			stages.push_back(stageInfo);
+		}
+
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(description.vertexBindings.size());
+		vertexInputInfo.pVertexBindingDescriptions = description.vertexBindings.data();
+		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(description.vertexAttributes.size());
+		vertexInputInfo.pVertexAttributeDescriptions = description.vertexAttributes.data();
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssembly.topology = description.topology;
+		inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+		VkPipelineViewportStateCreateInfo viewportState = {};
+		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewportState.viewportCount = 1;
+		viewportState.pViewports = &description.viewport;
+		viewportState.scissorCount = 1;
+		viewportState.pScissors = &description.scissor;
+
+		VkPipelineColorBlendStateCreateInfo colorBlending = {};
+		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		colorBlending.logicOpEnable = VK_FALSE;
+		colorBlending.logicOp = VK_LOGIC_OP_COPY;
+		colorBlending.attachmentCount = static_cast<uint32_t>(description.colorBlendAttachments.size());
+		colorBlending.pAttachments = description.colorBlendAttachments.data();
+
+		VkPipelineDynamicStateCreateInfo dynamicState = {};
+		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicState.dynamicStateCount = static_cast<uint32_t>(description.dynamicStates.size());
+		dynamicState.pDynamicStates = description.dynamicStates.data();
+
+		VkGraphicsPipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.stageCount = static_cast<uint32_t>(stages.size());
+		pipelineInfo.pStages = stages.data();
+		pipelineInfo.pVertexInputState = &vertexInputInfo;
+		pipelineInfo.pInputAssemblyState = &inputAssembly;
+		pipelineInfo.pViewportState = &viewportState;
+		pipelineInfo.pRasterizationState = &description.rasterization;
+		pipelineInfo.pMultisampleState = &description.multisample;
+		pipelineInfo.pDepthStencilState = &description.depthStencil;
+		pipelineInfo.pColorBlendState = &colorBlending;
+		pipelineInfo.pDynamicState = description.dynamicStates.empty() ? nullptr : &dynamicState;
+		pipelineInfo.layout = description.layout;
+		pipelineInfo.renderPass = description.renderPass;
+		pipelineInfo.subpass = description.subpass;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+		// Pipeline cache is internally synchronised, so every worker creates against it at once
+		VkPipeline pipeline;
+		VkResult result = vkCreateGraphicsPipelines(mDevice, mPipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+		for (VkShaderModule module : modules)
+		{
+			vkDestroyShaderModule(mDevice, module, nullptr);
+		}
+
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create graphics pipeline!");
+		}
+		job.pipeline = pipeline;
+	}
+
+	void PipelineCompiler::FinishJob(Pipeline& pipeline)
+	{
+		std::unique_ptr<Job> job = std::move(pipeline.job);
+		job->done.get();
+		pipeline.pipeline = job->pipeline;
+	}
+
+	void PipelineCompiler::Destroy(Pipeline& pipeline, PipelineHandle handle)
+	{
+		if (pipeline.pipeline != VK_NULL_HANDLE)
+		{
+			vkDestroyPipeline(mDevice, pipeline.pipeline, nullptr);
+		}
+		pipeline = Pipeline();
+		mFreeHandles.push_back(handle);
+	}
+}
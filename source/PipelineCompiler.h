@@ -0,0 +1,128 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <future>
+#include "ThreadPool.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Compiles graphics pipelines on its own workers, one vkCreateGraphicsPipelines per job against a shared pipeline cache.
+	/// A pipeline may declare a fallback, drawn with while it is still compiling, so asking for a new variant never blocks a frame.
+	/// Pipelines needed before anything can be drawn are requested together & waited for, so startup scales with cores.
+	/// Apart from compile jobs, every method must be called from the thread which submits frames.
+	/// </summary>
+	class PipelineCompiler final
+	{
+	public:
+		using PipelineHandle = uint32_t;
+		static const PipelineHandle NoPipeline;
+
+		struct ShaderStage
+		{
+			VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+			std::vector<uint32_t> spirv;
+			// Specialization constants, entries' offsets point into data
+			std::vector<VkSpecializationMapEntry> specializationEntries;
+			std::vector<uint8_t> specializationData;
+		};
+
+		/// <summary>Everything a graphics pipeline is built from, owned so it can be compiled after caller's state is gone.</summary>
+		struct Description
+		{
+			std::vector<ShaderStage> stages;
+			std::vector<VkVertexInputBindingDescription> vertexBindings;
+			std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+			VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+			// Ignored for states listed in dynamicStates
+			VkViewport viewport = {};
+			VkRect2D scissor = {};
+			VkPipelineRasterizationStateCreateInfo rasterization = {};
+			VkPipelineMultisampleStateCreateInfo multisample = {};
+			VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+			std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments;
+			std::vector<VkDynamicState> dynamicStates;
+			VkPipelineLayout layout = VK_NULL_HANDLE;
+			VkRenderPass renderPass = VK_NULL_HANDLE;
+			uint32_t subpass = 0;
+		};
+
+		PipelineCompiler() = default;
+		PipelineCompiler(const PipelineCompiler&) = delete;
+		PipelineCompiler& operator=(const PipelineCompiler&) = delete;
+		PipelineCompiler(PipelineCompiler&&) = delete;
+		PipelineCompiler& operator=(PipelineCompiler&&) = delete;
+		~PipelineCompiler() = default;
+
+		/// <summary>Starts compile workers.</summary>
+		/// <param name="device">Logical device.</param>
+		/// <param name="pipelineCache">Cache every pipeline is created against, shared by all workers.</param>
+		/// <param name="threadCount">Number of workers. Zero picks one less than hardware thread count ( at least one ).</param>
+		void Initialize(VkDevice device, VkPipelineCache pipelineCache, uint32_t threadCount);
+
+		/// <summary>Waits for running compiles & destroys every pipeline. GPU must be done using them.</summary>
+		void Shutdown();
+
+		/// <summary>Queues a pipeline for compilation.</summary>
+		/// <param name="description">Description of pipeline.</param>
+		/// <param name="fallback">Pipeline drawn with until this one is compiled, NoPipeline if there is none.</param>
+		/// <returns>Handle of pipeline.</returns>
+		PipelineHandle Request(Description description, PipelineHandle fallback = NoPipeline);
+
+		/// <summary>Blocks until every queued pipeline is compiled. Rethrows failure of any compile.</summary>
+		void WaitAll();
+
+		/// <summary>
+		/// Picks up pipelines whose compile finished & destroys retired pipelines frames in flight no longer use.
+		/// Call once per frame, after waiting for frame's fence. Rethrows failure of any compile.
+		/// </summary>
+		/// <returns>True if any pipeline became ready, so what Get() returns changed & command buffers binding it must be recorded again.</returns>
+		bool Update();
+
+		/// <summary>Gets compiled pipeline, or its fallback's while it compiles. VK_NULL_HANDLE if neither is ready.</summary>
+		VkPipeline Get(PipelineHandle pipeline) const;
+
+		/// <summary>Gets whether pipeline itself, not a fallback, is compiled.</summary>
+		bool IsReady(PipelineHandle pipeline) const;
+
+		/// <summary>Destroys pipeline once frames in flight are done with it, waiting for its compile if still running.</summary>
+		/// <param name="pipeline">Handle of pipeline, invalid afterwards.</param>
+		/// <param name="framesInFlight">Number of frames which may still use pipeline.</param>
+		void Retire(PipelineHandle pipeline, uint32_t framesInFlight);
+
+		/// <summary>Waits for running compiles & destroys every pipeline right away. GPU must be done using them.</summary>
+		void DestroyAll();
+
+	private:
+		struct Job
+		{
+			Description description;
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			std::future<void> done;
+		};
+
+		struct Pipeline
+		{
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			PipelineHandle fallback = NoPipeline;
+			std::unique_ptr<Job> job;
+			bool live = false;
+			bool retired = false;
+			uint64_t releaseFrame = 0;
+		};
+
+		void RunJob(Job& job) const;
+		void FinishJob(Pipeline& pipeline);
+		void Destroy(Pipeline& pipeline, PipelineHandle handle);
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		VkPipelineCache mPipelineCache = VK_NULL_HANDLE;
+		std::unique_ptr<ThreadPool> mCompilePool;
+
+		std::vector<Pipeline> mPipelines;
+		std::vector<PipelineHandle> mFreeHandles;
+		uint64_t mFrame = 0;
+	};
+}
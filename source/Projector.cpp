@@ -10,8 +10,6 @@ namespace AlphonsoGraphicsEngine
 	const float Projector::DefaultFieldOfView = 800.0f;
 	const float Projector::DefaultNearPlaneDistance = 0.1f;
 	const float Projector::DefaultFarPlaneDistance = 100.0f;
-	float Projector::deltaTime = 0.0f;
-	float Projector::lastFrame = 0.0f;
 
 	Projector::Projector(RendererC& renderer) :
 		mFieldOfView(DefaultFieldOfView), mAspectRatio(renderer.AspectRatio()), mNearPlaneDistance(DefaultNearPlaneDistance), mFarPlaneDistance(DefaultFarPlaneDistance),
@@ -116,41 +114,42 @@ namespace AlphonsoGraphicsEngine
 		Reset();
 	}
 
-	void Projector::Update(const GameTime& gameTime)
+	void Projector::SetInput(const InputState& input)
 	{
-		UNREFERENCED_PARAMETER(gameTime);
+		mInput = input;
+	}
 
-		float currentFrame = static_cast<float>(glfwGetTime());
-		deltaTime = currentFrame - lastFrame;
-		lastFrame = currentFrame;
+	void Projector::Update(const GameTime& gameTime)
+	{
+		float deltaTime = gameTime.ElapsedGameTimeSeconds().count();
 
 		vec2 movementAmount = vec2(0.0f, 0.0f);
-		if (glfwGetKey(mWindow, GLFW_KEY_I))
+		if (mInput.IsKeyDown(GLFW_KEY_I))
 		{
 			movementAmount.y = 1.0f;
 		}
 
-		if (glfwGetKey(mWindow, GLFW_KEY_K))
+		if (mInput.IsKeyDown(GLFW_KEY_K))
 		{
 			movementAmount.y = -1.0f;
 		}
 
-		if (glfwGetKey(mWindow, GLFW_KEY_J))
+		if (mInput.IsKeyDown(GLFW_KEY_J))
 		{
 			movementAmount.x = -1.0f;
 		}
 
-		if (glfwGetKey(mWindow, GLFW_KEY_L))
+		if (mInput.IsKeyDown(GLFW_KEY_L))
 		{
 			movementAmount.x = 1.0f;
 		}
 
 		vec2 rotationAmount = vec2(0.0f, 0.0f);
 
-		double x, y;
-		glfwGetCursorPos(mWindow, &x, &y);
+		double x = mInput.CursorX();
+		double y = mInput.CursorY();
 
-		if (glfwGetMouseButton(mWindow, GLFW_MOUSE_BUTTON_RIGHT))
+		if (mInput.IsMouseButtonDown(GLFW_MOUSE_BUTTON_RIGHT))
 		{
 			rotationAmount.x = static_cast<float>(mLastCursorX - x) * 4.0f;
 			rotationAmount.y = static_cast<float>(mLastCursorY - y) * 4.0f;
@@ -2,6 +2,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "RendererC.h"
+#include "InputState.h"
 
 namespace AlphonsoGraphicsEngine
 {
@@ -38,6 +39,10 @@ namespace AlphonsoGraphicsEngine
 		void Reset();
 		void Initialize();
 		void Update(const GameTime& gameTime);
+
+		/// <summary>Sets input consumed by next Update().</summary>
+		/// <param name="input">Input sampled on main thread.</param>
+		void SetInput(const InputState& input);
 		void UpdateViewMatrix();
 		void UpdateProjectionMatrix();
 		void ApplyRotation(const glm::mat4& transform);
@@ -45,8 +50,6 @@ namespace AlphonsoGraphicsEngine
 		static const float DefaultFieldOfView;
 		static const float DefaultNearPlaneDistance;
 		static const float DefaultFarPlaneDistance;
-		static float deltaTime;			// Time between current frame and last frame
-		static float lastFrame;			// Time of last frame
 
 	protected:
 		float mFieldOfView;
@@ -63,6 +66,7 @@ namespace AlphonsoGraphicsEngine
 		glm::mat4 mProjectionMatrix;
 
 		GLFWwindow* mWindow;
+		InputState mInput;
 		double mLastCursorX;
 		double mLastCursorY;
 	};
@@ -0,0 +1,851 @@
+#include "RenderGraph.h"
+#include <stdexcept>
+#include <algorithm>
+
+namespace AlphonsoGraphicsEngine
+{
+	RenderGraph::PassBuilder::PassBuilder(RenderGraph& graph, PassHandle pass) :
+		mGraph(graph), mPass(pass)
+	{
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::WriteColor(ResourceHandle resource, VkAttachmentLoadOp loadOp, VkClearColorValue clearValue)
+	{
+		VkClearValue value = {};
+		value.color = clearValue;
+		mGraph.mPasses[mPass].accesses.push_back({ resource, AccessType::ColorAttachment, loadOp, value });
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::WriteDepth(ResourceHandle resource, VkAttachmentLoadOp loadOp, VkClearDepthStencilValue clearValue)
+	{
+		VkClearValue value = {};
+		value.depthStencil = clearValue;
+		mGraph.mPasses[mPass].accesses.push_back({ resource, AccessType::DepthAttachment, loadOp, value });
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::WriteResolve(ResourceHandle resource)
+	{
+		mGraph.mPasses[mPass].accesses.push_back({ resource, AccessType::ResolveAttachment, VK_ATTACHMENT_LOAD_OP_DONT_CARE, {} });
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::ReadTexture(ResourceHandle resource)
+	{
+		mGraph.mPasses[mPass].accesses.push_back({ resource, AccessType::SampledTexture, VK_ATTACHMENT_LOAD_OP_LOAD, {} });
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::SetExecute(ExecuteCallback callback, VkSubpassContents contents)
+	{
+		mGraph.mPasses[mPass].execute = std::move(callback);
+		mGraph.mPasses[mPass].contents = contents;
+		return *this;
+	}
+
+	RenderGraph::PassHandle RenderGraph::PassBuilder::Handle() const
+	{
+		return mPass;
+	}
+
+	void RenderGraph::Initialize(VkDevice device, DeviceMemoryAllocator& allocator)
+	{
+		mDevice = device;
+		mAllocator = &allocator;
+	}
+
+	RenderGraph::ResourceHandle RenderGraph::CreateImage(const std::string& name, const ImageDesc& desc)
+	{
+		Resource resource;
+		resource.name = name;
+		resource.desc = desc;
+		mResources.push_back(resource);
+		return static_cast<ResourceHandle>(mResources.size() - 1);
+	}
+
+	RenderGraph::ResourceHandle RenderGraph::ImportImage(const std::string& name, const ImageDesc& desc, const std::vector<VkImage>& images, const std::vector<VkImageView>& views, VkImageLayout finalLayout)
+	{
+		if (images.empty() || images.size() != views.size())
+		{
+			throw std::invalid_argument("imported render graph image needs one view per image!");
+		}
+
+		Resource resource;
+		resource.name = name;
+		resource.desc = desc;
+		resource.imported = true;
+		resource.finalLayout = finalLayout;
+		resource.images = images;
+		resource.views = views;
+		mResources.push_back(resource);
+		return static_cast<ResourceHandle>(mResources.size() - 1);
+	}
+
+	RenderGraph::PassBuilder RenderGraph::AddPass(const std::string& name)
+	{
+		Pass pass;
+		pass.name = name;
+		mPasses.push_back(pass);
+		return PassBuilder(*this, static_cast<PassHandle>(mPasses.size() - 1));
+	}
+
+	void RenderGraph::Compile()
+	{
+		if (mDevice == VK_NULL_HANDLE)
+		{
+			throw std::runtime_error("render graph compiled before being initialized!");
+		}
+
+		CullPasses();
+		ComputeLifetimes();
+		CreateImages();
+		AliasMemory();
+		CreateRenderPasses();
+		CreateFramebuffers();
+		DeriveBarriers();
+	}
+
+	void RenderGraph::Execute(VkCommandBuffer commandBuffer, uint32_t imageIndex) const
+	{
+		for (const Pass& pass : mPasses)
+		{
+			if (pass.culled)
+			{
+				continue;
+			}
+
+			RecordBarriers(commandBuffer, pass.barriers, imageIndex);
+
+			VkRenderPassBeginInfo renderPassInfo = {};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = pass.renderPass;
+			renderPassInfo.framebuffer = pass.framebuffers[imageIndex % pass.framebuffers.size()];
+			renderPassInfo.renderArea.offset = { 0, 0 };
+			renderPassInfo.renderArea.extent = pass.extent;
+			renderPassInfo.clearValueCount = static_cast<uint32_t>(pass.clearValues.size());
+			renderPassInfo.pClearValues = pass.clearValues.data();
+
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, pass.contents);
+			if (pass.execute)
+			{
+				pass.execute(commandBuffer);
+			}
+			vkCmdEndRenderPass(commandBuffer);
+		}
+
+		RecordBarriers(commandBuffer, mFinalBarriers, imageIndex);
+	}
+
+	void RenderGraph::SetImageExtent(ResourceHandle resource, VkExtent2D extent)
+	{
+		if (mResources.at(resource).imported)
+		{
+			throw std::invalid_argument("imported render graph image must be replaced, not resized!");
+		}
+		mResources[resource].desc.extent = extent;
+	}
+
+	void RenderGraph::ReplaceImportedImage(ResourceHandle resource, VkExtent2D extent, const std::vector<VkImage>& images, const std::vector<VkImageView>& views)
+	{
+		if (!mResources.at(resource).imported)
+		{
+			throw std::invalid_argument("only imported render graph images can be replaced!");
+		}
+		if (images.empty() || images.size() != views.size())
+		{
+			throw std::invalid_argument("imported render graph image needs one view per image!");
+		}
+
+		Resource& imported = mResources[resource];
+		imported.desc.extent = extent;
+		imported.images = images;
+		imported.views = views;
+	}
+
+	void RenderGraph::Resize(uint64_t releaseFrame)
+	{
+		RetiredObjects retired;
+		retired.releaseFrame = releaseFrame;
+		RetireFramebuffers(retired);
+		RetireImages(retired);
+		mRetired.push_back(std::move(retired));
+
+		// Lifetimes & usage only depend on declarations, so images come back with same aliasing as before
+		CreateImages();
+		AliasMemory();
+		CreateFramebuffers();
+	}
+
+	void RenderGraph::ReleaseRetired(uint64_t frame)
+	{
+		auto released = std::remove_if(mRetired.begin(), mRetired.end(), [this, frame](RetiredObjects& retired)
+		{
+			if (retired.releaseFrame > frame)
+			{
+				return false;
+			}
+			Destroy(retired);
+			return true;
+		});
+		mRetired.erase(released, mRetired.end());
+	}
+
+	void RenderGraph::Reset()
+	{
+		RetiredObjects current;
+		RetireFramebuffers(current);
+		RetireImages(current);
+		Destroy(current);
+		ReleaseRetired(UINT64_MAX);
+		for (Pass& pass : mPasses)
+		{
+			vkDestroyRenderPass(mDevice, pass.renderPass, nullptr);
+		}
+
+		mPasses.clear();
+		mResources.clear();
+		mMemorySlots.clear();
+		mFinalBarriers.clear();
+	}
+
+	VkRenderPass RenderGraph::RenderPass(PassHandle pass) const
+	{
+		return mPasses.at(pass).renderPass;
+	}
+
+	VkFramebuffer RenderGraph::Framebuffer(PassHandle pass, uint32_t imageIndex) const
+	{
+		const std::vector<VkFramebuffer>& framebuffers = mPasses.at(pass).framebuffers;
+		return framebuffers.empty() ? VK_NULL_HANDLE : framebuffers[imageIndex % framebuffers.size()];
+	}
+
+	VkImageView RenderGraph::ImageView(ResourceHandle resource) const
+	{
+		const std::vector<VkImageView>& views = mResources.at(resource).views;
+		return views.empty() ? VK_NULL_HANDLE : views.front();
+	}
+
+	bool RenderGraph::IsCulled(PassHandle pass) const
+	{
+		return mPasses.at(pass).culled;
+	}
+
+	VkDeviceSize RenderGraph::TransientMemoryRequired() const
+	{
+		VkDeviceSize size = 0;
+		for (const Resource& resource : mResources)
+		{
+			if (resource.memorySlot != UINT32_MAX)
+			{
+				size += resource.memoryRequirements.size;
+			}
+		}
+		return size;
+	}
+
+	VkDeviceSize RenderGraph::TransientMemoryAllocated() const
+	{
+		VkDeviceSize size = 0;
+		for (const MemorySlot& slot : mMemorySlots)
+		{
+			size += slot.size;
+		}
+		return size;
+	}
+
+	RenderGraph::ResourceState RenderGraph::StateOf(AccessType type, VkImageAspectFlags aspect)
+	{
+		ResourceState state;
+		switch (type)
+		{
+		case AccessType::ColorAttachment:
+		case AccessType::ResolveAttachment:
+			state.stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			state.access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			state.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			break;
+		case AccessType::DepthAttachment:
+			state.stage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			state.access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			state.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			break;
+		case AccessType::SampledTexture:
+			state.stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			state.access = VK_ACCESS_SHADER_READ_BIT;
+			state.layout = (aspect & VK_IMAGE_ASPECT_DEPTH_BIT) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			break;
+		}
+		return state;
+	}
+
+	bool RenderGraph::IsWrite(AccessType type)
+	{
+		return type != AccessType::SampledTexture;
+	}
+
+	void RenderGraph::CullPasses()
+	{
+		// Walk passes backwards starting from imported images. A pass survives if it writes an image
+		// something later needs, and then everything it reads or loads becomes needed in turn.
+		std::vector<bool> needed(mResources.size(), false);
+		for (size_t i = 0; i < mResources.size(); ++i)
+		{
+			needed[i] = mResources[i].imported;
+		}
+
+		for (size_t i = mPasses.size(); i-- > 0;)
+		{
+			Pass& pass = mPasses[i];
+			pass.culled = true;
+			for (const Access& access : pass.accesses)
+			{
+				if (IsWrite(access.type) && needed[access.resource])
+				{
+					pass.culled = false;
+				}
+			}
+
+			if (pass.culled)
+			{
+				continue;
+			}
+
+			for (const Access& access : pass.accesses)
+			{
+				if (!IsWrite(access.type) || access.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
+				{
+					needed[access.resource] = true;
+				}
+			}
+		}
+	}
+
+	void RenderGraph::ComputeLifetimes()
+	{
+		for (uint32_t i = 0; i < mPasses.size(); ++i)
+		{
+			if (mPasses[i].culled)
+			{
+				continue;
+			}
+
+			for (const Access& access : mPasses[i].accesses)
+			{
+				Resource& resource = mResources[access.resource];
+				resource.firstPass = std::min(resource.firstPass, i);
+				resource.lastPass = std::max(resource.lastPass, i);
+			}
+		}
+	}
+
+	void RenderGraph::CreateImages()
+	{
+		for (ResourceHandle handle = 0; handle < mResources.size(); ++handle)
+		{
+			Resource& resource = mResources[handle];
+			if (resource.imported || resource.firstPass == UINT32_MAX)
+			{
+				continue;
+			}
+
+			// Usage is derived from how surviving passes touch image. Images which are never sampled
+			// or loaded only live inside render passes & may use lazily allocated memory.
+			bool transient = true;
+			resource.usage = 0;
+			for (const Pass& pass : mPasses)
+			{
+				if (pass.culled)
+				{
+					continue;
+				}
+
+				for (const Access& access : pass.accesses)
+				{
+					if (access.resource != handle)
+					{
+						continue;
+					}
+
+					switch (access.type)
+					{
+					case AccessType::ColorAttachment:
+					case AccessType::ResolveAttachment:
+						resource.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+						break;
+					case AccessType::DepthAttachment:
+						resource.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+						break;
+					case AccessType::SampledTexture:
+						resource.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+						break;
+					}
+					transient = transient && IsWrite(access.type) && access.loadOp != VK_ATTACHMENT_LOAD_OP_LOAD;
+				}
+			}
+			if (transient)
+			{
+				resource.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+			}
+
+			VkImageCreateInfo imageInfo = {};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.extent.width = resource.desc.extent.width;
+			imageInfo.extent.height = resource.desc.extent.height;
+			imageInfo.extent.depth = 1;
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.format = resource.desc.format;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			imageInfo.usage = resource.usage;
+			imageInfo.samples = resource.desc.samples;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			VkImage image;
+			if (vkCreateImage(mDevice, &imageInfo, nullptr, &image) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create render graph image!");
+			}
+			resource.images.push_back(image);
+
+			vkGetImageMemoryRequirements(mDevice, image, &resource.memoryRequirements);
+		}
+	}
+
+	void RenderGraph::AliasMemory()
+	{
+		// Place biggest images first, each into first slot whose memory types match
+		// and whose occupants are all dead before it is first used or born after it is last used.
+		std::vector<ResourceHandle> order;
+		for (ResourceHandle i = 0; i < mResources.size(); ++i)
+		{
+			if (!mResources[i].imported && !mResources[i].images.empty())
+			{
+				order.push_back(i);
+			}
+		}
+		std::stable_sort(order.begin(), order.end(), [this](ResourceHandle lhs, ResourceHandle rhs)
+		{
+			return mResources[lhs].memoryRequirements.size > mResources[rhs].memoryRequirements.size;
+		});
+
+		for (ResourceHandle handle : order)
+		{
+			Resource& resource = mResources[handle];
+			uint32_t slotIndex = UINT32_MAX;
+
+			for (uint32_t s = 0; s < mMemorySlots.size() && slotIndex == UINT32_MAX; ++s)
+			{
+				const MemorySlot& slot = mMemorySlots[s];
+				if ((slot.memoryTypeBits & resource.memoryRequirements.memoryTypeBits) == 0)
+				{
+					continue;
+				}
+
+				bool overlaps = false;
+				for (ResourceHandle occupant : slot.occupants)
+				{
+					const Resource& other = mResources[occupant];
+					overlaps = overlaps || !(other.lastPass < resource.firstPass || resource.lastPass < other.firstPass);
+				}
+				if (!overlaps)
+				{
+					slotIndex = s;
+				}
+			}
+
+			if (slotIndex == UINT32_MAX)
+			{
+				MemorySlot slot;
+				slot.memoryTypeBits = resource.memoryRequirements.memoryTypeBits;
+				mMemorySlots.push_back(slot);
+				slotIndex = static_cast<uint32_t>(mMemorySlots.size() - 1);
+			}
+
+			MemorySlot& slot = mMemorySlots[slotIndex];
+			slot.memoryTypeBits &= resource.memoryRequirements.memoryTypeBits;
+			slot.size = std::max(slot.size, resource.memoryRequirements.size);
+			slot.alignment = std::max(slot.alignment, resource.memoryRequirements.alignment);
+			slot.occupants.push_back(handle);
+			resource.memorySlot = slotIndex;
+		}
+
+		for (MemorySlot& slot : mMemorySlots)
+		{
+			// Occupants in execution order, so each one knows whose memory it takes over
+			std::sort(slot.occupants.begin(), slot.occupants.end(), [this](ResourceHandle lhs, ResourceHandle rhs)
+			{
+				return mResources[lhs].firstPass < mResources[rhs].firstPass;
+			});
+
+			// Attachments are large & recreated with swapchain, so they get dedicated memory instead of fragmenting blocks
+			VkMemoryRequirements slotRequirements = {};
+			slotRequirements.size = slot.size;
+			slotRequirements.alignment = slot.alignment;
+			slotRequirements.memoryTypeBits = slot.memoryTypeBits;
+			slot.allocation = mAllocator->Allocate(slotRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DeviceMemoryAllocator::ResourceKind::Optimal, true);
+
+			for (ResourceHandle occupant : slot.occupants)
+			{
+				Resource& resource = mResources[occupant];
+				vkBindImageMemory(mDevice, resource.images.front(), slot.allocation.memory, slot.allocation.offset);
+
+				VkImageViewCreateInfo viewInfo = {};
+				viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				viewInfo.image = resource.images.front();
+				viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+				viewInfo.format = resource.desc.format;
+				// Sampled depth/stencil views may only expose depth aspect
+				viewInfo.subresourceRange.aspectMask = (resource.desc.aspect & VK_IMAGE_ASPECT_DEPTH_BIT) ? VK_IMAGE_ASPECT_DEPTH_BIT : resource.desc.aspect;
+				viewInfo.subresourceRange.baseMipLevel = 0;
+				viewInfo.subresourceRange.levelCount = 1;
+				viewInfo.subresourceRange.baseArrayLayer = 0;
+				viewInfo.subresourceRange.layerCount = 1;
+
+				VkImageView view;
+				if (vkCreateImageView(mDevice, &viewInfo, nullptr, &view) != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to create render graph image view!");
+				}
+				resource.views.push_back(view);
+			}
+		}
+	}
+
+	void RenderGraph::CreateRenderPasses()
+	{
+		for (uint32_t p = 0; p < mPasses.size(); ++p)
+		{
+			Pass& pass = mPasses[p];
+			if (pass.culled)
+			{
+				continue;
+			}
+
+			std::vector<VkAttachmentDescription> attachments;
+			std::vector<ResourceHandle> attachmentResources;
+			std::vector<VkAttachmentReference> colorReferences;
+			std::vector<VkAttachmentReference> resolveReferences;
+			VkAttachmentReference depthReference = {};
+			bool hasDepth = false;
+
+			pass.clearValues.clear();
+			for (const Access& access : pass.accesses)
+			{
+				if (access.type == AccessType::SampledTexture)
+				{
+					continue;
+				}
+
+				const Resource& resource = mResources[access.resource];
+				ResourceState state = StateOf(access.type, resource.desc.aspect);
+
+				// Contents only need storing when a later pass samples or loads them, or image leaves graph.
+				bool readLater = resource.imported;
+				for (uint32_t later = p + 1; later < mPasses.size() && !readLater; ++later)
+				{
+					if (mPasses[later].culled)
+					{
+						continue;
+					}
+					for (const Access& laterAccess : mPasses[later].accesses)
+					{
+						readLater = readLater || (laterAccess.resource == access.resource && (!IsWrite(laterAccess.type) || laterAccess.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD));
+					}
+				}
+
+				// Layout transitions are recorded as barriers by Execute(), so render pass keeps attachment layout.
+				VkAttachmentDescription attachment = {};
+				attachment.format = resource.desc.format;
+				attachment.samples = resource.desc.samples;
+				attachment.loadOp = access.type == AccessType::ResolveAttachment ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : access.loadOp;
+				attachment.storeOp = readLater ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				attachment.initialLayout = state.layout;
+				attachment.finalLayout = state.layout;
+
+				VkAttachmentReference reference = {};
+				reference.attachment = static_cast<uint32_t>(attachments.size());
+				reference.layout = state.layout;
+
+				switch (access.type)
+				{
+				case AccessType::ColorAttachment:
+					colorReferences.push_back(reference);
+					break;
+				case AccessType::ResolveAttachment:
+					resolveReferences.push_back(reference);
+					break;
+				case AccessType::DepthAttachment:
+					depthReference = reference;
+					hasDepth = true;
+					break;
+				default:
+					break;
+				}
+
+				attachments.push_back(attachment);
+				attachmentResources.push_back(access.resource);
+				pass.clearValues.push_back(access.clearValue);
+			}
+
+			if (!resolveReferences.empty() && resolveReferences.size() != colorReferences.size())
+			{
+				throw std::runtime_error("render graph pass " + pass.name + " must resolve every color attachment!");
+			}
+
+			VkSubpassDescription subpass = {};
+			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			subpass.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
+			subpass.pColorAttachments = colorReferences.data();
+			subpass.pResolveAttachments = resolveReferences.empty() ? nullptr : resolveReferences.data();
+			subpass.pDepthStencilAttachment = hasDepth ? &depthReference : nullptr;
+
+			VkRenderPassCreateInfo renderPassInfo = {};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+			renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+			renderPassInfo.pAttachments = attachments.data();
+			renderPassInfo.subpassCount = 1;
+			renderPassInfo.pSubpasses = &subpass;
+
+			if (vkCreateRenderPass(mDevice, &renderPassInfo, nullptr, &pass.renderPass) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create render pass!");
+			}
+
+			pass.attachments = attachmentResources;
+		}
+	}
+
+	void RenderGraph::CreateFramebuffers()
+	{
+		for (Pass& pass : mPasses)
+		{
+			if (pass.culled)
+			{
+				continue;
+			}
+
+			// Framebuffer takes extent of first attachment, so it follows resized images
+			pass.extent = mResources[pass.attachments.front()].desc.extent;
+
+			// Passes touching an imported image get one framebuffer per imported image
+			size_t framebufferCount = 1;
+			for (ResourceHandle handle : pass.attachments)
+			{
+				framebufferCount = std::max(framebufferCount, mResources[handle].views.size());
+			}
+
+			pass.framebuffers.resize(framebufferCount);
+			for (size_t f = 0; f < framebufferCount; ++f)
+			{
+				std::vector<VkImageView> views;
+				for (ResourceHandle handle : pass.attachments)
+				{
+					const std::vector<VkImageView>& resourceViews = mResources[handle].views;
+					views.push_back(resourceViews[f % resourceViews.size()]);
+				}
+
+				VkFramebufferCreateInfo framebufferInfo = {};
+				framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+				framebufferInfo.renderPass = pass.renderPass;
+				framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+				framebufferInfo.pAttachments = views.data();
+				framebufferInfo.width = pass.extent.width;
+				framebufferInfo.height = pass.extent.height;
+				framebufferInfo.layers = 1;
+
+				if (vkCreateFramebuffer(mDevice, &framebufferInfo, nullptr, &pass.framebuffers[f]) != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to create framebuffer!");
+				}
+			}
+		}
+	}
+
+	void RenderGraph::RetireFramebuffers(RetiredObjects& retired)
+	{
+		for (Pass& pass : mPasses)
+		{
+			retired.framebuffers.insert(retired.framebuffers.end(), pass.framebuffers.begin(), pass.framebuffers.end());
+			pass.framebuffers.clear();
+		}
+	}
+
+	void RenderGraph::RetireImages(RetiredObjects& retired)
+	{
+		for (Resource& resource : mResources)
+		{
+			if (resource.imported)
+			{
+				continue;
+			}
+			retired.views.insert(retired.views.end(), resource.views.begin(), resource.views.end());
+			retired.images.insert(retired.images.end(), resource.images.begin(), resource.images.end());
+			resource.views.clear();
+			resource.images.clear();
+			resource.memorySlot = UINT32_MAX;
+		}
+
+		for (MemorySlot& slot : mMemorySlots)
+		{
+			retired.allocations.push_back(slot.allocation);
+		}
+		mMemorySlots.clear();
+	}
+
+	void RenderGraph::Destroy(RetiredObjects& retired)
+	{
+		for (VkFramebuffer framebuffer : retired.framebuffers)
+		{
+			vkDestroyFramebuffer(mDevice, framebuffer, nullptr);
+		}
+		for (VkImageView view : retired.views)
+		{
+			vkDestroyImageView(mDevice, view, nullptr);
+		}
+		for (VkImage image : retired.images)
+		{
+			vkDestroyImage(mDevice, image, nullptr);
+		}
+		for (DeviceMemoryAllocator::Allocation& allocation : retired.allocations)
+		{
+			mAllocator->Free(allocation);
+		}
+		retired = RetiredObjects();
+	}
+
+	void RenderGraph::DeriveBarriers()
+	{
+		std::vector<ResourceState> states(mResources.size());
+		std::vector<bool> touched(mResources.size(), false);
+		std::vector<bool> written(mResources.size(), false);
+
+		for (Pass& pass : mPasses)
+		{
+			pass.barriers.clear();
+			if (pass.culled)
+			{
+				continue;
+			}
+
+			for (const Access& access : pass.accesses)
+			{
+				const Resource& resource = mResources[access.resource];
+				ResourceState required = StateOf(access.type, resource.desc.aspect);
+
+				if (!touched[access.resource])
+				{
+					if (!IsWrite(access.type) || access.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
+					{
+						throw std::runtime_error("render graph image " + resource.name + " is read before being written!");
+					}
+
+					// Contents are discarded, so only previous user of same memory has to be done with it.
+					// For imported images that is presentation engine, waited on by acquire semaphore at first use stage.
+					// For transient ones it is last use of previous occupant of memory slot, possibly from previous frame.
+					ResourceState previous;
+					previous.stage = required.stage;
+					if (!resource.imported)
+					{
+						const std::vector<ResourceHandle>& occupants = mMemorySlots[resource.memorySlot].occupants;
+						size_t position = static_cast<size_t>(std::find(occupants.begin(), occupants.end(), access.resource) - occupants.begin());
+						ResourceHandle predecessor = occupants[(position + occupants.size() - 1) % occupants.size()];
+						const Resource& previousResource = mResources[predecessor];
+
+						previous.stage = 0;
+						for (const Access& lastAccess : mPasses[previousResource.lastPass].accesses)
+						{
+							if (lastAccess.resource == predecessor)
+							{
+								ResourceState lastState = StateOf(lastAccess.type, previousResource.desc.aspect);
+								previous.stage |= lastState.stage;
+								previous.access |= IsWrite(lastAccess.type) ? lastState.access : 0;
+							}
+						}
+					}
+					previous.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+					pass.barriers.push_back({ access.resource, previous, required });
+					states[access.resource] = required;
+				}
+				else if (states[access.resource].layout != required.layout || written[access.resource] || IsWrite(access.type))
+				{
+					pass.barriers.push_back({ access.resource, states[access.resource], required });
+					states[access.resource] = required;
+				}
+				else
+				{
+					// Read after read in same layout needs no barrier
+					states[access.resource].stage |= required.stage;
+					states[access.resource].access |= required.access;
+				}
+
+				touched[access.resource] = true;
+				written[access.resource] = IsWrite(access.type);
+			}
+		}
+
+		mFinalBarriers.clear();
+		for (ResourceHandle i = 0; i < mResources.size(); ++i)
+		{
+			if (mResources[i].imported && touched[i])
+			{
+				ResourceState finalState;
+				finalState.stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+				finalState.access = 0;
+				finalState.layout = mResources[i].finalLayout;
+				mFinalBarriers.push_back({ i, states[i], finalState });
+			}
+		}
+	}
+
+	void RenderGraph::RecordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier>& barriers, uint32_t imageIndex) const
+	{
+		if (barriers.empty())
+		{
+			return;
+		}
+
+		VkPipelineStageFlags sourceStage = 0;
+		VkPipelineStageFlags destinationStage = 0;
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+		imageBarriers.reserve(barriers.size());
+
+		for (const Barrier& barrier : barriers)
+		{
+			const Resource& resource = mResources[barrier.resource];
+
+			VkImageMemoryBarrier imageBarrier = {};
+			imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			imageBarrier.oldLayout = barrier.source.layout;
+			imageBarrier.newLayout = barrier.destination.layout;
+			imageBarrier.srcAccessMask = barrier.source.access;
+			imageBarrier.dstAccessMask = barrier.destination.access;
+			imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.image = resource.images[imageIndex % resource.images.size()];
+			imageBarrier.subresourceRange.aspectMask = resource.desc.aspect;
+			imageBarrier.subresourceRange.baseMipLevel = 0;
+			imageBarrier.subresourceRange.levelCount = 1;
+			imageBarrier.subresourceRange.baseArrayLayer = 0;
+			imageBarrier.subresourceRange.layerCount = 1;
+			imageBarriers.push_back(imageBarrier);
+
+			sourceStage |= barrier.source.stage;
+			destinationStage |= barrier.destination.stage;
+		}
+
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			sourceStage, destinationStage,
+			0,
+			0, nullptr,
+			0, nullptr,
+			static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data()
+		);
+	}
+}
@@ -0,0 +1,267 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+#include "DeviceMemoryAllocator.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Frame graph owning render passes, framebuffers & transient attachments.
+	/// Passes declare images they read & write. Compile() culls passes which don't contribute to an imported image,
+	/// derives layout transitions & barriers between passes, and aliases memory of transient images whose lifetimes don't overlap.
+	/// </summary>
+	class RenderGraph final
+	{
+	public:
+		using ResourceHandle = uint32_t;
+		using PassHandle = uint32_t;
+		using ExecuteCallback = std::function<void(VkCommandBuffer commandBuffer)>;
+
+		struct ImageDesc
+		{
+			VkFormat format = VK_FORMAT_UNDEFINED;
+			VkExtent2D extent = {};
+			VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+			VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+		};
+
+		/// <summary>
+		/// Declares reads & writes of a single pass. Passes execute in declaration order.
+		/// </summary>
+		class PassBuilder
+		{
+		public:
+			/// <summary>Renders into image as color attachment.</summary>
+			/// <param name="resource">Image written.</param>
+			/// <param name="loadOp">CLEAR or DONT_CARE discard previous contents, LOAD keeps what earlier passes wrote.</param>
+			/// <param name="clearValue">Clear color used with CLEAR.</param>
+			/// <returns>Reference to this builder.</returns>
+			PassBuilder& WriteColor(ResourceHandle resource, VkAttachmentLoadOp loadOp, VkClearColorValue clearValue = {});
+
+			/// <summary>Renders into image as depth attachment.</summary>
+			/// <param name="resource">Image written.</param>
+			/// <param name="loadOp">CLEAR or DONT_CARE discard previous contents, LOAD keeps what earlier passes wrote.</param>
+			/// <param name="clearValue">Clear depth & stencil used with CLEAR.</param>
+			/// <returns>Reference to this builder.</returns>
+			PassBuilder& WriteDepth(ResourceHandle resource, VkAttachmentLoadOp loadOp, VkClearDepthStencilValue clearValue = { 1.0f, 0 });
+
+			/// <summary>Resolves multisampled color attachment declared at same position into image.</summary>
+			/// <param name="resource">Single sampled image written.</param>
+			/// <returns>Reference to this builder.</returns>
+			PassBuilder& WriteResolve(ResourceHandle resource);
+
+			/// <summary>Samples image written by an earlier pass from fragment shader.</summary>
+			/// <param name="resource">Image read.</param>
+			/// <returns>Reference to this builder.</returns>
+			PassBuilder& ReadTexture(ResourceHandle resource);
+
+			/// <summary>Sets callback recording draw commands inside render pass.</summary>
+			/// <param name="callback">Callback invoked between vkCmdBeginRenderPass & vkCmdEndRenderPass.</param>
+			/// <param name="contents">Whether callback records inline or executes secondary command buffers.</param>
+			/// <returns>Reference to this builder.</returns>
+			PassBuilder& SetExecute(ExecuteCallback callback, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+
+			PassHandle Handle() const;
+
+		private:
+			friend class RenderGraph;
+			PassBuilder(RenderGraph& graph, PassHandle pass);
+
+			RenderGraph& mGraph;
+			PassHandle mPass;
+		};
+
+		RenderGraph() = default;
+		RenderGraph(const RenderGraph&) = delete;
+		RenderGraph& operator=(const RenderGraph&) = delete;
+		RenderGraph(RenderGraph&&) = delete;
+		RenderGraph& operator=(RenderGraph&&) = delete;
+		~RenderGraph() = default;
+
+		/// <summary>Sets device used to create images, render passes & framebuffers.</summary>
+		/// <param name="device">Logical device.</param>
+		/// <param name="allocator">Allocator transient image memory is taken from.</param>
+		void Initialize(VkDevice device, DeviceMemoryAllocator& allocator);
+
+		/// <summary>Declares a transient image owned by graph. Its contents don't survive past end of frame.</summary>
+		/// <param name="name">Debug name.</param>
+		/// <param name="desc">Format, extent, sample count & aspect of image. Usage is derived from declared accesses.</param>
+		/// <returns>Handle of image.</returns>
+		ResourceHandle CreateImage(const std::string& name, const ImageDesc& desc);
+
+		/// <summary>Declares an image owned outside graph, e.g. swapchain images. Passes writing it are never culled.</summary>
+		/// <param name="name">Debug name.</param>
+		/// <param name="desc">Format, extent, sample count & aspect of image.</param>
+		/// <param name="images">One image per index passed to Execute().</param>
+		/// <param name="views">One view per image.</param>
+		/// <param name="finalLayout">Layout image is left in at end of frame.</param>
+		/// <returns>Handle of image.</returns>
+		ResourceHandle ImportImage(const std::string& name, const ImageDesc& desc, const std::vector<VkImage>& images, const std::vector<VkImageView>& views, VkImageLayout finalLayout);
+
+		/// <summary>Declares a new pass executed after all previously declared passes.</summary>
+		/// <param name="name">Debug name.</param>
+		/// <returns>Builder declaring reads & writes of pass.</returns>
+		PassBuilder AddPass(const std::string& name);
+
+		/// <summary>Culls passes, allocates & aliases transient images, creates render passes & framebuffers and derives barriers.</summary>
+		void Compile();
+
+		/// <summary>Records barriers & render passes of all passes which were not culled.</summary>
+		/// <param name="commandBuffer">Primary command buffer in recording state.</param>
+		/// <param name="imageIndex">Index selecting which of imported images is used.</param>
+		void Execute(VkCommandBuffer commandBuffer, uint32_t imageIndex) const;
+
+		/// <summary>Changes extent of an image declared with CreateImage(). Takes effect on next Resize().</summary>
+		/// <param name="resource">Transient image.</param>
+		/// <param name="extent">New extent.</param>
+		void SetImageExtent(ResourceHandle resource, VkExtent2D extent);
+
+		/// <summary>Replaces images of an imported image, e.g. after swapchain was recreated. Takes effect on next Resize().</summary>
+		/// <param name="resource">Imported image.</param>
+		/// <param name="extent">Extent of new images.</param>
+		/// <param name="images">One image per index passed to Execute().</param>
+		/// <param name="views">One view per image.</param>
+		void ReplaceImportedImage(ResourceHandle resource, VkExtent2D extent, const std::vector<VkImage>& images, const std::vector<VkImageView>& views);
+
+		/// <summary>
+		/// Recreates transient images & framebuffers after extents or imported images changed. Render passes, culling & barriers are kept,
+		/// so pipelines & secondary command buffers created against render passes stay valid. Formats & sample counts must not change.
+		/// Previous images & framebuffers are retired, so frames in flight may keep using them.
+		/// </summary>
+		/// <param name="releaseFrame">Frame from which on previous images & framebuffers may be destroyed, see ReleaseRetired().</param>
+		void Resize(uint64_t releaseFrame);
+
+		/// <summary>Destroys images & framebuffers retired by Resize() once frames still using them are done.</summary>
+		/// <param name="frame">Caller's current frame number, objects whose release frame it reached are destroyed. UINT64_MAX destroys all.</param>
+		void ReleaseRetired(uint64_t frame);
+
+		/// <summary>Destroys every Vulkan object owned by graph, retired ones included, & forgets all declarations. GPU must be done using graph.</summary>
+		void Reset();
+
+		VkRenderPass RenderPass(PassHandle pass) const;
+		VkFramebuffer Framebuffer(PassHandle pass, uint32_t imageIndex) const;
+		VkImageView ImageView(ResourceHandle resource) const;
+		bool IsCulled(PassHandle pass) const;
+
+		/// <summary>Gets bytes transient images would need without aliasing.</summary>
+		VkDeviceSize TransientMemoryRequired() const;
+
+		/// <summary>Gets bytes actually allocated for transient images.</summary>
+		VkDeviceSize TransientMemoryAllocated() const;
+
+	private:
+		enum class AccessType
+		{
+			ColorAttachment,
+			DepthAttachment,
+			ResolveAttachment,
+			SampledTexture
+		};
+
+		struct Access
+		{
+			ResourceHandle resource;
+			AccessType type;
+			VkAttachmentLoadOp loadOp;
+			VkClearValue clearValue;
+		};
+
+		struct ResourceState
+		{
+			VkPipelineStageFlags stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			VkAccessFlags access = 0;
+			VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		};
+
+		struct Barrier
+		{
+			ResourceHandle resource;
+			ResourceState source;
+			ResourceState destination;
+		};
+
+		struct Resource
+		{
+			std::string name;
+			ImageDesc desc;
+			bool imported = false;
+			VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			// Imported resources hold one image per imageIndex, transient ones exactly one
+			std::vector<VkImage> images;
+			std::vector<VkImageView> views;
+
+			VkImageUsageFlags usage = 0;
+			VkMemoryRequirements memoryRequirements = {};
+			uint32_t memorySlot = UINT32_MAX;
+
+			// Indices of first & last pass using resource, culled passes excluded
+			uint32_t firstPass = UINT32_MAX;
+			uint32_t lastPass = 0;
+		};
+
+		struct Pass
+		{
+			std::string name;
+			std::vector<Access> accesses;
+			ExecuteCallback execute;
+			VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE;
+			bool culled = false;
+
+			VkRenderPass renderPass = VK_NULL_HANDLE;
+			// Resources bound to attachments of render pass, in attachment order
+			std::vector<ResourceHandle> attachments;
+			std::vector<VkFramebuffer> framebuffers;
+			std::vector<VkClearValue> clearValues;
+			VkExtent2D extent = {};
+			std::vector<Barrier> barriers;
+		};
+
+		// One allocation shared by transient images whose lifetimes don't overlap
+		struct MemorySlot
+		{
+			DeviceMemoryAllocator::Allocation allocation;
+			VkDeviceSize size = 0;
+			VkDeviceSize alignment = 1;
+			uint32_t memoryTypeBits = 0;
+			std::vector<ResourceHandle> occupants;
+		};
+
+		// Objects replaced by Resize() which frames in flight may still be using
+		struct RetiredObjects
+		{
+			std::vector<VkFramebuffer> framebuffers;
+			std::vector<VkImageView> views;
+			std::vector<VkImage> images;
+			std::vector<DeviceMemoryAllocator::Allocation> allocations;
+			uint64_t releaseFrame = 0;
+		};
+
+		static ResourceState StateOf(AccessType type, VkImageAspectFlags aspect);
+		static bool IsWrite(AccessType type);
+
+		void CullPasses();
+		void ComputeLifetimes();
+		void CreateImages();
+		void AliasMemory();
+		void CreateRenderPasses();
+		void CreateFramebuffers();
+		void RetireFramebuffers(RetiredObjects& retired);
+		void RetireImages(RetiredObjects& retired);
+		void Destroy(RetiredObjects& retired);
+		void DeriveBarriers();
+		void RecordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier>& barriers, uint32_t imageIndex) const;
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		DeviceMemoryAllocator* mAllocator = nullptr;
+
+		std::vector<Resource> mResources;
+		std::vector<Pass> mPasses;
+		std::vector<MemorySlot> mMemorySlots;
+		std::vector<Barrier> mFinalBarriers;
+		std::vector<RetiredObjects> mRetired;
+	};
+}
@@ -1,24 +1,20 @@
 #include "RendererC.h"
 #include <iostream>
-#include <fstream>
 #include <stdexcept>
 #include <algorithm>
 #include <chrono>
 #include <limits>
 #include <cstring>
-#include <unordered_map>
+#include <cmath>
+#include <filesystem>
 
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_vulkan.h"
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
-
 #pragma warning(push)
 #pragma warning(disable:4201)
 #define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #pragma warning(pop)
 
@@ -27,16 +23,16 @@
 
 #include "FirstPersonCamera.h"
 #include "Projector.h"
+#include "MeshCache.h"
+#include "VertexPacking.h"
+#include "ObjParser.h"
+#include "VertexWelder.h"
+#include "MeshOptimizer.h"
+#include "MipGenerator.h"
+#include "TextureCompressor.h"
+#include "Ktx2Texture.h"
 
 
-namespace std {
-	template<> struct hash<AlphonsoGraphicsEngine::RendererC::Vertex> {
-		size_t operator()(AlphonsoGraphicsEngine::RendererC::Vertex const& vertex) const {
-			return ((hash<glm::vec3>()(vertex.pos) ^ (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^ (hash<glm::vec2>()(vertex.texCoord) << 1);
-		}
-	};
-}
-
 namespace AlphonsoGraphicsEngine
 {
 	VkResult CreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDebugUtilsMessengerEXT* pDebugMessenger)
@@ -75,26 +71,6 @@ namespace AlphonsoGraphicsEngine
 		app->framebufferResized = true;
 	}
 
-	static std::vector<char> readFile(const std::string& filename)
-	{
-		std::ifstream file(filename, std::ios::ate | std::ios::binary);
-
-		if (!file.is_open())
-		{
-			throw std::runtime_error("failed to open file!");
-		}
-
-		size_t fileSize = (size_t)file.tellg();
-		std::vector<char> buffer(fileSize);
-
-		file.seekg(0);
-		file.read(buffer.data(), fileSize);
-
-		file.close();
-
-		return buffer;
-	}
-
 
 	RendererC::RendererC()
 	{
@@ -104,7 +80,9 @@ namespace AlphonsoGraphicsEngine
 	void RendererC::Run()
 	{
 		mRendererInstance = this;
+		mSimulationThread.Start([this](const GameTime& gameTime) { Update(gameTime); });
 		mainLoop();
+		mSimulationThread.Stop();
 		Shutdown();
 	}
 
@@ -112,12 +90,37 @@ namespace AlphonsoGraphicsEngine
 	{
 		mGameClock.Reset();
 		mGameClock.UpdateGameTime(mGameTime);
+		InitializeAssets();
 		InitializeWindow();
 		InitializeCamera();
 		InitializeVulkan();
 		InitializeProjector();
 		InitializeImgui((float)WIDTH, float(HEIGHT));
-		InitializeProxyModelsTransform();
+		InitializeScene();
+
+		// Render thread needs a snapshot before simulation thread publishes its first one
+		publishRenderSnapshot();
+		mRenderSnapshot = &mRenderSnapshots.AcquireLatest();
+	}
+
+	void RendererC::InitializeAssets()
+	{
+		if (!assets.Initialize())
+		{
+			throw std::runtime_error("failed to find assets!");
+		}
+		shaderCompiler.Initialize(assets);
+		lastShaderPoll = std::chrono::steady_clock::now();
+	}
+
+	AssetFileSystem::File RendererC::readAsset(const std::string& name) const
+	{
+		AssetFileSystem::File file = assets.Read(name);
+		if (!file)
+		{
+			throw std::runtime_error("failed to open file!");
+		}
+		return file;
 	}
 
 	void RendererC::InitializeImgui(float width, float height)
@@ -128,7 +131,11 @@ namespace AlphonsoGraphicsEngine
 		IMGUI_CHECKVERSION();
 		ImGui::CreateContext();
 		ImGuiIO& io = ImGui::GetIO(); (void)io;
-		io.Fonts->AddFontFromFileTTF("../../Assets/Fonts/Roboto-Medium.ttf", 16.0f);
+		// Atlas reads font straight from asset pack, so it mustn't try to free it
+		fontFile = readAsset(FONT_PATH);
+		ImFontConfig fontConfig;
+		fontConfig.FontDataOwnedByAtlas = false;
+		io.Fonts->AddFontFromMemoryTTF(const_cast<uint8_t*>(fontFile.data), static_cast<int>(fontFile.size), 16.0f, &fontConfig);
 		io.DisplaySize = ImVec2(width, height);
 		io.DisplayFramebufferScale = ImVec2(1.0f, 1.0f);
 
@@ -140,11 +147,12 @@ namespace AlphonsoGraphicsEngine
 		init_info.Device = device;
 		init_info.QueueFamily = Indices.graphicsFamily.value();
 		init_info.Queue = presentQueue;
-		init_info.PipelineCache = VK_NULL_HANDLE;
+		init_info.PipelineCache = pipelineCache.Handle();
 		init_info.DescriptorPool = descriptorPool;
 		init_info.Allocator = NULL;
 		init_info.MinImageCount = 2;
-		init_info.ImageCount = static_cast<uint32_t>(swapChainImages.size());
+		// ImGui rotates its vertex & index buffers once per frame, so it needs a set for every frame which may be in flight
+		init_info.ImageCount = std::max(MAX_FRAMES_IN_FLIGHT, static_cast<uint32_t>(swapChainImages.size()));
 		init_info.CheckVkResultFn = NULL;
 		ImGui_ImplVulkan_Init(&init_info, renderPass);
 
@@ -159,9 +167,65 @@ namespace AlphonsoGraphicsEngine
 
 	void RendererC::Update(const GameTime& gameTime)
 	{
-		mGameClock.UpdateGameTime(mGameTime);
+		SimulationCommands commands;
+		{
+			std::lock_guard<std::mutex> lock(mSimulationCommandsMutex);
+			commands = mSimulationCommands;
+			mSimulationCommands.projectorPosition.reset();
+			mSimulationCommands.projectorDirection.reset();
+			mSimulationCommands.cameraAspectRatio.reset();
+		}
+
+		if (commands.cameraAspectRatio)
+		{
+			mCamera->SetAspectRatio(*commands.cameraAspectRatio);
+		}
+		if (commands.projectorPosition)
+		{
+			mProjector->SetPosition(*commands.projectorPosition);
+		}
+		if (commands.projectorDirection)
+		{
+			mProjector->SetDirection(commands.projectorDirection->x, commands.projectorDirection->y, commands.projectorDirection->z);
+		}
+
+		mCamera->SetInput(commands.input);
 		mCamera->Update(gameTime);
+		mProjector->SetInput(commands.input);
 		mProjector->Update(gameTime);
+		mScene.Update(mThreadPool);
+
+		publishRenderSnapshot();
+	}
+
+	void RendererC::publishRenderSnapshot()
+	{
+		RenderSnapshot& snapshot = mRenderSnapshots.BackBuffer();
+
+		snapshot.cameraView = mCamera->ViewMatrix();
+		snapshot.cameraProjection = mCamera->ProjectionMatrix();
+		snapshot.cameraPosition = mCamera->Position();
+		snapshot.cameraDirection = mCamera->Direction();
+
+		snapshot.projectorViewProjection = mProjector->ViewProjectionMatrix();
+		snapshot.projectorPosition = mProjector->Position();
+		snapshot.projectorDirection = mProjector->Direction();
+
+		snapshot.lightPosition = lightPos;
+
+		// Slot still holds items of the version it was last published with, a scene at rest isn't copied at all
+		if (snapshot.sceneVersion != mScene.Version())
+		{
+			snapshot.renderItems.resize(mScene.RenderableCount());
+			for (uint32_t i = 0; i < mScene.RenderableCount(); ++i)
+			{
+				snapshot.renderItems[i].model = mScene.WorldMatrix(mScene.RenderableEntity(i));
+				snapshot.renderItems[i].component = mScene.Renderable(i);
+			}
+			snapshot.sceneVersion = mScene.Version();
+		}
+
+		mRenderSnapshots.Publish();
 	}
 
 	void RendererC::InitializeWindow()
@@ -183,33 +247,30 @@ namespace AlphonsoGraphicsEngine
 		createSurface();
 		pickPhysicalDevice();
 		createLogicalDevice();
+		memoryAllocator.Initialize(physicalDevice, device);
+		createPipelineCache();
 		createSwapChain();
 		createImageViews();
-		createRenderPass();
+		createRenderGraph();
 		createDescriptorSetLayout();
 		createGraphicsPipeline();
 		createCommandPool();
-		createMSAAColorResources();
-		createDepthResources();
-		createShadowMap();
-		createFramebuffers();
-		createTextureImage();
-		createTextureImageView();
+		createUploadManager();
+		createTextureStreamer();
 		createTextureSampler();
-		loadModel(MODEL_PATH, vertices, indices);
-		loadModel(CUBE_MODEL_PATH, cubeVertices, cubeIndices);
-		createVertexBuffers();
-		createIndexBuffers();
+		createGeometryPool();
+		// Everything loaded so far is needed by first frame, so submit it regardless of frame budget
+		uploadManager.Flush(true);
 		createUniformBuffers();
 		createDescriptorPool();
 		createDescriptorSets();
-		createCommandBuffers();
-		createSyncObjects();
+		createFrameContexts();
 	}
 
 	void RendererC::Shutdown()
 	{
 		cleanup();
+		mScene.Shutdown();
 	}
 
 	void RendererC::InitializeCamera()
@@ -244,15 +305,22 @@ namespace AlphonsoGraphicsEngine
 		mProjector->Update(mGameTime);
 	}
 
-	void RendererC::InitializeProxyModelsTransform()
+	void RendererC::InitializeScene()
 	{
-		ProxyModelUniformBufferObject pmubo = {};
-		glm::mat4 model = glm::mat4(1.0);
-		model = glm::translate(model, glm::vec3(0.8,0.8,0.8));
-		model = glm::scale(model, glm::vec3(0.2,0.2,0.2));
-		glm::mat4 proxyProjection = mCamera->ProjectionMatrix();
-		proxyProjection[1][1] *= -1;
-		pmubo.mvp = proxyProjection * mCamera->ViewMatrix()* model;
+		mScene.Initialize(SCENE_ENTITY_CAPACITY);
+
+		Scene::Entity chalet = mScene.CreateEntity();
+		mScene.SetRenderComponent(chalet, { SCENE_MESH_CHALET, SCENE_MATERIAL_LIT, false });
+
+		Scene::Entity proxyModel = mScene.CreateEntity();
+		mScene.SetLocalTransform(proxyModel, glm::vec3(0.8f, 0.8f, 0.8f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.2f, 0.2f, 0.2f));
+		mScene.SetRenderComponent(proxyModel, { SCENE_MESH_CUBE, SCENE_MATERIAL_PROXY, false });
+
+		// Unit cube at origin is what shadow map has always been rendered from
+		Scene::Entity shadowCaster = mScene.CreateEntity();
+		mScene.SetRenderComponent(shadowCaster, { SCENE_MESH_CUBE, SCENE_MATERIAL_NONE, true });
+
+		mScene.Update(mThreadPool);
 	}
 
 	void RendererC::recreateImGuiWindow()
@@ -282,21 +350,39 @@ namespace AlphonsoGraphicsEngine
 
 		// render your GUI
 		ImGui::Begin("Alphonso Engine");
-		ImGui::Text("Camera Position: (%f, %f, %f) ", mCamera->Position().x, mCamera->Position().y, mCamera->Position().z);
-		ImGui::Text("Camera Direction: (%f, %f, %f) ", mCamera->Direction().x, mCamera->Direction().y, mCamera->Direction().z);
-		ImGui::Text("Projector Position: (%f, %f, %f) ", mProjector->Position().x, mProjector->Position().y, mProjector->Position().z);
-		ImGui::Text("Projector Direction: (%f, %f, %f) ", mProjector->Direction().x, mProjector->Direction().y, mProjector->Direction().z);
+		const RenderSnapshot& snapshot = *mRenderSnapshot;
+		ImGui::Text("Camera Position: (%f, %f, %f) ", snapshot.cameraPosition.x, snapshot.cameraPosition.y, snapshot.cameraPosition.z);
+		ImGui::Text("Camera Direction: (%f, %f, %f) ", snapshot.cameraDirection.x, snapshot.cameraDirection.y, snapshot.cameraDirection.z);
+		ImGui::Text("Projector Position: (%f, %f, %f) ", snapshot.projectorPosition.x, snapshot.projectorPosition.y, snapshot.projectorPosition.z);
+		ImGui::Text("Projector Direction: (%f, %f, %f) ", snapshot.projectorDirection.x, snapshot.projectorDirection.y, snapshot.projectorDirection.z);
+		DeviceMemoryAllocator::Stats memoryStats = memoryAllocator.GetStats();
+		ImGui::Text("Device Memory: %.1f / %.1f MB in %u allocations, %u blocks, %u dedicated", memoryStats.bytesAllocated / (1024.0 * 1024.0), memoryStats.bytesReserved / (1024.0 * 1024.0), memoryStats.allocationCount, memoryStats.blockCount, memoryStats.dedicatedAllocationCount);
+		ImGui::Text("Scene Objects: %u", static_cast<uint32_t>(snapshot.renderItems.size()));
+		ImGui::Text("Streamed Textures: %.1f / %.1f MB, model mip %u, projected mip %u", textureStreamer.ResidentBytes() / (1024.0 * 1024.0), TEXTURE_STREAMING_BUDGET / (1024.0 * 1024.0), textureStreamer.ResidentLevel(modelTexture), textureStreamer.ResidentLevel(projectedTexture));
 
 		ImGui::InputFloat3("Projector Position", mProjectorPosition, 4);
 		if (ImGui::SliderFloat3("Projector Position", mProjectorPosition, -10.0f, 10.0f))
 		{
-			mProjector->SetPosition(glm::vec3(mProjectorPosition[0], mProjectorPosition[1], mProjectorPosition[2]));
+			std::lock_guard<std::mutex> lock(mSimulationCommandsMutex);
+			mSimulationCommands.projectorPosition = glm::vec3(mProjectorPosition[0], mProjectorPosition[1], mProjectorPosition[2]);
 		}
 		ImGui::InputFloat3("Projector Direction", mProjectorDirection, 4);
 		if (ImGui::SliderFloat3("Projector Direction", mProjectorDirection, -100.0f, 100.0f))
 		{
-			mProjector->SetDirection(mProjectorDirection[0], mProjectorDirection[1], mProjectorDirection[2]);
+			std::lock_guard<std::mutex> lock(mSimulationCommandsMutex);
+			mSimulationCommands.projectorDirection = glm::vec3(mProjectorDirection[0], mProjectorDirection[1], mProjectorDirection[2]);
+		}
+		int framesInFlightSetting = static_cast<int>(framesInFlight);
+		if (ImGui::SliderInt("Frames In Flight", &framesInFlightSetting, 1, static_cast<int>(MAX_FRAMES_IN_FLIGHT)))
+		{
+			SetFramesInFlight(static_cast<uint32_t>(framesInFlightSetting));
 		}
+		// Every combination is drawn with its own pipeline permutation, compiled in background on first use
+		ImGui::CheckboxFlags("Projector", &sceneFeatureToggles, SCENE_FEATURE_PROJECTOR);
+		ImGui::CheckboxFlags("Shadows", &sceneFeatureToggles, SCENE_FEATURE_SHADOW);
+		ImGui::CheckboxFlags("Filtered Shadows", &sceneFeatureToggles, SCENE_FEATURE_SHADOW_PCF);
+		ImGui::CheckboxFlags("Point Light", &sceneFeatureToggles, SCENE_FEATURE_POINT_LIGHT);
+		ImGui::CheckboxFlags("Specular", &sceneFeatureToggles, SCENE_FEATURE_SPECULAR);
 		ImGui::End();
 		// Render dear imgui UI box into our window
 		ImGui::Render();
@@ -307,107 +393,25 @@ namespace AlphonsoGraphicsEngine
 		while (!glfwWindowShouldClose(window))
 		{
 			glfwPollEvents();
+
+			// GLFW input may only be queried on main thread, simulation thread picks this copy up on its next step
+			InputState input;
+			input.Sample(window);
+			{
+				std::lock_guard<std::mutex> lock(mSimulationCommandsMutex);
+				mSimulationCommands.input = input;
+			}
+			mRenderSnapshot = &mRenderSnapshots.AcquireLatest();
+
 			if (!isImGuiWindowCreated)
 			{
 				ImGuiSetupWindow();
 				isImGuiWindowCreated = true;
 			}
 
-			for (size_t i = 0; i < commandBuffers.size(); i++)
-			{
-				VkCommandBufferBeginInfo beginInfo = {};
-				beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-				beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-				if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS)
-				{
-					throw std::runtime_error("failed to begin recording command buffer!");
-				}
-
-				/*
-				First render pass: Generate shadow map by rendering the scene from light's POV
-				*/
-				{
-					std::array<VkClearValue, 2> clearValues = {};
-					clearValues[0].depthStencil = { 1.0f, 0 };
-
-					VkRenderPassBeginInfo renderPassBeginInfo = {};
-					renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-					renderPassBeginInfo.renderPass = shadowMapRenderPass;
-					renderPassBeginInfo.framebuffer = shadowMapFrameBuffer;
-					renderPassBeginInfo.renderArea.offset = { 0, 0 };
-					renderPassBeginInfo.renderArea.extent = swapChainExtent;
-					renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-					renderPassBeginInfo.pClearValues = clearValues.data();
-
-					vkCmdBeginRenderPass(commandBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-					// Set depth bias (aka "Polygon offset")
-					// Required to avoid shadow mapping artefacts
-					vkCmdSetDepthBias(commandBuffers[i], depthBiasConstant, 0.0f, depthBiasSlope);
-
-					vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, shadowMapPipeline);
-					vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, shadowMapPipelineLayout, 0, 1, &shadowMapPipelineDescriptorSet, 0, NULL);
-					VkBuffer vertexBuffers[] = { cubeVertexBuffer };
-					VkDeviceSize offsets[] = { 0 };
-					vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
-					vkCmdBindIndexBuffer(commandBuffers[i], cubeIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
-					vkCmdDrawIndexed(commandBuffers[i], static_cast<uint32_t>(cubeIndices.size()), 1, 0, 0, 0);
-
-					vkCmdEndRenderPass(commandBuffers[i]);
-				}
-
-
-				VkRenderPassBeginInfo renderPassInfo = {};
-				renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-				renderPassInfo.renderPass = renderPass;
-				renderPassInfo.framebuffer = swapChainFramebuffers[i];
-				renderPassInfo.renderArea.offset = { 0, 0 };
-				renderPassInfo.renderArea.extent = swapChainExtent;
-
-				std::array<VkClearValue, 2> clearValues = {};
-				clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
-				clearValues[1].depthStencil = { 1.0f, 0 };
-
-				renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-				renderPassInfo.pClearValues = clearValues.data();
-				vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-				// Draw Cube using Proxy Model pipeline
-				vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, proxyModelsPipeline);
-				VkBuffer cubeVertexBuffers[] = { cubeVertexBuffer };
-				VkDeviceSize cubeOffsets[] = { 0 };
-				vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, cubeVertexBuffers, cubeOffsets);
-				vkCmdBindIndexBuffer(commandBuffers[i], cubeIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
-				vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, proxyModelsPipelineLayout, 0, 1, &proxyModelDescriptorSets[i], 0, nullptr);
-				vkCmdDrawIndexed(commandBuffers[i], static_cast<uint32_t>(cubeIndices.size()), 1, 0, 0, 0);
-
-				// Bind model Pipeline to draw Chalet model
-				vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-				VkBuffer vertexBuffers[] = { vertexBuffer };
-				VkDeviceSize offsets[] = { 0 };
-				vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
-				vkCmdBindIndexBuffer(commandBuffers[i], indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-				vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[i], 0, nullptr);
-				vkCmdDrawIndexed(commandBuffers[i], static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
-
-				// Bind Dear Imgui pipeline to draw UI elements inside UI box
-				if (isImGuiWindowCreated)
-				{
-					ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffers[i]);
-				}
-
-				vkCmdEndRenderPass(commandBuffers[i]);
-
-				if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS)
-				{
-					throw std::runtime_error("failed to record command buffer!");
-				}
-				// Draw frame handles updating uniform buffers & presenting frame.
-				drawFrame();
-			}
-			//drawFrame();
+			// Draw frame handles updating uniform buffers, recording dirty command buffers & presenting frame.
+			drawFrame();
 			isImGuiWindowCreated = false;
-			Update(mGameTime);
 		}
 
 		vkDeviceWaitIdle(device);
@@ -418,98 +422,69 @@ namespace AlphonsoGraphicsEngine
 
 	void RendererC::cleanupSwapChain()
 	{
-		vkDestroyImageView(device, shadowMapImageView, nullptr);
-		vkDestroyImage(device, shadowMapImage, nullptr);
-		vkFreeMemory(device, shadowMapImageMemory, nullptr);
-
-		vkDestroyImageView(device, msaaColorImageView, nullptr);
-		vkDestroyImage(device, msaaColorImage, nullptr);
-		vkFreeMemory(device, msaaColorImageMemory, nullptr);
-
-		vkDestroyImageView(device, depthImageView, nullptr);
-		vkDestroyImage(device, depthImage, nullptr);
-		vkFreeMemory(device, depthImageMemory, nullptr);
-
-		for (auto framebuffer : swapChainFramebuffers)
+		for (auto imageView : swapChainImageViews)
 		{
-			vkDestroyFramebuffer(device, framebuffer, nullptr);
+			vkDestroyImageView(device, imageView, nullptr);
 		}
+		swapChainImageViews.clear();
 
-		vkDestroyFramebuffer(device, shadowMapFrameBuffer, nullptr);
+		vkDestroySwapchainKHR(device, swapChain, nullptr);
+	}
 
-		vkFreeCommandBuffers(device, commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+	void RendererC::destroyGraphicsPipelines()
+	{
+		pipelineCompiler.DestroyAll();
+		scenePipelinePermutations.clear();
+		graphicsPipeline = PipelineCompiler::NoPipeline;
+		proxyModelsPipeline = PipelineCompiler::NoPipeline;
+		shadowMapPipeline = PipelineCompiler::NoPipeline;
+		replacedPipelines.clear();
 
-		vkDestroyPipeline(device, proxyModelsPipeline, nullptr);
 		vkDestroyPipelineLayout(device, proxyModelsPipelineLayout, nullptr);
-
-		vkDestroyPipeline(device, graphicsPipeline, nullptr);
 		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
-		vkDestroyRenderPass(device, renderPass, nullptr);
-
-		vkDestroyPipeline(device, shadowMapPipeline, nullptr);
 		vkDestroyPipelineLayout(device, shadowMapPipelineLayout, nullptr);
-		vkDestroyRenderPass(device, shadowMapRenderPass, nullptr);
-
-		for (auto imageView : swapChainImageViews)
-		{
-			vkDestroyImageView(device, imageView, nullptr);
-		}
-
-		vkDestroySwapchainKHR(device, swapChain, nullptr);
-
-		for (size_t i = 0; i < swapChainImages.size(); i++)
-		{
-			vkDestroyBuffer(device, uniformBuffers[i], nullptr);
-			vkFreeMemory(device, uniformBuffersMemory[i], nullptr);
-			vkDestroyBuffer(device, fragmentUniformBuffers[i], nullptr);
-			vkFreeMemory(device, fragmentUniformBuffersMemory[i], nullptr);
-			vkDestroyBuffer(device, proxyModelsUniformBuffers[i], nullptr);
-			vkFreeMemory(device, proxyModelsUniformBuffersMemory[i], nullptr);
-		}
-		vkDestroyBuffer(device, offscreenUniformBuffers[0], nullptr);
-		vkFreeMemory(device, fragmentUniformBuffersMemory[0], nullptr);
-		vkDestroyDescriptorPool(device, descriptorPool, nullptr);
 	}
 
 	void RendererC::cleanup()
 	{
-		cleanupSwapChain();
+		destroyFrameContexts();
 
-		vkDestroySampler(device, textureSampler, nullptr);
-		vkDestroyImageView(device, textureImageView, nullptr);
+		destroyGraphicsPipelines();
+
+		renderGraph.Reset();
+		releaseRetiredResources(UINT64_MAX);
+
+		cleanupSwapChain();
 
-		vkDestroyImage(device, textureImage, nullptr);
-		vkFreeMemory(device, textureImageMemory, nullptr);
+		vkDestroyDescriptorPool(device, descriptorPool, nullptr);
 
+		vkDestroySampler(device, textureSampler, nullptr);
 		vkDestroySampler(device, projectedTextureSampler, nullptr);
-		vkDestroyImageView(device, projectedTextureImageView, nullptr);
+		textureStreamer.Shutdown();
+		// Only loaders cook, so pool outlives load workers
+		textureCookPool.reset();
 
-		vkDestroyImage(device, projectedTextureImage, nullptr);
-		vkFreeMemory(device, projectedTextureImageMemory, nullptr);
+		uniformRingBuffer.Shutdown();
 
 		vkDestroyDescriptorSetLayout(device, shadowMapPipelineDescriptorSetLayout, nullptr);
 		vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
 
-		vkDestroyBuffer(device, indexBuffer, nullptr);
-		vkFreeMemory(device, indexBufferMemory, nullptr);
-		vkDestroyBuffer(device, cubeIndexBuffer, nullptr);
-		vkFreeMemory(device, cubeIndexBufferMemory, nullptr);
+		geometryPool.Shutdown();
 
-		vkDestroyBuffer(device, vertexBuffer, nullptr);
-		vkFreeMemory(device, vertexBufferMemory, nullptr);
-		vkDestroyBuffer(device, cubeVertexBuffer, nullptr);
-		vkFreeMemory(device, cubeVertexBufferMemory, nullptr);
+		vkDestroyCommandPool(device, commandPool, nullptr);
 
-		for (size_t i = 0; i < static_cast<size_t>(MAX_FRAMES_IN_FLIGHT); ++i) {
-			vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
-			vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
-			vkDestroyFence(device, inFlightFences[i], nullptr);
-		}
+		uploadManager.Shutdown();
+		memoryAllocator.Shutdown();
 
-		vkDestroyCommandPool(device, commandPool, nullptr);
+		pipelineCompiler.Shutdown();
+		pipelineCache.Shutdown();
 
 		vkDestroyDevice(device, nullptr);
 
+		shaderCompiler.Shutdown();
+		fontFile = AssetFileSystem::File();
+		assets.Shutdown();
+
 		if (enableValidationLayers) {
 			DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
 		}
@@ -531,23 +506,47 @@ namespace AlphonsoGraphicsEngine
 			glfwWaitEvents();
 		}
 
-		vkDeviceWaitIdle(device);
+		// Each resize retires a swapchain, attachments & a scene set. Frames which fail to acquire never get to release them,
+		// so once a frames in flight worth piled up, GPU is caught up with instead of letting them grow
+		if (retiredSwapChains.size() >= frames.size())
+		{
+			waitForFramesInFlight();
+		}
 
-		cleanupSwapChain();
+		// Frames in flight keep rendering into & presenting old swapchain, so it's handed to its replacement & retired with its views
+		RetiredSwapChain retired;
+		retired.swapChain = swapChain;
+		retired.imageViews.swap(swapChainImageViews);
+		retired.releaseFrame = frameNumber + frames.size();
+		retiredSwapChains.push_back(std::move(retired));
 
-		createSwapChain();
+		VkFormat oldImageFormat = swapChainImageFormat;
+		createSwapChain(retiredSwapChains.back().swapChain);
 		createImageViews();
-		createRenderPass();
-		createShadowMap();
-		createGraphicsPipeline();
-		createMSAAColorResources();
-		createDepthResources();
-		createFramebuffers();
-		mCamera->SetAspectRatio((float)swapChainExtent.width / swapChainExtent.height);
-		createUniformBuffers();
-		createDescriptorPool();
-		createDescriptorSets();
-		createCommandBuffers();
+
+		// Pipelines use dynamic viewport & scissor, so they survive unless render passes have to change
+		if (swapChainImageFormat == oldImageFormat)
+		{
+			resizeRenderGraph();
+			// Shadow map was recreated, everything else scene set points at is independent of window size
+			replaceSceneDescriptorSet();
+		}
+		else
+		{
+			vkDeviceWaitIdle(device);
+			releaseRetiredResources(UINT64_MAX);
+			destroyGraphicsPipelines();
+			renderGraph.Reset();
+			createRenderGraph();
+			createGraphicsPipeline();
+			writeSceneDescriptorSet(descriptorSet);
+		}
+		{
+			std::lock_guard<std::mutex> lock(mSimulationCommandsMutex);
+			mSimulationCommands.cameraAspectRatio = (float)swapChainExtent.width / swapChainExtent.height;
+		}
+
+		invalidateStaticCommandBuffers();
 	}
 
 	void RendererC::createInstance()
@@ -660,6 +659,10 @@ namespace AlphonsoGraphicsEngine
 
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		std::set<uint32_t> uniqueQueueFamilies = { Indices.graphicsFamily.value(), Indices.presentFamily.value() };
+		if (Indices.transferFamily.has_value())
+		{
+			uniqueQueueFamilies.insert(Indices.transferFamily.value());
+		}
 
 		float queuePriority = 1.0f;
 		for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -672,9 +675,14 @@ namespace AlphonsoGraphicsEngine
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+		textureCompressionBC = supportedFeatures.textureCompressionBC == VK_TRUE;
+
 		VkPhysicalDeviceFeatures deviceFeatures = {};
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
 		deviceFeatures.sampleRateShading = VK_TRUE;
+		deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
 
 		VkDeviceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -704,9 +712,13 @@ namespace AlphonsoGraphicsEngine
 
 		vkGetDeviceQueue(device, Indices.graphicsFamily.value(), 0, &graphicsQueue);
 		vkGetDeviceQueue(device, Indices.presentFamily.value(), 0, &presentQueue);
+		if (Indices.transferFamily.has_value())
+		{
+			vkGetDeviceQueue(device, Indices.transferFamily.value(), 0, &transferQueue);
+		}
 	}
 
-	void RendererC::createSwapChain()
+	void RendererC::createSwapChain(VkSwapchainKHR oldSwapChain)
 	{
 		SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice);
 
@@ -749,6 +761,7 @@ namespace AlphonsoGraphicsEngine
 		createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 		createInfo.presentMode = presentMode;
 		createInfo.clipped = VK_TRUE;
+		createInfo.oldSwapchain = oldSwapChain;
 
 		if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &swapChain) != VK_SUCCESS)
 		{
@@ -773,82 +786,70 @@ namespace AlphonsoGraphicsEngine
 		}
 	}
 
-	void RendererC::createRenderPass()
-	{
-		VkAttachmentDescription colorAttachment = {};
-		colorAttachment.format = swapChainImageFormat;
-		colorAttachment.samples = MSAA_Samples;
-		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentDescription depthAttachment = {};
-		depthAttachment.format = findDepthFormat();
-		depthAttachment.samples = MSAA_Samples;
-		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentDescription colorAttachmentResolve = {};
-		colorAttachmentResolve.format = swapChainImageFormat;
-		colorAttachmentResolve.samples = VK_SAMPLE_COUNT_1_BIT;
-		colorAttachmentResolve.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachmentResolve.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		colorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-		VkAttachmentReference colorAttachmentRef = {};
-		colorAttachmentRef.attachment = 0;
-		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentReference depthAttachmentRef = {};
-		depthAttachmentRef.attachment = 1;
-		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentReference colorAttachmentResolveRef = {};
-		colorAttachmentResolveRef.attachment = 2;
-		colorAttachmentResolveRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		VkSubpassDescription subpass = {};
-		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-		subpass.colorAttachmentCount = 1;
-		subpass.pColorAttachments = &colorAttachmentRef;
-		subpass.pDepthStencilAttachment = &depthAttachmentRef;
-		subpass.pResolveAttachments = &colorAttachmentResolveRef;
-
-		VkSubpassDependency dependency = {};
-		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-		dependency.dstSubpass = 0;
-		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependency.srcAccessMask = 0;
-		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-		std::array<VkAttachmentDescription, 3> attachments = { colorAttachment, depthAttachment, colorAttachmentResolve };
-		VkRenderPassCreateInfo renderPassInfo = {};
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-		renderPassInfo.pAttachments = attachments.data();
-		renderPassInfo.subpassCount = 1;
-		renderPassInfo.pSubpasses = &subpass;
-		renderPassInfo.dependencyCount = 1;
-		renderPassInfo.pDependencies = &dependency;
-
-		if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
-		{
-			throw std::runtime_error("failed to create render pass!");
-		}
-
-		// Create Off-Screen Render Pass
-		createShadowMapRenderPass();
+	void RendererC::createRenderGraph()
+	{
+		renderGraph.Initialize(device, memoryAllocator);
+
+		VkFormat depthFormat = findDepthFormat();
+		VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+		if (hasStencilComponent(depthFormat))
+		{
+			depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+		}
+
+		RenderGraph::ImageDesc backBufferDesc = { swapChainImageFormat, swapChainExtent, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_ASPECT_COLOR_BIT };
+		RenderGraph::ImageDesc msaaColorDesc = { swapChainImageFormat, swapChainExtent, MSAA_Samples, VK_IMAGE_ASPECT_COLOR_BIT };
+		RenderGraph::ImageDesc depthDesc = { depthFormat, swapChainExtent, MSAA_Samples, depthAspect };
+
+		backBufferResource = renderGraph.ImportImage("BackBuffer", backBufferDesc, swapChainImages, swapChainImageViews, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+		msaaColorResource = renderGraph.CreateImage("MSAAColor", msaaColorDesc);
+		depthResource = renderGraph.CreateImage("Depth", depthDesc);
+		// We will sample directly from the depth attachment for the shadow mapping
+		shadowMapResource = renderGraph.CreateImage("ShadowMap", depthDesc);
+
+		/*
+		First render pass: Generate shadow map by rendering the scene from light's POV
+		*/
+		shadowMapPass = renderGraph.AddPass("ShadowMap")
+			.WriteDepth(shadowMapResource, VK_ATTACHMENT_LOAD_OP_CLEAR)
+			.SetExecute([this](VkCommandBuffer commandBuffer)
+			{
+				vkCmdExecuteCommands(commandBuffer, 1, &frames[currentFrame].shadowPassCommandBuffer);
+			}, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+			.Handle();
+
+		/*
+		Second render pass: Draw proxy models, Chalet model & Dear ImGui, resolving MSAA into swapchain image
+		*/
+		VkClearColorValue clearColor = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+		scenePass = renderGraph.AddPass("Scene")
+			.ReadTexture(shadowMapResource)
+			.WriteColor(msaaColorResource, VK_ATTACHMENT_LOAD_OP_CLEAR, clearColor)
+			.WriteDepth(depthResource, VK_ATTACHMENT_LOAD_OP_CLEAR)
+			.WriteResolve(backBufferResource)
+			.SetExecute([this](VkCommandBuffer commandBuffer)
+			{
+				FrameContext& frame = frames[currentFrame];
+				std::array<VkCommandBuffer, 2> secondaryCommandBuffers = { frame.scenePassCommandBuffer, frame.uiCommandBuffer };
+				uint32_t secondaryCommandBufferCount = isImGuiWindowCreated ? 2 : 1;
+				vkCmdExecuteCommands(commandBuffer, secondaryCommandBufferCount, secondaryCommandBuffers.data());
+			}, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+			.Handle();
+
+		renderGraph.Compile();
+
+		renderPass = renderGraph.RenderPass(scenePass);
+		shadowMapRenderPass = renderGraph.RenderPass(shadowMapPass);
+	}
+
+	void RendererC::resizeRenderGraph()
+	{
+		// Only attachments sized like swapchain are rebuilt, render passes & everything created against them are kept
+		renderGraph.ReplaceImportedImage(backBufferResource, swapChainExtent, swapChainImages, swapChainImageViews);
+		renderGraph.SetImageExtent(msaaColorResource, swapChainExtent);
+		renderGraph.SetImageExtent(depthResource, swapChainExtent);
+		renderGraph.SetImageExtent(shadowMapResource, swapChainExtent);
+		renderGraph.Resize(frameNumber + frames.size());
 	}
 
 	void RendererC::createDescriptorSetLayout()
@@ -856,7 +857,7 @@ namespace AlphonsoGraphicsEngine
 		VkDescriptorSetLayoutBinding uboLayoutBinding = {};
 		uboLayoutBinding.binding = 0;
 		uboLayoutBinding.descriptorCount = 1;
-		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		uboLayoutBinding.pImmutableSamplers = nullptr;
 		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
@@ -870,7 +871,7 @@ namespace AlphonsoGraphicsEngine
 		VkDescriptorSetLayoutBinding fboLayoutBinding = {};
 		fboLayoutBinding.binding = 2;
 		fboLayoutBinding.descriptorCount = 1;
-		fboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		fboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		fboLayoutBinding.pImmutableSamplers = nullptr;
 		fboLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
@@ -898,11 +899,6 @@ namespace AlphonsoGraphicsEngine
 			throw std::runtime_error("failed to create descriptor set layout!");
 		}
 
-		// For now, use the same pipeline layout for Shadow Mapping Pipeline layout.
-		if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &shadowMapPipelineDescriptorSetLayout) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create descriptor set layout!");
-		}
-
 		// Create pipeline layout for Proxy model pipeline
 		std::array<VkDescriptorSetLayoutBinding, 1> proxyModelPipelineLayoutbindings = { uboLayoutBinding };
 		VkDescriptorSetLayoutCreateInfo proxyModelLayoutInfo = {};
@@ -914,66 +910,102 @@ namespace AlphonsoGraphicsEngine
 			throw std::runtime_error("failed to create descriptor set layout!");
 		}
 
+		// Shadow Mapping Pipeline only reads light's view projection, same single vertex UBO as proxy models.
+		if (vkCreateDescriptorSetLayout(device, &proxyModelLayoutInfo, nullptr, &shadowMapPipelineDescriptorSetLayout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create descriptor set layout!");
+		}
+
+	}
+
+	void RendererC::createPipelineCache()
+	{
+		// Cache is specific to this machine's GPU & driver, so it lives next to asset pack rather than inside Assets
+		std::string path;
+		if (!assets.PackPath().empty())
+		{
+			path = (std::filesystem::path(assets.PackPath()).parent_path() / PIPELINE_CACHE_FILE).string();
+		}
+		pipelineCache.Initialize(physicalDevice, device, path);
+		pipelineCompiler.Initialize(device, pipelineCache.Handle(), PIPELINE_COMPILE_THREADS);
 	}
 
 	void RendererC::createGraphicsPipeline()
 	{
-		auto vertShaderCode = readFile("../../Assets/Shaders/vert.spv");
-		auto fragShaderCode = readFile("../../Assets/Shaders/frag.spv");
+		createPipelineLayouts();
 
-		VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
-		VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
+		// All pipelines compile on workers at once, nothing can be drawn until every one is ready
+		requestGraphicsPipelines();
+		pipelineCompiler.WaitAll();
+		replacedPipelines.clear();
+	}
 
-		VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
-		vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-		vertShaderStageInfo.module = vertShaderModule;
-		vertShaderStageInfo.pName = "main";
+	void RendererC::createPipelineLayouts()
+	{
+		VkPushConstantRange drawConstantsRange = {};
+		drawConstantsRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		drawConstantsRange.offset = 0;
+		drawConstantsRange.size = sizeof(DrawConstants);
 
-		VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
-		fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-		fragShaderStageInfo.module = fragShaderModule;
-		fragShaderStageInfo.pName = "main";
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &drawConstantsRange;
 
-		VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
+		if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
 
-		VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
-		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		VkPipelineLayoutCreateInfo proxyModelPipelineLayoutInfo = {};
+		proxyModelPipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		proxyModelPipelineLayoutInfo.setLayoutCount = 1;
+		proxyModelPipelineLayoutInfo.pSetLayouts = &proxyModelsPipelineDescriptorSetLayout;
+		proxyModelPipelineLayoutInfo.pushConstantRangeCount = 1;
+		proxyModelPipelineLayoutInfo.pPushConstantRanges = &drawConstantsRange;
 
-		auto bindingDescription = Vertex::getBindingDescription();
-		auto attributeDescriptions = Vertex::getAttributeDescriptions();
+		if (vkCreatePipelineLayout(device, &proxyModelPipelineLayoutInfo, nullptr, &proxyModelsPipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
 
-		vertexInputInfo.vertexBindingDescriptionCount = 1;
-		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-		vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+		VkPipelineLayoutCreateInfo shadowMapPipelineLayoutInfo = {};
+		shadowMapPipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		shadowMapPipelineLayoutInfo.setLayoutCount = 1;
+		shadowMapPipelineLayoutInfo.pSetLayouts = &shadowMapPipelineDescriptorSetLayout;
+		shadowMapPipelineLayoutInfo.pushConstantRangeCount = 1;
+		shadowMapPipelineLayoutInfo.pPushConstantRanges = &drawConstantsRange;
 
-		VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-		inputAssembly.primitiveRestartEnable = VK_FALSE;
+		if (vkCreatePipelineLayout(device, &shadowMapPipelineLayoutInfo, nullptr, &shadowMapPipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+	}
 
-		VkViewport viewport = {};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = (float)swapChainExtent.width;
-		viewport.height = (float)swapChainExtent.height;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
+	PipelineCompiler::Description RendererC::describeScenePipeline()
+	{
+		PipelineCompiler::Description description;
 
-		VkRect2D scissor = {};
-		scissor.offset = { 0, 0 };
-		scissor.extent = swapChainExtent;
+		// Pool holds a single vertex format, shared by every pipeline drawing from it
+		description.vertexBindings.push_back(USE_PACKED_VERTICES ? PackedVertex::getBindingDescription() : Vertex::getBindingDescription());
+		if (USE_PACKED_VERTICES)
+		{
+			auto packedAttributeDescriptions = PackedVertex::getAttributeDescriptions();
+			description.vertexAttributes.assign(packedAttributeDescriptions.begin(), packedAttributeDescriptions.end());
+		}
+		else
+		{
+			auto attributeDescriptions = Vertex::getAttributeDescriptions();
+			description.vertexAttributes.assign(attributeDescriptions.begin(), attributeDescriptions.end());
+		}
 
-		VkPipelineViewportStateCreateInfo viewportState = {};
-		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-		viewportState.viewportCount = 1;
-		viewportState.pViewports = &viewport;
-		viewportState.scissorCount = 1;
-		viewportState.pScissors = &scissor;
+		description.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
-		VkPipelineRasterizationStateCreateInfo rasterizer = {};
+		// Viewport & scissor are set while recording, so pipelines don't depend on window size
+		description.dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+		VkPipelineRasterizationStateCreateInfo& rasterizer = description.rasterization;
 		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
 		rasterizer.depthClampEnable = VK_FALSE;
 		rasterizer.rasterizerDiscardEnable = VK_FALSE;
@@ -983,13 +1015,13 @@ namespace AlphonsoGraphicsEngine
 		rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
 		rasterizer.depthBiasEnable = VK_FALSE;
 
-		VkPipelineMultisampleStateCreateInfo multisampling = {};
+		VkPipelineMultisampleStateCreateInfo& multisampling = description.multisample;
 		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
 		multisampling.sampleShadingEnable = VK_TRUE;
 		multisampling.minSampleShading = 0.2f;
 		multisampling.rasterizationSamples = MSAA_Samples;
 
-		VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+		VkPipelineDepthStencilStateCreateInfo& depthStencil = description.depthStencil;
 		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
 		depthStencil.depthTestEnable = VK_TRUE;
 		depthStencil.depthWriteEnable = VK_TRUE;
@@ -1007,171 +1039,164 @@ namespace AlphonsoGraphicsEngine
 		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
 		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
 		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-		VkPipelineColorBlendStateCreateInfo colorBlending = {};
-		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-		colorBlending.logicOpEnable = VK_FALSE;
-		colorBlending.logicOp = VK_LOGIC_OP_COPY;
-		colorBlending.attachmentCount = 1;
-		colorBlending.pAttachments = &colorBlendAttachment;
-		colorBlending.blendConstants[0] = 0.0f;
-		colorBlending.blendConstants[1] = 0.0f;
-		colorBlending.blendConstants[2] = 0.0f;
-		colorBlending.blendConstants[3] = 0.0f;
-
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 1;
-		pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
-
-		if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
-		{
-			throw std::runtime_error("failed to create pipeline layout!");
+		description.colorBlendAttachments.push_back(colorBlendAttachment);
+
+		description.layout = pipelineLayout;
+		description.renderPass = renderPass;
+		description.subpass = 0;
+		return description;
+	}
+
+	void RendererC::requestGraphicsPipelines()
+	{
+		// Every shader is compiled before anything is requested, so a typo throws before current pipelines are touched
+		auto vertShaderCode = compileShader(SCENE_VERTEX_SHADER, ShaderCompiler::Stage::Vertex);
+		auto fragShaderCode = compileShader(SCENE_FRAGMENT_SHADER, ShaderCompiler::Stage::Fragment);
+		auto vertShaderCodeForProxyModels = compileShader(PROXY_MODEL_VERTEX_SHADER, ShaderCompiler::Stage::Vertex);
+		auto fragShaderCodeForProxyModels = compileShader(PROXY_MODEL_FRAGMENT_SHADER, ShaderCompiler::Stage::Fragment);
+		auto vertShaderCodeForShadowMapping = compileShader(SHADOW_MAP_VERTEX_SHADER, ShaderCompiler::Stage::Vertex);
+		sceneVertexSpirv = std::move(vertShaderCode);
+		sceneFragmentSpirv = std::move(fragShaderCode);
+
+		// Scene pipeline is the permutation with every feature, drawn with while cheaper ones compile
+		PipelineCompiler::Description sceneDescription = describeScenePipeline();
+		sceneDescription.stages.push_back({ VK_SHADER_STAGE_VERTEX_BIT, sceneVertexSpirv });
+		sceneDescription.stages.push_back(sceneFragmentStage(SCENE_FEATURES_ALL));
+
+		// Proxy models reuse model pipeline state with their own shaders & layout
+		PipelineCompiler::Description proxyModelDescription = describeScenePipeline();
+		proxyModelDescription.stages.push_back({ VK_SHADER_STAGE_VERTEX_BIT, std::move(vertShaderCodeForProxyModels) });
+		proxyModelDescription.stages.push_back({ VK_SHADER_STAGE_FRAGMENT_BIT, std::move(fragShaderCodeForProxyModels) });
+		proxyModelDescription.layout = proxyModelsPipelineLayout;
+
+		// Off-screen pipeline for shadow mapping writes depth only, with depth bias set per frame
+		PipelineCompiler::Description shadowMapDescription = describeScenePipeline();
+		shadowMapDescription.stages.push_back({ VK_SHADER_STAGE_VERTEX_BIT, std::move(vertShaderCodeForShadowMapping) });
+		shadowMapDescription.colorBlendAttachments.clear();
+		shadowMapDescription.rasterization.depthBiasEnable = VK_TRUE;
+		shadowMapDescription.dynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_BIAS);
+		shadowMapDescription.layout = shadowMapPipelineLayout;
+		shadowMapDescription.renderPass = shadowMapRenderPass;
+
+		// Current pipelines keep being drawn with until their replacements are compiled
+		for (PipelineCompiler::PipelineHandle* pipeline : { &graphicsPipeline, &proxyModelsPipeline, &shadowMapPipeline })
+		{
+			if (*pipeline != PipelineCompiler::NoPipeline)
+			{
+				replacedPipelines.push_back(*pipeline);
+			}
 		}
+		graphicsPipeline = pipelineCompiler.Request(std::move(sceneDescription), graphicsPipeline);
+		proxyModelsPipeline = pipelineCompiler.Request(std::move(proxyModelDescription), proxyModelsPipeline);
+		shadowMapPipeline = pipelineCompiler.Request(std::move(shadowMapDescription), shadowMapPipeline);
 
-		VkGraphicsPipelineCreateInfo pipelineInfo = {};
-		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.stageCount = 2;
-		pipelineInfo.pStages = shaderStages;
-		pipelineInfo.pVertexInputState = &vertexInputInfo;
-		pipelineInfo.pInputAssemblyState = &inputAssembly;
-		pipelineInfo.pViewportState = &viewportState;
-		pipelineInfo.pRasterizationState = &rasterizer;
-		pipelineInfo.pMultisampleState = &multisampling;
-		pipelineInfo.pDepthStencilState = &depthStencil;
-		pipelineInfo.pColorBlendState = &colorBlending;
-		pipelineInfo.layout = pipelineLayout;
-		pipelineInfo.renderPass = renderPass;
-		pipelineInfo.subpass = 0;
-		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-
-		if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS)
+		// Other permutations are built from old shaders, they are requested again when next drawn
+		for (const auto& permutation : scenePipelinePermutations)
 		{
-			throw std::runtime_error("failed to create graphics pipeline!");
+			if (permutation.first != SCENE_FEATURES_ALL)
+			{
+				replacedPipelines.push_back(permutation.second);
+			}
 		}
+		scenePipelinePermutations.clear();
+		scenePipelinePermutations[SCENE_FEATURES_ALL] = graphicsPipeline;
+	}
 
-		// Create new pipeline for proxy models rendering
-		// We are reusing model pipeline structs with changes wherever needed.
-		
-		VkPipelineLayoutCreateInfo proxyModelPipelineLayoutInfo = {};
-		proxyModelPipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		proxyModelPipelineLayoutInfo.setLayoutCount = 1;
-		proxyModelPipelineLayoutInfo.pSetLayouts = &proxyModelsPipelineDescriptorSetLayout;
-
-		if (vkCreatePipelineLayout(device, &proxyModelPipelineLayoutInfo, nullptr, &proxyModelsPipelineLayout) != VK_SUCCESS)
+	void RendererC::updateGraphicsPipelines()
+	{
+		if (!pipelineCompiler.Update())
 		{
-			throw std::runtime_error("failed to create pipeline layout!");
+			return;
 		}
 
-		auto vertShaderCodeForProxyModels = readFile("../../Assets/Shaders/proxyModelVert.spv");
-		auto fragShaderCodeForProxyModels = readFile("../../Assets/Shaders/proxyModelFrag.spv");
-		VkShaderModule vertShaderModuleForProxyModels = createShaderModule(vertShaderCodeForProxyModels);
-		VkShaderModule fragShaderModuleForProxyModels = createShaderModule(fragShaderCodeForProxyModels);
-
-		VkPipelineShaderStageCreateInfo vertShaderStageInfoForProxyModels = {};
-		vertShaderStageInfoForProxyModels.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		vertShaderStageInfoForProxyModels.stage = VK_SHADER_STAGE_VERTEX_BIT;
-		vertShaderStageInfoForProxyModels.module = vertShaderModuleForProxyModels;
-		vertShaderStageInfoForProxyModels.pName = "main";
-
-		VkPipelineShaderStageCreateInfo fragShaderStageInfoForProxyModels = {};
-		fragShaderStageInfoForProxyModels.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		fragShaderStageInfoForProxyModels.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-		fragShaderStageInfoForProxyModels.module = fragShaderModuleForProxyModels;
-		fragShaderStageInfoForProxyModels.pName = "main";
-
-		VkPipelineShaderStageCreateInfo proxyModelShaderStages[] = { vertShaderStageInfoForProxyModels, fragShaderStageInfoForProxyModels };
-		pipelineInfo.stageCount = 2;
-		pipelineInfo.pStages = proxyModelShaderStages;
-		pipelineInfo.layout = proxyModelsPipelineLayout;
-		pipelineInfo.renderPass = renderPass;
-		
-		if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &proxyModelsPipeline) != VK_SUCCESS)
+		// Replaced pipelines go once all of their successors are ready, until then one of them may still be drawn with
+		if (pipelineCompiler.IsReady(graphicsPipeline) && pipelineCompiler.IsReady(proxyModelsPipeline) && pipelineCompiler.IsReady(shadowMapPipeline))
 		{
-			throw std::runtime_error("failed to create graphics pipeline!");
+			for (PipelineCompiler::PipelineHandle pipeline : replacedPipelines)
+			{
+				pipelineCompiler.Retire(pipeline, static_cast<uint32_t>(frames.size()));
+			}
+			replacedPipelines.clear();
 		}
+		invalidateStaticCommandBuffers();
+	}
 
-		// Create Off-screen Graphics Pipeline for Shadow Mapping
-		// We are reusing model pipeline structs with changes wherever needed.
+	PipelineCompiler::ShaderStage RendererC::sceneFragmentStage(uint32_t features) const
+	{
+		// Layout matches constant_id 0 to 4 of scene fragment shader, bools are 32 bit in SPIR-V
+		struct SpecializationConstants
+		{
+			VkBool32 projectorEnabled;
+			VkBool32 shadowEnabled;
+			VkBool32 pointLightEnabled;
+			VkBool32 specularEnabled;
+			int32_t shadowFilterMode;
+		};
 
-		VkPipelineLayoutCreateInfo shadowMapPipelineLayoutInfo = {};
-		shadowMapPipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		shadowMapPipelineLayoutInfo.setLayoutCount = 1;
-		shadowMapPipelineLayoutInfo.pSetLayouts = &shadowMapPipelineDescriptorSetLayout;
+		SpecializationConstants constants = {};
+		constants.projectorEnabled = (features & SCENE_FEATURE_PROJECTOR) ? VK_TRUE : VK_FALSE;
+		constants.shadowEnabled = (features & SCENE_FEATURE_SHADOW) ? VK_TRUE : VK_FALSE;
+		constants.pointLightEnabled = (features & SCENE_FEATURE_POINT_LIGHT) ? VK_TRUE : VK_FALSE;
+		constants.specularEnabled = (features & SCENE_FEATURE_SPECULAR) ? VK_TRUE : VK_FALSE;
+		constants.shadowFilterMode = (features & SCENE_FEATURE_SHADOW_PCF) ? 1 : 0;
+
+		PipelineCompiler::ShaderStage stage;
+		stage.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		stage.spirv = sceneFragmentSpirv;
+		stage.specializationEntries = {
+			{ 0, offsetof(SpecializationConstants, projectorEnabled), sizeof(VkBool32) },
+			{ 1, offsetof(SpecializationConstants, shadowEnabled), sizeof(VkBool32) },
+			{ 2, offsetof(SpecializationConstants, pointLightEnabled), sizeof(VkBool32) },
+			{ 3, offsetof(SpecializationConstants, specularEnabled), sizeof(VkBool32) },
+			{ 4, offsetof(SpecializationConstants, shadowFilterMode), sizeof(int32_t) }
+		};
+		const uint8_t* constantBytes = reinterpret_cast<const uint8_t*>(&constants);
+		stage.specializationData.assign(constantBytes, constantBytes + sizeof(constants));
+		return stage;
+	}
 
-		if (vkCreatePipelineLayout(device, &shadowMapPipelineLayoutInfo, nullptr, &shadowMapPipelineLayout) != VK_SUCCESS)
+	PipelineCompiler::PipelineHandle RendererC::scenePipelinePermutation(uint32_t features)
+	{
+		auto permutation = scenePipelinePermutations.find(features);
+		if (permutation != scenePipelinePermutations.end())
 		{
-			throw std::runtime_error("failed to create pipeline layout!");
+			return permutation->second;
 		}
 
-		auto vertShaderCodeForShadowMapping = readFile("../../Assets/Shaders/depthMapVert.spv");
-		VkShaderModule vertShaderModuleForShadowMapping = createShaderModule(vertShaderCodeForShadowMapping);
+		// Compiled on workers on first use, permutation with every feature is drawn with meanwhile
+		PipelineCompiler::Description description = describeScenePipeline();
+		description.stages.push_back({ VK_SHADER_STAGE_VERTEX_BIT, sceneVertexSpirv });
+		description.stages.push_back(sceneFragmentStage(features));
+
+		PipelineCompiler::PipelineHandle pipeline = pipelineCompiler.Request(std::move(description), graphicsPipeline);
+		scenePipelinePermutations[features] = pipeline;
+		return pipeline;
+	}
 
-		VkPipelineShaderStageCreateInfo vertShaderStageInfoForShadowMapping = {};
-		vertShaderStageInfoForShadowMapping.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		vertShaderStageInfoForShadowMapping.stage = VK_SHADER_STAGE_VERTEX_BIT;
-		vertShaderStageInfoForShadowMapping.module = vertShaderModuleForShadowMapping;
-		vertShaderStageInfoForShadowMapping.pName = "main";
+	uint32_t RendererC::selectSceneFeatures(const FragmentUniformBufferObject& fbo) const
+	{
+		uint32_t features = sceneFeatureToggles;
 
-		VkPipelineShaderStageCreateInfo shadowMappingShaderStages[] = { vertShaderStageInfoForShadowMapping };
-		pipelineInfo.stageCount = 1;
-		pipelineInfo.pStages = shadowMappingShaderStages;
-		colorBlending.attachmentCount = 0;
-		rasterizer.depthBiasEnable = VK_TRUE;
-		std::vector<VkDynamicState> dynamicStateEnables = { /*VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR,*/ VK_DYNAMIC_STATE_DEPTH_BIAS };
-		VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = {};
-		dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-		dynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
-		dynamicStateCreateInfo.pDynamicStates = dynamicStateEnables.data();
-		pipelineInfo.pDynamicState = &dynamicStateCreateInfo;
-		pipelineInfo.layout = shadowMapPipelineLayout;
-		pipelineInfo.renderPass = shadowMapRenderPass;
-		if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &shadowMapPipeline) != VK_SUCCESS)
+		// Features contributing nothing are dropped, so draw gets cheapest permutation producing same image
+		if (fbo.pointLightColor.r == 0.0f && fbo.pointLightColor.g == 0.0f && fbo.pointLightColor.b == 0.0f)
 		{
-			throw std::runtime_error("failed to create graphics pipeline!");
+			features &= ~SCENE_FEATURE_POINT_LIGHT;
 		}
-
-		vkDestroyShaderModule(device, fragShaderModule, nullptr);
-		vkDestroyShaderModule(device, vertShaderModule, nullptr);
-		vkDestroyShaderModule(device, vertShaderModuleForProxyModels, nullptr);
-		vkDestroyShaderModule(device, fragShaderModuleForProxyModels, nullptr);
-		vkDestroyShaderModule(device, vertShaderModuleForShadowMapping, nullptr);
+		// Specular highlight is lit by point light
+		if (!(features & SCENE_FEATURE_POINT_LIGHT) || (fbo.specularColor.r == 0.0f && fbo.specularColor.g == 0.0f && fbo.specularColor.b == 0.0f))
+		{
+			features &= ~SCENE_FEATURE_SPECULAR;
+		}
+		if (!(features & SCENE_FEATURE_SHADOW))
+		{
+			features &= ~SCENE_FEATURE_SHADOW_PCF;
+		}
+		return features;
 	}
 
-	void RendererC::createFramebuffers()
+	void RendererC::createCommandPool()
 	{
-		swapChainFramebuffers.resize(swapChainImageViews.size());
-
-		for (size_t i = 0; i < swapChainImageViews.size(); i++)
-		{
-			std::array<VkImageView, 3> attachments = {
-				msaaColorImageView,
-				depthImageView,
-				swapChainImageViews[i]
-			};
-
-			VkFramebufferCreateInfo framebufferInfo = {};
-			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-			framebufferInfo.renderPass = renderPass;
-			framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-			framebufferInfo.pAttachments = attachments.data();
-			framebufferInfo.width = swapChainExtent.width;
-			framebufferInfo.height = swapChainExtent.height;
-			framebufferInfo.layers = 1;
-
-			if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &swapChainFramebuffers[i]) != VK_SUCCESS)
-			{
-				throw std::runtime_error("failed to create framebuffer!");
-			}
-		}
-
-		// Create Off-Screeb Frame Buffer for Shadow Map
-		createShadowMapFrameBuffer();
-	}
-
-	void RendererC::createCommandPool()
-	{
-		QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
+		QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
 
 		VkCommandPoolCreateInfo poolInfo = {};
 		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -1182,24 +1207,19 @@ namespace AlphonsoGraphicsEngine
 		}
 	}
 
-	void RendererC::createMSAAColorResources()
+	void RendererC::createUploadManager()
 	{
-		VkFormat colorFormat = swapChainImageFormat;
-
-		createImage(swapChainExtent.width, swapChainExtent.height, MSAA_Samples, colorFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, msaaColorImage, msaaColorImageMemory);
-		msaaColorImageView = createImageView(msaaColorImage, colorFormat, VK_IMAGE_ASPECT_COLOR_BIT);
-
-		transitionImageLayout(msaaColorImage, colorFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-	}
-
-	void RendererC::createDepthResources()
-	{
-		VkFormat depthFormat = findDepthFormat();
-
-		createImage(swapChainExtent.width, swapChainExtent.height, MSAA_Samples, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory);
-		depthImageView = createImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+		QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
+		uint32_t graphicsFamily = queueFamilyIndices.graphicsFamily.value();
 
-		transitionImageLayout(depthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+		if (queueFamilyIndices.transferFamily.has_value())
+		{
+			uploadManager.Initialize(device, memoryAllocator, queueFamilyIndices.transferFamily.value(), transferQueue, graphicsFamily, graphicsQueue, STAGING_HEAP_SIZE, UPLOAD_BUDGET_PER_FRAME);
+		}
+		else
+		{
+			uploadManager.Initialize(device, memoryAllocator, graphicsFamily, graphicsQueue, graphicsFamily, graphicsQueue, STAGING_HEAP_SIZE, UPLOAD_BUDGET_PER_FRAME);
+		}
 	}
 
 	VkSampleCountFlagBits RendererC::getMaximumPossibleSampleCount()
@@ -1252,75 +1272,125 @@ namespace AlphonsoGraphicsEngine
 		return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
 	}
 
-	void RendererC::createTextureImage()
+	void RendererC::createTextureStreamer()
 	{
-		// Load Model Texture Image
-		int texWidth, texHeight, texChannels;
-		stbi_uc* pixels = stbi_load(TEXTURE_PATH.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-		VkDeviceSize imageSize = static_cast<uint64_t>(texWidth) * static_cast<uint64_t>(texHeight) * 4U;
-
-		if (!pixels)
-		{
-			throw std::runtime_error("failed to load model texture image!");
-		}
+		textureCookPool = std::make_unique<ThreadPool>(TEXTURE_COOK_THREADS);
+		textureStreamer.Initialize(device, memoryAllocator, uploadManager, TEXTURE_STREAMING_BUDGET, TEXTURE_STREAMING_TAIL_EXTENT, TEXTURE_LOAD_THREADS);
 
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
-		createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+		// Textures are only registered here, decoding & uploads run on load workers once first frame asks for them
+		modelTexture = textureStreamer.Register([this] { return loadTextureLevels(TEXTURE_PATH, MODEL_TEXTURE_FORMAT); });
+		projectedTexture = textureStreamer.Register([this] { return loadTextureLevels(PROJECTED_TEXTURE_PATH, PROJECTED_TEXTURE_FORMAT); });
 
-		void* data;
-		vkMapMemory(device, stagingBufferMemory, 0, imageSize, 0, &data);
-		memcpy(data, pixels, static_cast<size_t>(imageSize));
-		vkUnmapMemory(device, stagingBufferMemory);
-
-		stbi_image_free(pixels);
-
-		createImage(texWidth, texHeight, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory);
-
-		transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-		transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-		vkDestroyBuffer(device, stagingBuffer, nullptr);
-		vkFreeMemory(device, stagingBufferMemory, nullptr);
+		// Placeholder sampled until projected texture arrives is a single texel
+		InitializeProjectedTextureScalingMatrix(1, 1);
+	}
 
-		// Load Projected Texture Image
+	TextureStreamer::SourceLevels RendererC::loadTextureLevels(const std::string& texturePath, VkFormat compressedFormat)
+	{
+		TextureStreamer::SourceLevels source;
 
-		texWidth = 0, texHeight = 0, texChannels = 0, pixels = nullptr, data = nullptr;
-		pixels = stbi_load(PROJECTED_TEXTURE_PATH.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-		imageSize = static_cast<uint64_t>(texWidth) * static_cast<uint64_t>(texHeight) * 4U;
+		AssetFileSystem::File sourceFile = readAsset(texturePath);
+		bool compressed = isBlockCompressionSupported(compressedFormat);
+		std::string cookedPath = Ktx2Texture::CachePath(texturePath);
+		if (compressed)
+		{
+			// Up to date cooked texture skips decoding, see AssetFileSystem::LoosePath
+			struct CookedTexture
+			{
+				AssetFileSystem::File file;
+				Ktx2Texture texture;
+			};
+			auto cooked = std::make_shared<CookedTexture>();
+			cooked->file = assets.Read(cookedPath, AssetFileSystem::Lookup::LooseFirst);
+			const Ktx2Texture& texture = cooked->texture;
+			if (cooked->file && cooked->texture.Load(cooked->file.data, cooked->file.size) && texture.Format() == compressedFormat
+				&& texture.Source() != nullptr && sourceFile.Matches(*texture.Source()))
+			{
+				source.format = compressedFormat;
+				source.width = texture.Width();
+				source.height = texture.Height();
+				source.blockExtent = 4;
+				for (uint32_t level = 0; level < texture.MipLevels(); ++level)
+				{
+					source.levelData.push_back(texture.LevelData(level));
+					source.levelSizes.push_back(texture.LevelSize(level));
+				}
+				source.storage = cooked;
+				return source;
+			}
+		}
 
+		int texWidth, texHeight, texChannels;
+		stbi_uc* pixels = stbi_load_from_memory(sourceFile.data, static_cast<int>(sourceFile.size), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
 		if (!pixels)
 		{
-			throw std::runtime_error("failed to load projected texture image!");
+			throw std::runtime_error("failed to load texture image!");
 		}
-		mProjectedTextureWidth = static_cast<uint32_t>(texWidth);
-		mProjectedTextureHeight = static_cast<uint32_t>(texHeight);
-		createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
 
-		vkMapMemory(device, stagingBufferMemory, 0, imageSize, 0, &data);
-		memcpy(data, pixels, static_cast<size_t>(imageSize));
-		vkUnmapMemory(device, stagingBufferMemory);
+		source.width = static_cast<uint32_t>(texWidth);
+		source.height = static_cast<uint32_t>(texHeight);
+		uint32_t mipLevels = MipGenerator::MipLevelCount(source.width, source.height);
 
+		// Filtering & compression are spread over cook pool, engine pool keeps serving frame recording & simulation
+		auto chain = std::make_shared<std::vector<uint8_t>>(MipGenerator::ChainSize(source.width, source.height, mipLevels));
+		MipGenerator::GenerateRgba8(pixels, source.width, source.height, mipLevels, *textureCookPool, chain->data());
 		stbi_image_free(pixels);
 
-		createImage(texWidth, texHeight, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, projectedTextureImage, projectedTextureImageMemory);
+		if (!compressed)
+		{
+			source.format = VK_FORMAT_R8G8B8A8_UNORM;
+			const uint8_t* levelPixels = chain->data();
+			for (uint32_t level = 0; level < mipLevels; ++level)
+			{
+				size_t levelSize = static_cast<size_t>(MipGenerator::MipExtent(source.width, level)) * MipGenerator::MipExtent(source.height, level) * 4;
+				source.levelData.push_back(levelPixels);
+				source.levelSizes.push_back(levelSize);
+				levelPixels += levelSize;
+			}
+			source.storage = chain;
+			return source;
+		}
 
-		transitionImageLayout(projectedTextureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		copyBufferToImage(stagingBuffer, projectedTextureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-		transitionImageLayout(projectedTextureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		auto levels = std::make_shared<std::vector<std::vector<uint8_t>>>(mipLevels);
+		const uint8_t* levelPixels = chain->data();
+		for (uint32_t level = 0; level < mipLevels; ++level)
+		{
+			uint32_t levelWidth = MipGenerator::MipExtent(source.width, level);
+			uint32_t levelHeight = MipGenerator::MipExtent(source.height, level);
+			(*levels)[level].resize(TextureCompressor::CompressedSize(compressedFormat, levelWidth, levelHeight));
+			TextureCompressor::Compress(compressedFormat, levelPixels, levelWidth, levelHeight, *textureCookPool, (*levels)[level].data());
+			levelPixels += static_cast<size_t>(levelWidth) * levelHeight * 4;
+		}
 
-		vkDestroyBuffer(device, stagingBuffer, nullptr);
-		vkFreeMemory(device, stagingBufferMemory, nullptr);
+		// Cook every level into loose KTX2 for next launch & next pack build
+		SourceFingerprint fingerprint;
+		std::string cookedLoosePath = assets.LoosePath(cookedPath);
+		if (!cookedLoosePath.empty() && sourceFile.Fingerprint(fingerprint))
+		{
+			Ktx2Texture::Write(cookedLoosePath, compressedFormat, source.width, source.height, *levels, fingerprint);
+		}
 
-		// Initialize Projected Texture Scaling Matrix
-		InitializeProjectedTextureScalingMatrix(mProjectedTextureWidth, mProjectedTextureHeight);
+		source.format = compressedFormat;
+		source.blockExtent = 4;
+		for (const std::vector<uint8_t>& level : *levels)
+		{
+			source.levelData.push_back(level.data());
+			source.levelSizes.push_back(level.size());
+		}
+		source.storage = levels;
+		return source;
 	}
 
-	void RendererC::createTextureImageView()
+	bool RendererC::isBlockCompressionSupported(VkFormat format)
 	{
-		textureImageView = createImageView(textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
-		projectedTextureImageView = createImageView(projectedTextureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
+		if (!textureCompressionBC || !TextureCompressor::IsSupported(format))
+		{
+			return false;
+		}
+
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+		return (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
 	}
 
 	void RendererC::createTextureSampler()
@@ -1340,6 +1410,10 @@ namespace AlphonsoGraphicsEngine
 		samplerInfo.compareEnable = VK_FALSE;
 		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
 		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.minLod = 0.0f;
+		// Streamed image only holds resident levels, so its view rather than sampler bounds level of detail
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+		samplerInfo.mipLodBias = 0.0f;
 
 		if (vkCreateSampler(device, &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS)
 		{
@@ -1361,6 +1435,9 @@ namespace AlphonsoGraphicsEngine
 		samplerInfo.compareEnable = VK_FALSE;
 		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
 		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+		samplerInfo.mipLodBias = 0.0f;
 
 		if (vkCreateSampler(device, &samplerInfo, nullptr, &projectedTextureSampler) != VK_SUCCESS)
 		{
@@ -1371,7 +1448,7 @@ namespace AlphonsoGraphicsEngine
 		createShadowMapSampler();
 	}
 
-	VkImageView RendererC::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags)
+	VkImageView RendererC::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels)
 	{
 		VkImageViewCreateInfo viewInfo = {};
 		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -1380,7 +1457,7 @@ namespace AlphonsoGraphicsEngine
 		viewInfo.format = format;
 		viewInfo.subresourceRange.aspectMask = aspectFlags;
 		viewInfo.subresourceRange.baseMipLevel = 0;
-		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.levelCount = mipLevels;
 		viewInfo.subresourceRange.baseArrayLayer = 0;
 		viewInfo.subresourceRange.layerCount = 1;
 
@@ -1392,7 +1469,7 @@ namespace AlphonsoGraphicsEngine
 		return imageView;
 	}
 
-	void RendererC::createImage(uint32_t width, uint32_t height, VkSampleCountFlagBits sampleCount, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+	void RendererC::createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits sampleCount, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, DeviceMemoryAllocator::Allocation& imageAllocation)
 	{
 		VkImageCreateInfo imageInfo = {};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -1400,7 +1477,7 @@ namespace AlphonsoGraphicsEngine
 		imageInfo.extent.width = width;
 		imageInfo.extent.height = height;
 		imageInfo.extent.depth = 1;
-		imageInfo.mipLevels = 1;
+		imageInfo.mipLevels = mipLevels;
 		imageInfo.arrayLayers = 1;
 		imageInfo.format = format;
 		imageInfo.tiling = tiling;
@@ -1414,298 +1491,323 @@ namespace AlphonsoGraphicsEngine
 			throw std::runtime_error("failed to create image!");
 		}
 
-		VkMemoryRequirements memRequirements;
-		vkGetImageMemoryRequirements(device, image, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
-		{
-			throw std::runtime_error("failed to allocate image memory!");
-		}
-		vkBindImageMemory(device, image, imageMemory, 0);
+		imageAllocation = memoryAllocator.AllocateForImage(image, tiling, properties);
 	}
 
-	void RendererC::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout)
+	void RendererC::loadModel(const std::string& modelPath, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
 	{
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-		VkImageMemoryBarrier barrier = {};
-		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier.oldLayout = oldLayout;
-		barrier.newLayout = newLayout;
-		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.image = image;
+		AssetFileSystem::File modelFile = readAsset(modelPath);
+		ObjParser::Mesh mesh;
+		ObjParser::Parse(reinterpret_cast<const char*>(modelFile.data), modelFile.size, mThreadPool, mesh);
 
-		if (newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
+		// Corners are split into ranges whose vertices are built & deduplicated in parallel
+		struct CornerRange
 		{
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+			size_t begin = 0;
+			size_t end = 0;
+			VertexWelder<Vertex> welder;
+			std::vector<uint32_t> localIndices;
+			// Index in merged vertices of each of uniqueVertices
+			std::vector<uint32_t> remap;
+		};
 
-			if (hasStencilComponent(format))
-			{
-				barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
-			}
-		}
-		else
+		const size_t cornerCount = mesh.corners.size();
+		const size_t rangeCount = std::clamp<size_t>(cornerCount / MODEL_CORNERS_PER_RANGE, 1, static_cast<size_t>(mThreadPool.ThreadCount()) * 4);
+		std::vector<CornerRange> ranges(rangeCount);
+		for (size_t i = 0; i < rangeCount; ++i)
 		{
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			ranges[i].begin = cornerCount * i / rangeCount;
+			ranges[i].end = cornerCount * (i + 1) / rangeCount;
 		}
 
-		barrier.subresourceRange.baseMipLevel = 0;
-		barrier.subresourceRange.levelCount = 1;
-		barrier.subresourceRange.baseArrayLayer = 0;
-		barrier.subresourceRange.layerCount = 1;
+		mThreadPool.ParallelFor(static_cast<uint32_t>(rangeCount), [this, &mesh, &ranges](uint32_t rangeIndex)
+		{
+			CornerRange& range = ranges[rangeIndex];
+			range.welder = VertexWelder<Vertex>(range.end - range.begin, MODEL_WELD_EPSILON);
+			range.localIndices.reserve(range.end - range.begin);
+
+			for (size_t i = range.begin; i < range.end; ++i)
+			{
+				const ObjParser::Corner& corner = mesh.corners[i];
+				Vertex vertex = {};
 
-		VkPipelineStageFlags sourceStage;
-		VkPipelineStageFlags destinationStage;
+				vertex.pos = {
+					mesh.positions[3 * corner.position + 0],
+					mesh.positions[3 * corner.position + 1],
+					mesh.positions[3 * corner.position + 2]
+				};
 
-		if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-		{
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				if (corner.normal >= 0)
+				{
+					vertex.normal = {
+						mesh.normals[3 * corner.normal + 0],
+						mesh.normals[3 * corner.normal + 1],
+						mesh.normals[3 * corner.normal + 2]
+					};
+				}
 
-			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		}
-		else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+				if (corner.texCoord >= 0)
+				{
+					vertex.texCoord = {
+						mesh.texCoords[2 * corner.texCoord + 0],
+						1.0f - mesh.texCoords[2 * corner.texCoord + 1]
+					};
+				}
+
+				vertex.color = { 1.0f, 1.0f, 1.0f };
+
+				range.localIndices.push_back(range.welder.Weld(vertex));
+			}
+		});
+
+		// Merging ranges in order keeps vertices in order of first use, exactly as if all corners were processed serially
+		size_t rangeVertexCount = 0;
+		for (const CornerRange& range : ranges)
 		{
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			rangeVertexCount += range.welder.Vertices().size();
+		}
 
-			sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-			destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		VertexWelder<Vertex> welder(rangeVertexCount, MODEL_WELD_EPSILON);
+		for (CornerRange& range : ranges)
+		{
+			range.remap.reserve(range.welder.Vertices().size());
+			for (const Vertex& vertex : range.welder.Vertices())
+			{
+				range.remap.push_back(welder.Weld(vertex));
+			}
 		}
-		else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
+		vertices = welder.TakeVertices();
+
+		indices.resize(cornerCount);
+		mThreadPool.ParallelFor(static_cast<uint32_t>(rangeCount), [&ranges, &indices](uint32_t rangeIndex)
 		{
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			const CornerRange& range = ranges[rangeIndex];
+			for (size_t i = range.begin; i < range.end; ++i)
+			{
+				indices[i] = range.remap[range.localIndices[i - range.begin]];
+			}
+		});
+	}
 
-			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		}
-		else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+	void RendererC::optimizeMesh(const std::string& modelPath, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		// Nothing to reorder, & an empty mesh has no first vertex to point overdraw optimisation at
+		if (vertices.empty() || indices.empty())
 		{
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			return;
 		}
-		else
+
+		uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+		MeshOptimizer::CacheStatistics before = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount, VERTEX_CACHE_SIZE);
+
+		std::vector<uint32_t> clusters = MeshOptimizer::OptimizeVertexCache(indices, vertexCount, VERTEX_CACHE_SIZE);
+		if (OPTIMIZE_MESH_OVERDRAW)
 		{
-			throw std::invalid_argument("unsupported layout transition!");
+			MeshOptimizer::OptimizeOverdraw(indices, clusters, &vertices.data()->pos.x, sizeof(Vertex));
 		}
+		vertices.resize(MeshOptimizer::OptimizeVertexFetch(vertices.data(), vertexCount, static_cast<uint32_t>(sizeof(Vertex)), indices));
 
-		vkCmdPipelineBarrier(
-			commandBuffer,
-			sourceStage, destinationStage,
-			0,
-			0, nullptr,
-			0, nullptr,
-			1, &barrier
-		);
-
-		endSingleTimeCommands(commandBuffer);
+		MeshOptimizer::CacheStatistics after = MeshOptimizer::AnalyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()), VERTEX_CACHE_SIZE);
+		std::cout << modelPath << ": ACMR " << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
 	}
 
-	void RendererC::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
+	void RendererC::createGeometryPool()
 	{
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-		VkBufferImageCopy region = {};
-		region.bufferOffset = 0;
-		region.bufferRowLength = 0;
-		region.bufferImageHeight = 0;
-		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		region.imageSubresource.mipLevel = 0;
-		region.imageSubresource.baseArrayLayer = 0;
-		region.imageSubresource.layerCount = 1;
-		region.imageOffset = { 0, 0, 0 };
-		region.imageExtent = {
-			width,
-			height,
-			1
-		};
+		uint32_t vertexStride = static_cast<uint32_t>(USE_PACKED_VERTICES ? sizeof(PackedVertex) : sizeof(Vertex));
+		geometryPool.Initialize(device, memoryAllocator, uploadManager, vertexStride, GEOMETRY_POOL_VERTEX_CAPACITY, GEOMETRY_POOL_INDEX_CAPACITY);
 
-		vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-		endSingleTimeCommands(commandBuffer);
+		meshes.resize(SCENE_MESH_COUNT);
+		meshes[SCENE_MESH_CHALET] = loadMesh(MODEL_PATH);
+		meshes[SCENE_MESH_CUBE] = loadMesh(CUBE_MODEL_PATH);
 	}
 
-	void RendererC::loadModel(const std::string& modelPath, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	RendererC::LoadedMesh RendererC::loadMesh(const std::string& modelPath)
 	{
-		tinyobj::attrib_t attrib;
-		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
-		std::string warn, err;
+		LoadedMesh mesh;
+		mesh.constants.positionScale = glm::vec4(1.0f);
+		mesh.constants.positionOffset = glm::vec4(0.0f);
 
-		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, modelPath.c_str()))
+		// Packed & float caches differ in stride, so switching format recooks instead of misreading
+		uint32_t vertexStride = static_cast<uint32_t>(USE_PACKED_VERTICES ? sizeof(PackedVertex) : sizeof(Vertex));
+
+		// Up to date cooked mesh skips parsing, see AssetFileSystem::LoosePath
+		AssetFileSystem::File sourceFile = readAsset(modelPath);
+		AssetFileSystem::File cacheFile = assets.Read(MeshCache::CachePath(modelPath), AssetFileSystem::Lookup::LooseFirst);
+		MeshCache cache;
+		if (cacheFile && cache.Load(cacheFile.data, cacheFile.size, vertexStride) && sourceFile.Matches(cache.Source()))
 		{
-			throw std::runtime_error(warn + err);
+			mesh.boundsCenter = (cache.BoundsMin() + cache.BoundsMax()) * 0.5f;
+			mesh.boundsRadius = glm::length(cache.BoundsMax() - cache.BoundsMin()) * 0.5f;
+			if (USE_PACKED_VERTICES)
+			{
+				mesh.constants.positionScale = glm::vec4(cache.BoundsMax() - cache.BoundsMin(), 1.0f);
+				mesh.constants.positionOffset = glm::vec4(cache.BoundsMin(), 0.0f);
+			}
+			mesh.geometry = geometryPool.AddMesh(cache.Vertices(), cache.VertexCount(), cache.Indices(), cache.IndexCount());
+			return mesh;
 		}
+		// Stale cache is unmapped first, Windows won't replace a file which is still mapped
+		cacheFile = AssetFileSystem::File();
 
-		std::unordered_map<Vertex, uint32_t> uniqueVertices = {};
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		loadModel(modelPath, vertices, indices);
+		optimizeMesh(modelPath, vertices, indices);
 
-		for (const auto& shape : shapes)
+		glm::vec3 boundsMin(0.0f);
+		glm::vec3 boundsMax(0.0f);
+		for (size_t i = 0; i < vertices.size(); ++i)
 		{
-			for (const auto& index : shape.mesh.indices)
-			{
-				Vertex vertex = {};
+			boundsMin = i == 0 ? vertices[i].pos : glm::min(boundsMin, vertices[i].pos);
+			boundsMax = i == 0 ? vertices[i].pos : glm::max(boundsMax, vertices[i].pos);
+		}
+		mesh.boundsCenter = (boundsMin + boundsMax) * 0.5f;
+		mesh.boundsRadius = glm::length(boundsMax - boundsMin) * 0.5f;
 
-				vertex.pos = {
-					attrib.vertices[3 * index.vertex_index + 0],
-					attrib.vertices[3 * index.vertex_index + 1],
-					attrib.vertices[3 * index.vertex_index + 2]
-				};
+		const void* vertexData = vertices.data();
+		std::vector<PackedVertex> packedVertices;
+		if (USE_PACKED_VERTICES)
+		{
+			packedVertices = packVertices(vertices, boundsMin, boundsMax);
+			vertexData = packedVertices.data();
+			mesh.constants.positionScale = glm::vec4(boundsMax - boundsMin, 1.0f);
+			mesh.constants.positionOffset = glm::vec4(boundsMin, 0.0f);
+		}
 
-				vertex.normal = {
-					attrib.normals[3 * index.normal_index + 0],
-					attrib.normals[3 * index.normal_index + 1],
-					attrib.normals[3 * index.normal_index + 2]
-				};
+		// Cook mesh cache for next launch
+		uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+		uint32_t indexCount = static_cast<uint32_t>(indices.size());
+		SourceFingerprint fingerprint;
+		std::string cacheLoosePath = assets.LoosePath(MeshCache::CachePath(modelPath));
+		if (!cacheLoosePath.empty() && sourceFile.Fingerprint(fingerprint))
+		{
+			MeshCache::Write(cacheLoosePath, vertexData, vertexCount, vertexStride, indices.data(), indexCount, boundsMin, boundsMax, fingerprint);
+		}
 
-				vertex.texCoord = {
-					attrib.texcoords[2 * index.texcoord_index + 0],
-					1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-				};
+		mesh.geometry = geometryPool.AddMesh(vertexData, vertexCount, indices.data(), indexCount);
+		return mesh;
+	}
 
-				vertex.color = { 1.0f, 1.0f, 1.0f };
+	std::vector<RendererC::PackedVertex> RendererC::packVertices(const std::vector<Vertex>& vertices, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		// Flat axes get a unit extent, so they quantise to 0 instead of dividing by zero
+		glm::vec3 extent = boundsMax - boundsMin;
+		glm::vec3 inverseExtent = glm::vec3(
+			extent.x > 0.0f ? 1.0f / extent.x : 1.0f,
+			extent.y > 0.0f ? 1.0f / extent.y : 1.0f,
+			extent.z > 0.0f ? 1.0f / extent.z : 1.0f);
 
-				if (uniqueVertices.count(vertex) == 0) {
-					uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-					vertices.push_back(vertex);
-				}
+		std::vector<PackedVertex> packedVertices(vertices.size());
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			const Vertex& vertex = vertices[i];
+			PackedVertex& packedVertex = packedVertices[i];
 
-				indices.push_back(uniqueVertices[vertex]);
-			}
+			glm::vec3 position = (vertex.pos - boundsMin) * inverseExtent;
+			packedVertex.pos[0] = VertexPacking::QuantizeUnorm16(position.x);
+			packedVertex.pos[1] = VertexPacking::QuantizeUnorm16(position.y);
+			packedVertex.pos[2] = VertexPacking::QuantizeUnorm16(position.z);
+			packedVertex.pos[3] = 0;
+			packedVertex.texCoord[0] = VertexPacking::FloatToHalf(vertex.texCoord.x);
+			packedVertex.texCoord[1] = VertexPacking::FloatToHalf(vertex.texCoord.y);
+			VertexPacking::EncodeOctahedral(vertex.normal, packedVertex.normal);
 		}
+		return packedVertices;
 	}
 
-	void RendererC::createVertexBuffers()
+	void RendererC::drawMesh(VkCommandBuffer commandBuffer, VkPipelineLayout layout, const LoadedMesh& mesh, const glm::mat4& model, VkIndexType& boundIndexType)
 	{
-		createVertexBuffer(vertices, vertexBuffer, vertexBufferMemory);
-		createVertexBuffer(cubeVertices, cubeVertexBuffer, cubeVertexBufferMemory);
+		DrawConstants constants;
+		constants.model = model;
+		constants.mesh = mesh.constants;
+		vkCmdPushConstants(commandBuffer, layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawConstants), &constants);
+		geometryPool.BindIndexType(commandBuffer, mesh.geometry, boundIndexType);
+		vkCmdDrawIndexed(commandBuffer, mesh.geometry.indexCount, 1, mesh.geometry.firstIndex, mesh.geometry.vertexOffset, 0);
 	}
 
-	void RendererC::createVertexBuffer(std::vector<Vertex>& vertices, VkBuffer& vertexBuffer, VkDeviceMemory& vertexBufferMemory)
+	void RendererC::createFrameContexts()
 	{
-		VkDeviceSize bufferSize = static_cast<VkDeviceSize>(sizeof(vertices[0])) * static_cast<VkDeviceSize>(vertices.size());
-
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
-		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+		frames.resize(framesInFlight);
 
-		void* data;
-		vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-		memcpy(data, vertices.data(), (size_t)bufferSize);
-		vkUnmapMemory(device, stagingBufferMemory);
-
-		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
-
-		copyBuffer(stagingBuffer, vertexBuffer, bufferSize);
+		createCommandBuffers();
+		createSyncObjects();
 
-		vkDestroyBuffer(device, stagingBuffer, nullptr);
-		vkFreeMemory(device, stagingBufferMemory, nullptr);
+		currentFrame = 0;
 	}
 
-	void RendererC::createIndexBuffers()
+	void RendererC::destroyFrameContexts()
 	{
-		createIndexBuffer(indices, indexBuffer, indexBufferMemory);
-		createIndexBuffer(cubeIndices, cubeIndexBuffer, cubeIndexBufferMemory);
+		for (FrameContext& frame : frames)
+		{
+			// Destroying the pools frees every command buffer allocated from them.
+			vkDestroyCommandPool(device, frame.commandPool, nullptr);
+			vkDestroyCommandPool(device, frame.shadowPassCommandPool, nullptr);
+			vkDestroyCommandPool(device, frame.scenePassCommandPool, nullptr);
+			vkDestroyCommandPool(device, frame.uiCommandPool, nullptr);
+
+			vkDestroySemaphore(device, frame.renderFinishedSemaphore, nullptr);
+			vkDestroySemaphore(device, frame.imageAvailableSemaphore, nullptr);
+			vkDestroyFence(device, frame.inFlightFence, nullptr);
+		}
+		frames.clear();
 	}
 
-	void RendererC::createIndexBuffer(std::vector<uint32_t>& indices, VkBuffer& indexBuffer, VkDeviceMemory& indexBufferMemory)
+	void RendererC::SetFramesInFlight(uint32_t frameCount)
 	{
-		VkDeviceSize bufferSize = static_cast<VkDeviceSize>(sizeof(indices[0])) * static_cast<VkDeviceSize>(indices.size());
-
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
-		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-
-		void* data;
-		vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-		memcpy(data, indices.data(), (size_t)bufferSize);
-		vkUnmapMemory(device, stagingBufferMemory);
-
-		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
+		frameCount = std::clamp(frameCount, 1u, MAX_FRAMES_IN_FLIGHT);
+		if (frameCount == framesInFlight)
+		{
+			return;
+		}
 
-		copyBuffer(stagingBuffer, indexBuffer, bufferSize);
+		framesInFlight = frameCount;
+		if (!frames.empty())
+		{
+			vkDeviceWaitIdle(device);
+			destroyFrameContexts();
+			createFrameContexts();
+		}
+	}
 
-		vkDestroyBuffer(device, stagingBuffer, nullptr);
-		vkFreeMemory(device, stagingBufferMemory, nullptr);
+	uint32_t RendererC::FramesInFlight() const
+	{
+		return framesInFlight;
 	}
 
 	void RendererC::createUniformBuffers()
 	{
-		VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-		VkDeviceSize fragmentUniformBufferSize = sizeof(FragmentUniformBufferObject);
-		VkDeviceSize offscreenbufferSize = sizeof(OffscreenUniformBufferObjectVS);
-		VkDeviceSize proxyUniformBufferSize = sizeof(ProxyModelUniformBufferObject);
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
 
-		uniformBuffers.resize(swapChainImages.size());
-		uniformBuffersMemory.resize(swapChainImages.size());
-		fragmentUniformBuffers.resize(swapChainImages.size());
-		fragmentUniformBuffersMemory.resize(swapChainImages.size());
-		offscreenUniformBuffers.resize(1);
-		offscreenUniformBuffersMemory.resize(1);
-		proxyModelsUniformBuffers.resize(swapChainImages.size());
-		proxyModelsUniformBuffersMemory.resize(swapChainImages.size());
+		// One region per possible frame in flight, so changing frame count never reallocates the ring.
+		VkDeviceSize alignment = properties.limits.minUniformBufferOffsetAlignment;
+		VkDeviceSize regionSize = UniformRingBuffer::AlignUp(UNIFORM_RING_FRAME_SIZE, alignment);
 
-		for (size_t i = 0; i < swapChainImages.size(); i++)
-		{
-			createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBuffers[i], uniformBuffersMemory[i]);
-			createBuffer(fragmentUniformBufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, fragmentUniformBuffers[i], fragmentUniformBuffersMemory[i]);
-			createBuffer(proxyUniformBufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, proxyModelsUniformBuffers[i], proxyModelsUniformBuffersMemory[i]);
-		}
-		createBuffer(offscreenbufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, offscreenUniformBuffers[0], offscreenUniformBuffersMemory[0]);
+		VkBuffer ringBuffer;
+		DeviceMemoryAllocator::Allocation ringBufferAllocation;
+		createBuffer(regionSize * MAX_FRAMES_IN_FLIGHT, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, ringBuffer, ringBufferAllocation);
+		uniformRingBuffer.Initialize(device, memoryAllocator, ringBuffer, ringBufferAllocation, regionSize, MAX_FRAMES_IN_FLIGHT, alignment);
 	}
 
 	void RendererC::createDescriptorPool()
 	{
-		std::array<VkDescriptorPoolSize, 14> poolSizes = {};
-		// First 3 Pool are for model pipeline.
-		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSizes[0].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
+		// Scene set is replaced whenever a streamed texture changes or window is resized & old one lives on until frames in flight
+		// are done with it, which is at most one retired scene set of each kind per frame in flight.
+		std::array<VkDescriptorPoolSize, 2> poolSizes = {};
+		// Model pipeline ( vertex & fragment ), Proxy Model pipeline & Shadow Mapping pipeline uniform slices.
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		poolSizes[0].descriptorCount = 4 + 4 * MAX_FRAMES_IN_FLIGHT;
+		// Model texture, Projective Texture & Shadow Map, plus one used by ImGui font texture.
 		poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSizes[1].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
-		poolSizes[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSizes[2].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
-		// This one is for Projective Texture Mapping
-		poolSizes[3].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSizes[3].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
-		// Descriptor Pool for passing Shadow Map
-		poolSizes[4].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSizes[4].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
-		// This Descriptor Pool is Used by ImGui
-		poolSizes[5].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSizes[5].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
-		// This Descriptor Pool is Used by Proxy Model Pipeline
-		poolSizes[6].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSizes[6].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
-		// These remaining pools are used by Shadow Mapping Pipeline
-		poolSizes[7].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSizes[7].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
-		poolSizes[8].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSizes[8].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
-		poolSizes[9].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSizes[9].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
-		poolSizes[10].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSizes[10].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
-		poolSizes[11].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSizes[11].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
-		poolSizes[12].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSizes[12].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
-		poolSizes[13].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSizes[13].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
+		poolSizes[1].descriptorCount = 4 + 6 * MAX_FRAMES_IN_FLIGHT;
 
 		VkDescriptorPoolCreateInfo poolInfo = {};
 		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
 		poolInfo.pPoolSizes = poolSizes.data();
-		poolInfo.maxSets = static_cast<uint32_t>(swapChainImages.size()) + 11;
+		// Uniform data for every frame in flight lives in one ring buffer, so a single set per pipeline is enough.
+		poolInfo.maxSets = 4 + 2 * MAX_FRAMES_IN_FLIGHT;
 
 		if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
 		{
@@ -1715,156 +1817,247 @@ namespace AlphonsoGraphicsEngine
 
 	void RendererC::createDescriptorSets()
 	{
-		std::vector<VkDescriptorSetLayout> layouts(swapChainImages.size(), descriptorSetLayout);
+		std::array<VkDescriptorSetLayout, 3> layouts = { descriptorSetLayout, proxyModelsPipelineDescriptorSetLayout, shadowMapPipelineDescriptorSetLayout };
 		VkDescriptorSetAllocateInfo allocInfo = {};
 		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
 		allocInfo.descriptorPool = descriptorPool;
-		allocInfo.descriptorSetCount = static_cast<uint32_t>(swapChainImages.size());
+		allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
 		allocInfo.pSetLayouts = layouts.data();
 
-		descriptorSets.resize(swapChainImages.size());
-		if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) != VK_SUCCESS)
+		std::array<VkDescriptorSet, 3> sets = {};
+		if (vkAllocateDescriptorSets(device, &allocInfo, sets.data()) != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to allocate descriptor sets!");
 		}
+		descriptorSet = sets[0];
+		proxyModelDescriptorSet = sets[1];
+		shadowMapDescriptorSet = sets[2];
 
-		for (size_t i = 0; i < swapChainImages.size(); i++)
-		{
-			VkDescriptorBufferInfo bufferInfo = {};
-			bufferInfo.buffer = uniformBuffers[i];
-			bufferInfo.offset = 0;
-			bufferInfo.range = sizeof(UniformBufferObject);
-
-			VkDescriptorImageInfo imageInfo = {};
-			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			imageInfo.imageView = textureImageView;
-			imageInfo.sampler = textureSampler;
-
-			VkDescriptorBufferInfo fragmentUniformBufferInfo = {};
-			fragmentUniformBufferInfo.buffer = fragmentUniformBuffers[i];
-			fragmentUniformBufferInfo.offset = 0;
-			fragmentUniformBufferInfo.range = sizeof(FragmentUniformBufferObject);
-
-			VkDescriptorImageInfo projectedTextureImageInfo = {};
-			projectedTextureImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			projectedTextureImageInfo.imageView = projectedTextureImageView;
-			projectedTextureImageInfo.sampler = projectedTextureSampler;
-
-			VkDescriptorImageInfo shadowMapImageInfo = {};
-			shadowMapImageInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
-			shadowMapImageInfo.imageView = shadowMapImageView;
-			shadowMapImageInfo.sampler = shadowMapSampler;
-
-			std::array<VkWriteDescriptorSet, 5> descriptorWrites = {};
-
-			descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[0].dstSet = descriptorSets[i];
-			descriptorWrites[0].dstBinding = 0;
-			descriptorWrites[0].dstArrayElement = 0;
-			descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			descriptorWrites[0].descriptorCount = 1;
-			descriptorWrites[0].pBufferInfo = &bufferInfo;
-
-			descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[1].dstSet = descriptorSets[i];
-			descriptorWrites[1].dstBinding = 1;
-			descriptorWrites[1].dstArrayElement = 0;
-			descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			descriptorWrites[1].descriptorCount = 1;
-			descriptorWrites[1].pImageInfo = &imageInfo;
-
-			descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[2].dstSet = descriptorSets[i];
-			descriptorWrites[2].dstBinding = 2;
-			descriptorWrites[2].dstArrayElement = 0;
-			descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			descriptorWrites[2].descriptorCount = 1;
-			descriptorWrites[2].pBufferInfo = &fragmentUniformBufferInfo;
-
-			descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[3].dstSet = descriptorSets[i];
-			descriptorWrites[3].dstBinding = 3;
-			descriptorWrites[3].dstArrayElement = 0;
-			descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			descriptorWrites[3].descriptorCount = 1;
-			descriptorWrites[3].pImageInfo = &projectedTextureImageInfo;
-
-			descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[4].dstSet = descriptorSets[i];
-			descriptorWrites[4].dstBinding = 4;
-			descriptorWrites[4].dstArrayElement = 0;
-			descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			descriptorWrites[4].descriptorCount = 1;
-			descriptorWrites[4].pImageInfo = &shadowMapImageInfo;
-
-			vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
-		}
+		writeSceneDescriptorSet(descriptorSet);
 
+		// Uniform buffer descriptors point at start of ring buffer, dynamic offsets select the slice.
 		// Descriptor set for offscreen rendering
+		VkDescriptorBufferInfo offscreenBufferInfo = {};
+		offscreenBufferInfo.buffer = uniformRingBuffer.Buffer();
+		offscreenBufferInfo.offset = 0;
+		offscreenBufferInfo.range = sizeof(OffscreenUniformBufferObjectVS);
 
-		VkDescriptorSetAllocateInfo shadowMapDSallocInfo = {};
-		shadowMapDSallocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		shadowMapDSallocInfo.descriptorPool = descriptorPool;
-		shadowMapDSallocInfo.descriptorSetCount = 1;
-		shadowMapDSallocInfo.pSetLayouts = &shadowMapPipelineDescriptorSetLayout;
+		// Descriptor set for proxy models pipeline
+		VkDescriptorBufferInfo proxyModelBufferInfo = {};
+		proxyModelBufferInfo.buffer = uniformRingBuffer.Buffer();
+		proxyModelBufferInfo.offset = 0;
+		proxyModelBufferInfo.range = sizeof(ProxyModelUniformBufferObject);
 
-		if (vkAllocateDescriptorSets(device, &shadowMapDSallocInfo, &shadowMapPipelineDescriptorSet) != VK_SUCCESS)
-		{
-			throw std::runtime_error("failed to allocate descriptor sets!");
-		}
+		std::array<VkWriteDescriptorSet, 2> descriptorWrites = {};
+
+		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[0].dstSet = shadowMapDescriptorSet;
+		descriptorWrites[0].dstBinding = 0;
+		descriptorWrites[0].dstArrayElement = 0;
+		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		descriptorWrites[0].descriptorCount = 1;
+		descriptorWrites[0].pBufferInfo = &offscreenBufferInfo;
+
+		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[1].dstSet = proxyModelDescriptorSet;
+		descriptorWrites[1].dstBinding = 0;
+		descriptorWrites[1].dstArrayElement = 0;
+		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		descriptorWrites[1].descriptorCount = 1;
+		descriptorWrites[1].pBufferInfo = &proxyModelBufferInfo;
+
+		vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+	}
 
+	void RendererC::writeSceneDescriptorSet(VkDescriptorSet set)
+	{
+		// Uniform buffer descriptors point at start of ring buffer, dynamic offsets select the slice.
 		VkDescriptorBufferInfo bufferInfo = {};
-		bufferInfo.buffer = offscreenUniformBuffers[0];
+		bufferInfo.buffer = uniformRingBuffer.Buffer();
 		bufferInfo.offset = 0;
-		bufferInfo.range = sizeof(OffscreenUniformBufferObjectVS);
+		bufferInfo.range = sizeof(UniformBufferObject);
+
+		VkDescriptorImageInfo imageInfo = {};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = textureStreamer.View(modelTexture);
+		imageInfo.sampler = textureSampler;
+
+		VkDescriptorBufferInfo fragmentUniformBufferInfo = {};
+		fragmentUniformBufferInfo.buffer = uniformRingBuffer.Buffer();
+		fragmentUniformBufferInfo.offset = 0;
+		fragmentUniformBufferInfo.range = sizeof(FragmentUniformBufferObject);
+
+		VkDescriptorImageInfo projectedTextureImageInfo = {};
+		projectedTextureImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		projectedTextureImageInfo.imageView = textureStreamer.View(projectedTexture);
+		projectedTextureImageInfo.sampler = projectedTextureSampler;
+
+		VkDescriptorImageInfo shadowMapImageInfo = {};
+		shadowMapImageInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		shadowMapImageInfo.imageView = renderGraph.ImageView(shadowMapResource);
+		shadowMapImageInfo.sampler = shadowMapSampler;
+
+		std::array<VkWriteDescriptorSet, 5> descriptorWrites = {};
 
-		std::array<VkWriteDescriptorSet, 1> descriptorWrites = {};
 		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[0].dstSet = shadowMapPipelineDescriptorSet;
+		descriptorWrites[0].dstSet = set;
 		descriptorWrites[0].dstBinding = 0;
 		descriptorWrites[0].dstArrayElement = 0;
-		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		descriptorWrites[0].descriptorCount = 1;
 		descriptorWrites[0].pBufferInfo = &bufferInfo;
 
+		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[1].dstSet = set;
+		descriptorWrites[1].dstBinding = 1;
+		descriptorWrites[1].dstArrayElement = 0;
+		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrites[1].descriptorCount = 1;
+		descriptorWrites[1].pImageInfo = &imageInfo;
+
+		descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[2].dstSet = set;
+		descriptorWrites[2].dstBinding = 2;
+		descriptorWrites[2].dstArrayElement = 0;
+		descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		descriptorWrites[2].descriptorCount = 1;
+		descriptorWrites[2].pBufferInfo = &fragmentUniformBufferInfo;
+
+		descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[3].dstSet = set;
+		descriptorWrites[3].dstBinding = 3;
+		descriptorWrites[3].dstArrayElement = 0;
+		descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrites[3].descriptorCount = 1;
+		descriptorWrites[3].pImageInfo = &projectedTextureImageInfo;
+
+		descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[4].dstSet = set;
+		descriptorWrites[4].dstBinding = 4;
+		descriptorWrites[4].dstArrayElement = 0;
+		descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrites[4].descriptorCount = 1;
+		descriptorWrites[4].pImageInfo = &shadowMapImageInfo;
+
 		vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+	}
 
-		// Descriptor Sets for proxy models pipeline
-		std::vector<VkDescriptorSetLayout> proxyModelDSLayout(swapChainImages.size(), proxyModelsPipelineDescriptorSetLayout);
-		VkDescriptorSetAllocateInfo proxyModelsDescriptorSetAllocInfo = {};
-		proxyModelsDescriptorSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		proxyModelsDescriptorSetAllocInfo.descriptorPool = descriptorPool;
-		proxyModelsDescriptorSetAllocInfo.descriptorSetCount = static_cast<uint32_t>(swapChainImages.size());
-		proxyModelsDescriptorSetAllocInfo.pSetLayouts = proxyModelDSLayout.data();
+	void RendererC::replaceSceneDescriptorSet()
+	{
+		// Frames in flight may still be reading current set, so new views go into a fresh one & old one is retired
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = descriptorPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &descriptorSetLayout;
 
-		proxyModelDescriptorSets.resize(swapChainImages.size());
-		if (vkAllocateDescriptorSets(device, &proxyModelsDescriptorSetAllocInfo, proxyModelDescriptorSets.data()) != VK_SUCCESS)
+		VkDescriptorSet newDescriptorSet;
+		if (vkAllocateDescriptorSets(device, &allocInfo, &newDescriptorSet) != VK_SUCCESS)
 		{
-			throw std::runtime_error("failed to allocate descriptor sets!");
+			throw std::runtime_error("failed to allocate scene descriptor set!");
+		}
+		writeSceneDescriptorSet(newDescriptorSet);
+
+		RetiredDescriptorSet retired;
+		retired.set = descriptorSet;
+		retired.releaseFrame = frameNumber + frames.size();
+		retiredDescriptorSets.push_back(retired);
+		descriptorSet = newDescriptorSet;
+
+		// Scene pass binds descriptor set inside its pre-recorded secondary
+		invalidateStaticCommandBuffers();
+	}
+
+	void RendererC::releaseRetiredResources(uint64_t frame)
+	{
+		auto releasedSets = std::remove_if(retiredDescriptorSets.begin(), retiredDescriptorSets.end(), [this, frame](const RetiredDescriptorSet& retired)
+		{
+			if (retired.releaseFrame > frame)
+			{
+				return false;
+			}
+			vkFreeDescriptorSets(device, descriptorPool, 1, &retired.set);
+			return true;
+		});
+		retiredDescriptorSets.erase(releasedSets, retiredDescriptorSets.end());
+
+		// Framebuffers go before swapchain views they were created from
+		renderGraph.ReleaseRetired(frame);
+		auto releasedSwapChains = std::remove_if(retiredSwapChains.begin(), retiredSwapChains.end(), [this, frame](const RetiredSwapChain& retired)
+		{
+			if (retired.releaseFrame > frame)
+			{
+				return false;
+			}
+			for (VkImageView imageView : retired.imageViews)
+			{
+				vkDestroyImageView(device, imageView, nullptr);
+			}
+			vkDestroySwapchainKHR(device, retired.swapChain, nullptr);
+			return true;
+		});
+		retiredSwapChains.erase(releasedSwapChains, retiredSwapChains.end());
+	}
+
+	void RendererC::waitForFramesInFlight()
+	{
+		// Fences of frames which never submitted were left signaled, so this returns once all submitted work is done
+		std::vector<VkFence> fences;
+		for (const FrameContext& frame : frames)
+		{
+			fences.push_back(frame.inFlightFence);
 		}
+		vkWaitForFences(device, static_cast<uint32_t>(fences.size()), fences.data(), VK_TRUE, std::numeric_limits<uint64_t>::max());
+		releaseRetiredResources(UINT64_MAX);
+	}
 
-		for (size_t i = 0; i < swapChainImages.size(); i++)
+	void RendererC::requestTextureResidency()
+	{
+		const RenderSnapshot& snapshot = *mRenderSnapshot;
+
+		// Largest projected diameter in pixels of bounding spheres of lit objects. Both textures end up covering that area of screen.
+		float screenSize = 0.0f;
+		for (const RenderSnapshot::RenderItem& item : snapshot.renderItems)
 		{
-			VkDescriptorBufferInfo bufferInfo = {};
-			bufferInfo.buffer = proxyModelsUniformBuffers[i];
-			bufferInfo.offset = 0;
-			bufferInfo.range = sizeof(ProxyModelUniformBufferObject);
+			if (item.component.material != SCENE_MATERIAL_LIT)
+			{
+				continue;
+			}
 
-			std::array<VkWriteDescriptorSet, 1> descriptorWrites = {};
+			const LoadedMesh& mesh = meshes[item.component.mesh];
+			glm::vec4 viewCenter = snapshot.cameraView * item.model * glm::vec4(mesh.boundsCenter, 1.0f);
+			float modelScale = std::max({ glm::length(glm::vec3(item.model[0])), glm::length(glm::vec3(item.model[1])), glm::length(glm::vec3(item.model[2])) });
+			float radius = mesh.boundsRadius * modelScale;
+			float distance = -viewCenter.z;
+			if (distance <= radius)
+			{
+				screenSize = std::numeric_limits<float>::max();
+				break;
+			}
+			screenSize = std::max(screenSize, radius / distance * snapshot.cameraProjection[1][1] * swapChainExtent.height);
+		}
 
-			descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[0].dstSet = proxyModelDescriptorSets[i];
-			descriptorWrites[0].dstBinding = 0;
-			descriptorWrites[0].dstArrayElement = 0;
-			descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			descriptorWrites[0].descriptorCount = 1;
-			descriptorWrites[0].pBufferInfo = &bufferInfo;
+		float priority = std::min(screenSize, static_cast<float>(swapChainExtent.height));
+		priority *= priority;
+		textureStreamer.RequestResidency(modelTexture, textureLevelForScreenSize(modelTexture, screenSize), priority);
+		textureStreamer.RequestResidency(projectedTexture, textureLevelForScreenSize(projectedTexture, screenSize), priority);
+	}
 
-			vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+	uint32_t RendererC::textureLevelForScreenSize(TextureStreamer::TextureHandle texture, float screenSize)
+	{
+		// Until texture is loaded its size is unknown, so its finest level is asked for
+		uint32_t extent = std::max(textureStreamer.Width(texture), textureStreamer.Height(texture));
+		if (extent == 0 || screenSize >= extent)
+		{
+			return 0;
 		}
+
+		// Each coarser level halves texels across object, no finer level than one texel per pixel is worth having
+		float texelsPerPixel = extent / std::max(screenSize, 1.0f);
+		return static_cast<uint32_t>(std::floor(std::log2(texelsPerPixel)));
 	}
 
-	void RendererC::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+	void RendererC::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, DeviceMemoryAllocator::Allocation& bufferAllocation)
 	{
 		VkBufferCreateInfo bufferInfo = {};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -1877,20 +2070,7 @@ namespace AlphonsoGraphicsEngine
 			throw std::runtime_error("failed to create buffer!");
 		}
 
-		VkMemoryRequirements memRequirements;
-		vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
-		{
-			throw std::runtime_error("failed to allocate buffer memory!");
-		}
-
-		vkBindBufferMemory(device, buffer, bufferMemory, 0);
+		bufferAllocation = memoryAllocator.AllocateForBuffer(buffer, properties);
 	}
 
 	VkCommandBuffer RendererC::beginSingleTimeCommands()
@@ -1928,54 +2108,249 @@ namespace AlphonsoGraphicsEngine
 		vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
 	}
 
-	void RendererC::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+	void RendererC::createCommandBuffers()
 	{
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+		for (FrameContext& frame : frames)
+		{
+			// Every pass records from its own pool, so workers never share a pool & each pool is reset
+			// as a whole right before its pass is recorded again ( UI & primary every frame, static passes when dirty ).
+			createFrameCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, frame.commandPool, frame.commandBuffer);
+			createFrameCommandBuffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY, frame.shadowPassCommandPool, frame.shadowPassCommandBuffer);
+			createFrameCommandBuffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY, frame.scenePassCommandPool, frame.scenePassCommandBuffer);
+			createFrameCommandBuffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY, frame.uiCommandPool, frame.uiCommandBuffer);
+		}
 
-		VkBufferCopy copyRegion = {};
-		copyRegion.size = size;
-		vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+		// Freshly allocated buffers hold nothing yet.
+		invalidateStaticCommandBuffers();
+	}
 
-		endSingleTimeCommands(commandBuffer);
+	void RendererC::createFrameCommandBuffer(VkCommandBufferLevel level, VkCommandPool& pool, VkCommandBuffer& commandBuffer)
+	{
+		QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		if (vkCreateCommandPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create frame command pool!");
+		}
+
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = pool;
+		allocInfo.level = level;
+		allocInfo.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate command buffers!");
+		}
 	}
 
-	uint32_t RendererC::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+	void RendererC::invalidateStaticCommandBuffers()
 	{
-		VkPhysicalDeviceMemoryProperties memProperties;
-		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+		for (FrameContext& frame : frames)
+		{
+			frame.staticCommandBuffersDirty = true;
+		}
+	}
+
+	void RendererC::setViewportAndScissor(VkCommandBuffer commandBuffer, VkExtent2D extent)
+	{
+		VkViewport viewport = {};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = (float)extent.width;
+		viewport.height = (float)extent.height;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+		VkRect2D scissor = {};
+		scissor.offset = { 0, 0 };
+		scissor.extent = extent;
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	}
 
-		for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+	void RendererC::recordShadowPassCommandBuffer(FrameContext& frame)
+	{
+		/*
+		First render pass: Generate shadow map by rendering the scene from light's POV
+		*/
 		{
-			if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-				return i;
+			vkResetCommandPool(device, frame.shadowPassCommandPool, 0);
+			VkCommandBuffer commandBuffer = frame.shadowPassCommandBuffer;
+
+			VkCommandBufferInheritanceInfo inheritanceInfo = {};
+			inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+			inheritanceInfo.renderPass = shadowMapRenderPass;
+			inheritanceInfo.subpass = 0;
+			inheritanceInfo.framebuffer = renderGraph.Framebuffer(shadowMapPass, 0);
+
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+			beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+			if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to begin recording shadow pass command buffer!");
+			}
+
+			// Shadow map is sized like swapchain
+			setViewportAndScissor(commandBuffer, swapChainExtent);
+
+			// Set depth bias (aka "Polygon offset")
+			// Required to avoid shadow mapping artefacts
+			vkCmdSetDepthBias(commandBuffer, depthBiasConstant, 0.0f, depthBiasSlope);
+
+			// Nothing samples shadow map while shadows are off, so pass only clears it
+			if (frame.sceneFeatures & SCENE_FEATURE_SHADOW)
+			{
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineCompiler.Get(shadowMapPipeline));
+				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shadowMapPipelineLayout, 0, 1, &shadowMapDescriptorSet, 1, &frame.uniformOffsets.offscreen);
+				VkIndexType boundIndexType = meshes.front().geometry.indexType;
+				geometryPool.Bind(commandBuffer, boundIndexType);
+				for (const RenderSnapshot::RenderItem& item : mRenderSnapshot->renderItems)
+				{
+					if (item.component.castsShadow)
+					{
+						drawMesh(commandBuffer, shadowMapPipelineLayout, meshes[item.component.mesh], item.model, boundIndexType);
+					}
+				}
+			}
+
+			if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to record shadow pass command buffer!");
 			}
 		}
+	}
+
+	void RendererC::recordScenePassCommandBuffer(FrameContext& frame)
+	{
+		/*
+		Second render pass: Draw proxy models & lit models
+		*/
+		{
+			vkResetCommandPool(device, frame.scenePassCommandPool, 0);
+			VkCommandBuffer commandBuffer = frame.scenePassCommandBuffer;
+
+			VkCommandBufferInheritanceInfo inheritanceInfo = {};
+			inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+			inheritanceInfo.renderPass = renderPass;
+			inheritanceInfo.subpass = 0;
+			// Framebuffer is left unspecified since this frame may render into any swapchain image.
+			inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+			beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+			if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to begin recording scene pass command buffer!");
+			}
 
-		throw std::runtime_error("failed to find suitable memory type!");
+			// Dynamic state isn't inherited from primary command buffer
+			setViewportAndScissor(commandBuffer, swapChainExtent);
+
+			// Every mesh lives in geometry pool, so buffers are bound once for whole pass & index buffer only when index type changes
+			VkIndexType boundIndexType = meshes.front().geometry.indexType;
+			geometryPool.Bind(commandBuffer, boundIndexType);
+
+			// Objects are drawn grouped by material, so each pipeline is bound once
+			const std::vector<RenderSnapshot::RenderItem>& renderItems = mRenderSnapshot->renderItems;
+
+			// Draw proxy models using Proxy Model pipeline
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineCompiler.Get(proxyModelsPipeline));
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, proxyModelsPipelineLayout, 0, 1, &proxyModelDescriptorSet, 1, &frame.uniformOffsets.proxyModel);
+			for (const RenderSnapshot::RenderItem& item : renderItems)
+			{
+				if (item.component.material == SCENE_MATERIAL_PROXY)
+				{
+					drawMesh(commandBuffer, proxyModelsPipelineLayout, meshes[item.component.mesh], item.model, boundIndexType);
+				}
+			}
+
+			// Bind model Pipeline to draw lit models
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineCompiler.Get(frame.scenePipeline));
+			// Dynamic offsets follow binding order: vertex UBO ( binding 0 ), fragment UBO ( binding 2 )
+			std::array<uint32_t, 2> dynamicOffsets = { frame.uniformOffsets.scene, frame.uniformOffsets.fragment };
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+			for (const RenderSnapshot::RenderItem& item : renderItems)
+			{
+				if (item.component.material == SCENE_MATERIAL_LIT)
+				{
+					drawMesh(commandBuffer, pipelineLayout, meshes[item.component.mesh], item.model, boundIndexType);
+				}
+			}
+
+			if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to record scene pass command buffer!");
+			}
+		}
 	}
 
-	void RendererC::createCommandBuffers()
+	void RendererC::recordUICommandBuffer(FrameContext& frame)
 	{
-		commandBuffers.resize(swapChainFramebuffers.size());
+		vkResetCommandPool(device, frame.uiCommandPool, 0);
+		VkCommandBuffer commandBuffer = frame.uiCommandBuffer;
 
-		VkCommandBufferAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.commandPool = commandPool;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandBufferCount = (uint32_t)commandBuffers.size();
+		VkCommandBufferInheritanceInfo inheritanceInfo = {};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
 
-		if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
 		{
-			throw std::runtime_error("failed to allocate command buffers!");
+			throw std::runtime_error("failed to begin recording UI command buffer!");
+		}
+
+		// Bind Dear Imgui pipeline to draw UI elements inside UI box
+		ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to record UI command buffer!");
 		}
 	}
 
-	void RendererC::createSyncObjects()
+	void RendererC::recordCommandBuffer(FrameContext& frame, uint32_t imageIndex)
 	{
-		imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+		vkResetCommandPool(device, frame.commandPool, 0);
+		VkCommandBuffer commandBuffer = frame.commandBuffer;
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to begin recording command buffer!");
+		}
 
+		// Barriers, render passes & execution of pass secondaries are all derived by render graph
+		renderGraph.Execute(commandBuffer, imageIndex);
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to record command buffer!");
+		}
+	}
+
+	void RendererC::createSyncObjects()
+	{
 		VkSemaphoreCreateInfo semaphoreInfo = {};
 		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
@@ -1983,72 +2358,68 @@ namespace AlphonsoGraphicsEngine
 		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-		for (size_t i = 0; i < static_cast<size_t>(MAX_FRAMES_IN_FLIGHT); i++)
+		for (FrameContext& frame : frames)
 		{
-			if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
-				vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS ||
-				vkCreateFence(device, &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS)
+			if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &frame.imageAvailableSemaphore) != VK_SUCCESS ||
+				vkCreateSemaphore(device, &semaphoreInfo, nullptr, &frame.renderFinishedSemaphore) != VK_SUCCESS ||
+				vkCreateFence(device, &fenceInfo, nullptr, &frame.inFlightFence) != VK_SUCCESS)
 			{
 				throw std::runtime_error("failed to create synchronization objects for a frame!");
 			}
 		}
 	}
 
-	void RendererC::updateUniformBuffer(uint32_t currentImage)
+	void RendererC::updateUniformBuffer(FrameContext& frame)
 	{
 		UniformBufferObject ubo = {};
 		FragmentUniformBufferObject fbo = {};
 		ProxyModelUniformBufferObject pmubo = {};
 
-		ubo.model = glm::mat4(1);
-		ubo.view = mCamera->ViewMatrix();
-		ubo.proj = mCamera->ProjectionMatrix();
+		const RenderSnapshot& snapshot = *mRenderSnapshot;
+
+		ubo.view = snapshot.cameraView;
+		ubo.proj = snapshot.cameraProjection;
 		ubo.lightDirection = glm::vec3(-2.0f, -2.0f, -2.0f);
 		ubo.pointLightPosition = glm::vec3(0.0569f, -1.078f, 0.4015f);
 		ubo.pointLightRadius = glm::float32(2.0f);
-		ubo.projectiveTextureMatrix = mProjector->ViewProjectionMatrix() * mProjectedTextureScalingMatrix * glm::mat4(1);
+		ubo.projectiveTextureMatrix = snapshot.projectorViewProjection * mProjectedTextureScalingMatrix * glm::mat4(1);
 		ubo.WorldLightViewProjection = uboOffscreenVS.WorldLightViewProjection;
-		ubo.lightPositionForShadow = lightPos;
+		ubo.lightPositionForShadow = snapshot.lightPosition;
 
 		ubo.proj[1][1] *= -1;
 
 		fbo.ambientColor = glm::vec4(0.53f, 0.80f, 0.91f, 1.00f);
 		fbo.lightColor = glm::vec4(0.94f, 0.35f, 0.11f, 1.00f);
 		fbo.pointLightColor = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
-		fbo.cameraPosition = mCamera->Position();
+		fbo.cameraPosition = snapshot.cameraPosition;
 		fbo.pointLightPosition = glm::vec3(0.0569f, -1.078f, 0.4015f);
 		fbo.specularColor = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
 		fbo.specularPower = glm::float32(10.0f);
 
-		glm::mat4 proxymodel = glm::mat4(1.0);
-		proxymodel = glm::translate(proxymodel, glm::vec3(0.8, 0.8, 0.8));
-		proxymodel = glm::scale(proxymodel, glm::vec3(0.2, 0.2, 0.2));
-		glm::mat4 proxyProjection = mCamera->ProjectionMatrix();
+		glm::mat4 proxyProjection = snapshot.cameraProjection;
 		proxyProjection[1][1] *= -1;
-		pmubo.mvp = proxyProjection * mCamera->ViewMatrix()* proxymodel;
-
-		void* data;
-		vkMapMemory(device, uniformBuffersMemory[currentImage], 0, sizeof(ubo), 0, &data);
-		memcpy(data, &ubo, sizeof(ubo));
-		vkUnmapMemory(device, uniformBuffersMemory[currentImage]);
+		pmubo.viewProjection = proxyProjection * snapshot.cameraView;
 
-		void* fragdata;
-		vkMapMemory(device, fragmentUniformBuffersMemory[currentImage], 0, sizeof(fbo), 0, &fragdata);
-		memcpy(fragdata, &fbo, sizeof(fbo));
-		vkUnmapMemory(device, fragmentUniformBuffersMemory[currentImage]);
+		frame.uniformOffsets.scene = uniformRingBuffer.Push(ubo);
+		frame.uniformOffsets.fragment = uniformRingBuffer.Push(fbo);
+		frame.uniformOffsets.proxyModel = uniformRingBuffer.Push(pmubo);
 
-		void* proxyModelsVSData;
-		vkMapMemory(device, proxyModelsUniformBuffersMemory[currentImage], 0, sizeof(pmubo), 0, &proxyModelsVSData);
-		memcpy(proxyModelsVSData, &pmubo, sizeof(pmubo));
-		vkUnmapMemory(device, proxyModelsUniformBuffersMemory[currentImage]);
+		frame.sceneFeatures = selectSceneFeatures(fbo);
 	}
 
 	void RendererC::drawFrame()
 	{
-		vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		// Edited shaders are swapped in before this frame's command buffers are recorded
+		reloadChangedShaders();
+
+		FrameContext& frame = frames[currentFrame];
+
+		// Wait until the GPU is done with this frame's command buffers & uniform buffers
+		vkWaitForFences(device, 1, &frame.inFlightFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		uploadManager.BeginFrame();
 
 		uint32_t imageIndex;
-		VkResult result = vkAcquireNextImageKHR(device, swapChain, std::numeric_limits<uint64_t>::max(), imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+		VkResult result = vkAcquireNextImageKHR(device, swapChain, std::numeric_limits<uint64_t>::max(), frame.imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR)
 		{
@@ -2059,28 +2430,79 @@ namespace AlphonsoGraphicsEngine
 		{
 			throw std::runtime_error("failed to acquire swap chain image!");
 		}
-		updateUniformBufferOffscreen();
-		updateUniformBuffer(imageIndex);
+		// Pipelines done compiling & newly streamed texture levels are swapped in before anything of this frame is recorded
+		updateGraphicsPipelines();
+		requestTextureResidency();
+		if (textureStreamer.Update(static_cast<uint32_t>(frames.size())))
+		{
+			replaceSceneDescriptorSet();
+		}
+		releaseRetiredResources(frameNumber);
+		if (mProjectedTextureWidth != textureStreamer.Width(projectedTexture))
+		{
+			mProjectedTextureWidth = textureStreamer.Width(projectedTexture);
+			mProjectedTextureHeight = textureStreamer.Height(projectedTexture);
+			InitializeProjectedTextureScalingMatrix(mProjectedTextureWidth, mProjectedTextureHeight);
+		}
+
+		// GPU is done with this frame, so its ring buffer region can be overwritten.
+		uniformRingBuffer.BeginFrame(static_cast<uint32_t>(currentFrame));
+		updateUniformBufferOffscreen(frame);
+		updateUniformBuffer(frame);
+		// Requested here, recording threads only look permutations up
+		frame.scenePipeline = scenePipelinePermutation(frame.sceneFeatures);
+
+		// Secondary command buffers are recorded in parallel on worker threads.
+		// Static passes are only re-recorded after the scene, pipelines or swapchain changed,
+		// when uniform slices moved away from the dynamic offsets baked into them or scene shader features changed.
+		// Object transforms are pushed as constants, so a scene which moved is recorded again too.
+		std::vector<std::future<void>> recordings;
+		bool recordStaticPasses = frame.staticCommandBuffersDirty || frame.uniformOffsets != frame.recordedUniformOffsets
+			|| frame.sceneFeatures != frame.recordedSceneFeatures || frame.recordedSceneVersion != mRenderSnapshot->sceneVersion;
+		if (recordStaticPasses)
+		{
+			recordings.push_back(mThreadPool.Enqueue([this, &frame] { recordShadowPassCommandBuffer(frame); }));
+			recordings.push_back(mThreadPool.Enqueue([this, &frame] { recordScenePassCommandBuffer(frame); }));
+		}
+		if (isImGuiWindowCreated)
+		{
+			recordings.push_back(mThreadPool.Enqueue([this, &frame] { recordUICommandBuffer(frame); }));
+		}
+		for (std::future<void>& recording : recordings)
+		{
+			recording.get();
+		}
+		if (recordStaticPasses)
+		{
+			frame.recordedUniformOffsets = frame.uniformOffsets;
+			frame.recordedSceneFeatures = frame.sceneFeatures;
+			frame.recordedSceneVersion = mRenderSnapshot->sceneVersion;
+			frame.staticCommandBuffersDirty = false;
+		}
+		recordCommandBuffer(frame, imageIndex);
+
+		// Submits streamed uploads within frame budget, ahead of frame so its acquire barriers come first
+		uploadManager.Flush();
 
 		VkSubmitInfo submitInfo = {};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-		VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
+		VkSemaphore waitSemaphores[] = { frame.imageAvailableSemaphore };
 		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 		submitInfo.waitSemaphoreCount = 1;
 		submitInfo.pWaitSemaphores = waitSemaphores;
 		submitInfo.pWaitDstStageMask = waitStages;
 
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
+		submitInfo.pCommandBuffers = &frame.commandBuffer;
 
-		VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
+		VkSemaphore signalSemaphores[] = { frame.renderFinishedSemaphore };
 		submitInfo.signalSemaphoreCount = 1;
 		submitInfo.pSignalSemaphores = signalSemaphores;
 
-		vkResetFences(device, 1, &inFlightFences[currentFrame]);
+		vkResetFences(device, 1, &frame.inFlightFence);
 
-		if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
+		if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, frame.inFlightFence) != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to submit draw command buffer!");
 		}
@@ -2109,22 +2531,53 @@ namespace AlphonsoGraphicsEngine
 			throw std::runtime_error("failed to present swap chain image!");
 		}
 
-		currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+		currentFrame = (currentFrame + 1) % frames.size();
+		++frameNumber;
+	}
+
+	std::vector<uint32_t> RendererC::compileShader(const std::string& name, ShaderCompiler::Stage stage)
+	{
+		ShaderCompiler::Request request;
+		request.name = name;
+		request.stage = stage;
+		if (USE_PACKED_VERTICES && stage == ShaderCompiler::Stage::Vertex)
+		{
+			request.defines.push_back({ "PACKED_VERTICES", "1" });
+		}
+
+		std::vector<uint32_t> spirv;
+		std::string log;
+		if (!shaderCompiler.Compile(request, spirv, log))
+		{
+			std::cerr << log << std::endl;
+			throw std::runtime_error("failed to compile shader!");
+		}
+		return spirv;
 	}
 
-	VkShaderModule RendererC::createShaderModule(const std::vector<char>& code)
+	void RendererC::reloadChangedShaders()
 	{
-		VkShaderModuleCreateInfo createInfo = {};
-		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = code.size();
-		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+		auto now = std::chrono::steady_clock::now();
+		if (now - lastShaderPoll < SHADER_POLL_INTERVAL)
+		{
+			return;
+		}
+		lastShaderPoll = now;
+
+		if (!shaderCompiler.PollChangedSources())
+		{
+			return;
+		}
 
-		VkShaderModule shaderModule;
-		if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+		// Old pipelines are drawn with while new ones compile on workers, a shader failing to compile leaves them in place
+		try
+		{
+			requestGraphicsPipelines();
+		}
+		catch (const std::exception& error)
 		{
-			throw std::runtime_error("failed to create shader module!");
+			std::cerr << error.what() << std::endl;
 		}
-		return shaderModule;
 	}
 
 	VkSurfaceFormatKHR RendererC::chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats)
@@ -2284,6 +2737,27 @@ namespace AlphonsoGraphicsEngine
 			i++;
 		}
 
+		// Prefer a transfer-only family (DMA engine), then any transfer family without graphics
+		for (uint32_t family = 0; family < queueFamilyCount; family++)
+		{
+			const VkQueueFamilyProperties& queueFamily = queueFamilies[family];
+			if (queueFamily.queueCount == 0 || !(queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) || (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT))
+			{
+				continue;
+			}
+
+			if (!(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT))
+			{
+				queueIndices.transferFamily = family;
+				break;
+			}
+
+			if (!queueIndices.transferFamily.has_value())
+			{
+				queueIndices.transferFamily = family;
+			}
+		}
+
 		return queueIndices;
 	}
 
@@ -2356,16 +2830,6 @@ namespace AlphonsoGraphicsEngine
 		mProjectedTextureScalingMatrix[3][3] = 1.0f;
 	}
 
-	void RendererC::createShadowMap()
-	{
-		VkFormat depthFormat = findDepthFormat();
-
-		// We will sample directly from the depth attachment for the shadow mapping
-		createImage(swapChainExtent.width, swapChainExtent.height, MSAA_Samples, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, shadowMapImage, shadowMapImageMemory);
-		shadowMapImageView = createImageView(shadowMapImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
-		transitionImageLayout(shadowMapImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
-	}
-
 	void RendererC::createShadowMapSampler()
 	{
 		// Create sampler to sample from to depth attachment 
@@ -2389,85 +2853,7 @@ namespace AlphonsoGraphicsEngine
 		}
 	}
 
-	void RendererC::createShadowMapRenderPass()
-	{
-		VkFormat depthFormat = findDepthFormat();
-
-		VkAttachmentDescription attachmentDescription{};
-		attachmentDescription.format = depthFormat;
-		attachmentDescription.samples = MSAA_Samples;
-		attachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;							
-		attachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;						
-		attachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		attachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		attachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;					
-		attachmentDescription.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
-
-		VkAttachmentReference depthReference = {};
-		depthReference.attachment = 0;
-		depthReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;			
-
-		VkSubpassDescription subpass = {};
-		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-		subpass.colorAttachmentCount = 0;													
-		subpass.pDepthStencilAttachment = &depthReference;									
-
-		// Use subpass dependencies for layout transitions
-		std::array<VkSubpassDependency, 2> dependencies;
-
-		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-		dependencies[0].dstSubpass = 0;
-		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		dependencies[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-		dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-		dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-		dependencies[1].srcSubpass = 0;
-		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-		dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-		dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-		VkRenderPassCreateInfo renderPassCreateInfo = {};
-		renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-		renderPassCreateInfo.attachmentCount = 1;
-		renderPassCreateInfo.pAttachments = &attachmentDescription;
-		renderPassCreateInfo.subpassCount = 1;
-		renderPassCreateInfo.pSubpasses = &subpass;
-		renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
-		renderPassCreateInfo.pDependencies = dependencies.data();
-
-		if (vkCreateRenderPass(device, &renderPassCreateInfo, nullptr, &shadowMapRenderPass) != VK_SUCCESS)
-		{
-			throw std::runtime_error("failed to create render pass!");
-		}
-	}
-
-	void RendererC::createShadowMapFrameBuffer()
-	{
-		std::array<VkImageView, 1> attachments = {
-			shadowMapImageView,
-		};
-
-		VkFramebufferCreateInfo framebufferInfo = {};
-		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		framebufferInfo.renderPass = shadowMapRenderPass;
-		framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-		framebufferInfo.pAttachments = attachments.data();
-		framebufferInfo.width = swapChainExtent.width;
-		framebufferInfo.height = swapChainExtent.height;
-		framebufferInfo.layers = 1;
-
-		if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &shadowMapFrameBuffer) != VK_SUCCESS)
-		{
-			throw std::runtime_error("failed to create framebuffer!");
-		}
-	}
-
-	void RendererC::updateUniformBufferOffscreen()
+	void RendererC::updateUniformBufferOffscreen(FrameContext& frame)
 	{
 		uboOffscreenVS = {};
 
@@ -2476,14 +2862,11 @@ namespace AlphonsoGraphicsEngine
 		// Matrix from light's point of view
 		glm::mat4 depthProjectionMatrix = glm::perspective(glm::radians(lightFOV), aspectRatio/* 1.0f*/, zNear, zFar);
 		depthProjectionMatrix[1][1] *= -1;
-		glm::mat4 depthViewMatrix = glm::lookAt(lightPos, glm::vec3(1,1,1), glm::vec3(-1,0,1));
+		glm::mat4 depthViewMatrix = glm::lookAt(mRenderSnapshot->lightPosition, glm::vec3(1,1,1), glm::vec3(-1,0,1));
 		glm::mat4 depthModelMatrix = glm::mat4(1.0f);
 
 		uboOffscreenVS.WorldLightViewProjection = depthProjectionMatrix * depthViewMatrix * depthModelMatrix;
 
-		void* data;
-		vkMapMemory(device, offscreenUniformBuffersMemory[0], 0, sizeof(uboOffscreenVS), 0, &data);
-		memcpy(data, &uboOffscreenVS, sizeof(uboOffscreenVS));
-		vkUnmapMemory(device, offscreenUniformBuffersMemory[0]);
+		frame.uniformOffsets.offscreen = uniformRingBuffer.Push(uboOffscreenVS);
 	}
 }
\ No newline at end of file
@@ -9,8 +9,26 @@
 #include <set>
 #include <array>
 #include <optional>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
 #include "GameClock.h"
 #include "GameTime.h"
+#include "UniformRingBuffer.h"
+#include "ThreadPool.h"
+#include "RenderGraph.h"
+#include "UploadManager.h"
+#include "GeometryPool.h"
+#include "TextureStreamer.h"
+#include "AssetFileSystem.h"
+#include "ShaderCompiler.h"
+#include "PipelineCache.h"
+#include "PipelineCompiler.h"
+#include "DeviceMemoryAllocator.h"
+#include "InputState.h"
+#include "SimulationThread.h"
+#include "SnapshotBuffer.h"
+#include "Scene.h"
 
 namespace AlphonsoGraphicsEngine
 {
@@ -52,7 +70,8 @@ namespace AlphonsoGraphicsEngine
 		/// <summary>Initializes Window, Vulkan Instance & Timer for Renderer ( Virtual ).</summary>
 		virtual void Initialize();
 
-		/// <summary>This method performs Non-Rendering related operation like Mouse/Keyboard movement. ( Virtual ).</summary>
+		/// <summary>This method performs Non-Rendering related operation like Mouse/Keyboard movement. ( Virtual ).
+		/// Runs on simulation thread at a fixed rate & ends by publishing a new render snapshot.</summary>
 		/// <param name="gameTime">Const reference to passed GameTime.</param>
 		virtual void Update(const GameTime& gameTime);
 
@@ -60,6 +79,17 @@ namespace AlphonsoGraphicsEngine
 		GLFWwindow* Window();
 		void recreateImGuiWindow();
 
+		/// <summary>Marks pre-recorded static passes as stale so they are re-recorded before their next use.</summary>
+		void invalidateStaticCommandBuffers();
+
+		/// <summary>Sets how many frames CPU may record ahead of GPU. Trades latency against throughput.</summary>
+		/// <param name="frameCount">Requested frame count, clamped between 1 & MAX_FRAMES_IN_FLIGHT.</param>
+		void SetFramesInFlight(uint32_t frameCount);
+
+		/// <summary>Gets number of frames which may be in flight at once.</summary>
+		/// <returns>Current frames in flight count.</returns>
+		uint32_t FramesInFlight() const;
+
 		RendererC* mRendererInstance;
 
 		struct Vertex
@@ -112,10 +142,54 @@ namespace AlphonsoGraphicsEngine
 			}
 		};
 
+		// Compact vertex, 16 bytes instead of 44. Position is quantised within mesh bounds, see MeshConstants.
+		struct PackedVertex
+		{
+			uint16_t pos[4];
+			uint16_t texCoord[2];
+			int16_t normal[2];
+
+			static VkVertexInputBindingDescription getBindingDescription()
+			{
+				VkVertexInputBindingDescription bindingDescription = {};
+				bindingDescription.binding = 0;
+				bindingDescription.stride = sizeof(PackedVertex);
+				bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+				return bindingDescription;
+			}
+
+			static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions()
+			{
+				std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions = {};
+
+				attributeDescriptions[0].binding = 0;
+				attributeDescriptions[0].location = 0;
+				attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+				attributeDescriptions[0].offset = offsetof(PackedVertex, pos);
+
+				attributeDescriptions[1].binding = 0;
+				attributeDescriptions[1].location = 2;
+				attributeDescriptions[1].format = VK_FORMAT_R16G16_SFLOAT;
+				attributeDescriptions[1].offset = offsetof(PackedVertex, texCoord);
+
+				attributeDescriptions[2].binding = 0;
+				attributeDescriptions[2].location = 3;
+				attributeDescriptions[2].format = VK_FORMAT_R16G16_SNORM;
+				attributeDescriptions[2].offset = offsetof(PackedVertex, normal);
+
+				return attributeDescriptions;
+			}
+		};
+
 		bool framebufferResized = false;
 		bool isImGuiWindowCreated = false;
 
 	protected:
+		struct FrameContext;
+		struct FragmentUniformBufferObject;
+
+		void InitializeAssets();
 		void InitializeWindow();
 		void InitializeImgui(float WIDTH, float HEIGHT);
 		void InitializeVulkan();
@@ -123,7 +197,7 @@ namespace AlphonsoGraphicsEngine
 
 		void InitializeCamera();
 		void InitializeProjector();
-		void InitializeProxyModelsTransform();
+		void InitializeScene();
 
 		void mainLoop();
 		void cleanupSwapChain();
@@ -135,43 +209,66 @@ namespace AlphonsoGraphicsEngine
 		void createSurface();
 		void pickPhysicalDevice();
 		void createLogicalDevice();
-		void createSwapChain();
+		void createSwapChain(VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE);
 		void createImageViews();
-		void createRenderPass();
+		void createRenderGraph();
+		void resizeRenderGraph();
 		void createDescriptorSetLayout();
+		void createPipelineCache();
 		void createGraphicsPipeline();
-		void createFramebuffers();
+		void createPipelineLayouts();
+		PipelineCompiler::Description describeScenePipeline();
+		void requestGraphicsPipelines();
+		void updateGraphicsPipelines();
+		PipelineCompiler::ShaderStage sceneFragmentStage(uint32_t features) const;
+		PipelineCompiler::PipelineHandle scenePipelinePermutation(uint32_t features);
+		uint32_t selectSceneFeatures(const FragmentUniformBufferObject& fbo) const;
 		void createCommandPool();
-		void createMSAAColorResources();
-		void createDepthResources();
+		void createUploadManager();
 		VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 		VkFormat findDepthFormat();
 		bool hasStencilComponent(VkFormat format);
-		void createTextureImage();
-		void createTextureImageView();
+		void createTextureStreamer();
 		void createTextureSampler();
-		VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
-		void createImage(uint32_t width, uint32_t height, VkSampleCountFlagBits sampleCount, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
-		void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
-		void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+		TextureStreamer::SourceLevels loadTextureLevels(const std::string& texturePath, VkFormat compressedFormat);
+		bool isBlockCompressionSupported(VkFormat format);
+		void requestTextureResidency();
+		uint32_t textureLevelForScreenSize(TextureStreamer::TextureHandle texture, float screenSize);
+		void replaceSceneDescriptorSet();
+		void releaseRetiredResources(uint64_t frame);
+		void waitForFramesInFlight();
+		VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels = 1);
+		void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits sampleCount, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, DeviceMemoryAllocator::Allocation& imageAllocation);
 		void loadModel(const std::string& modelPath, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
-		void createVertexBuffers();
-		void createVertexBuffer(std::vector<Vertex>& vertices, VkBuffer& vertexBuffer, VkDeviceMemory& vertexBufferMemory);
-		void createIndexBuffers();
-		void createIndexBuffer(std::vector<uint32_t>& indices, VkBuffer& indexBuffer, VkDeviceMemory& indexBufferMemory);
+		void createGeometryPool();
+		struct LoadedMesh;
+		LoadedMesh loadMesh(const std::string& modelPath);
+		void optimizeMesh(const std::string& modelPath, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+		std::vector<PackedVertex> packVertices(const std::vector<Vertex>& vertices, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+		void drawMesh(VkCommandBuffer commandBuffer, VkPipelineLayout layout, const LoadedMesh& mesh, const glm::mat4& model, VkIndexType& boundIndexType);
+		void createFrameContexts();
+		void destroyFrameContexts();
 		void createUniformBuffers();
 		void createDescriptorPool();
 		void createDescriptorSets();
-		void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+		void writeSceneDescriptorSet(VkDescriptorSet set);
+		void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, DeviceMemoryAllocator::Allocation& bufferAllocation);
 		VkCommandBuffer beginSingleTimeCommands();
 		void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-		void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
-		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 		void createCommandBuffers();
+		void createFrameCommandBuffer(VkCommandBufferLevel level, VkCommandPool& pool, VkCommandBuffer& commandBuffer);
+		void setViewportAndScissor(VkCommandBuffer commandBuffer, VkExtent2D extent);
+		void recordShadowPassCommandBuffer(FrameContext& frame);
+		void recordScenePassCommandBuffer(FrameContext& frame);
+		void recordUICommandBuffer(FrameContext& frame);
+		void recordCommandBuffer(FrameContext& frame, uint32_t imageIndex);
 		void createSyncObjects();
-		void updateUniformBuffer(uint32_t currentImage);
+		void updateUniformBuffer(FrameContext& frame);
 		void drawFrame();
-		VkShaderModule createShaderModule(const std::vector<char>& code);
+		AssetFileSystem::File readAsset(const std::string& name) const;
+		std::vector<uint32_t> compileShader(const std::string& name, ShaderCompiler::Stage stage);
+		void reloadChangedShaders();
+		void destroyGraphicsPipelines();
 		VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 		VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
 		VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
@@ -182,27 +279,104 @@ namespace AlphonsoGraphicsEngine
 		void ImGuiSetupWindow();
 		VkSampleCountFlagBits getMaximumPossibleSampleCount();
 
-		void createShadowMap();
 		void createShadowMapSampler();
-		void createShadowMapRenderPass();
-		void createShadowMapFrameBuffer();
-		void updateUniformBufferOffscreen();
+		void updateUniformBufferOffscreen(FrameContext& frame);
+		void publishRenderSnapshot();
 
+		// Camera, projector & scene are only touched by simulation thread while it runs
 		std::shared_ptr<AlphonsoGraphicsEngine::FirstPersonCamera> mCamera;
 		std::shared_ptr<AlphonsoGraphicsEngine::Projector> mProjector;
+		Scene mScene;
+
+		// Workers recording secondary command buffers ( & other parallel engine jobs )
+		ThreadPool mThreadPool;
 
 		GameClock mGameClock;
 		GameTime mGameTime;
 
+		SimulationThread mSimulationThread;
+
 		const int WIDTH = 1024;
 		const int HEIGHT = 768;
 
-		const std::string MODEL_PATH = "../../Assets/Models/ChaletN.objs";
-		const std::string TEXTURE_PATH = "../../Assets/Textures/chalet.png";
-		const std::string PROJECTED_TEXTURE_PATH = "../../Assets/Textures/ProjectedTexture.png";
-		const std::string CUBE_MODEL_PATH = "../../Assets/Models/cube.objs";
-
-		const int MAX_FRAMES_IN_FLIGHT = 2;
+		// Asset names, relative to Assets directory & looked up in asset pack first
+		const std::string MODEL_PATH = "Models/ChaletN.objs";
+		const std::string TEXTURE_PATH = "Textures/chalet.png";
+		const std::string PROJECTED_TEXTURE_PATH = "Textures/ProjectedTexture.png";
+		const std::string CUBE_MODEL_PATH = "Models/cube.objs";
+		const std::string FONT_PATH = "Fonts/Roboto-Medium.ttf";
+		// GLSL sources compiled at runtime, vertex shaders get PACKED_VERTICES defined when meshes are packed
+		const std::string SCENE_VERTEX_SHADER = "Shaders/shader.vert";
+		const std::string SCENE_FRAGMENT_SHADER = "Shaders/shader.frag";
+		const std::string PROXY_MODEL_VERTEX_SHADER = "Shaders/proxyModel.vert";
+		const std::string PROXY_MODEL_FRAGMENT_SHADER = "Shaders/proxyModel.frag";
+		const std::string SHADOW_MAP_VERTEX_SHADER = "Shaders/depthMap.vert";
+		// Feature toggles of scene fragment shader, specialised into one pipeline permutation per combination
+		enum SceneFeature : uint32_t
+		{
+			SCENE_FEATURE_PROJECTOR = 1 << 0,
+			SCENE_FEATURE_SHADOW = 1 << 1,
+			SCENE_FEATURE_POINT_LIGHT = 1 << 2,
+			SCENE_FEATURE_SPECULAR = 1 << 3,
+			// Filters 3x3 shadow map texels instead of comparing one
+			SCENE_FEATURE_SHADOW_PCF = 1 << 4,
+			SCENE_FEATURES_ALL = (1 << 5) - 1
+		};
+		// Meshes render components refer to, index into meshes
+		enum SceneMesh : uint32_t
+		{
+			SCENE_MESH_CHALET,
+			SCENE_MESH_CUBE,
+			SCENE_MESH_COUNT
+		};
+		// Pipeline render components are drawn with in scene pass
+		enum SceneMaterial : uint32_t
+		{
+			SCENE_MATERIAL_LIT,
+			SCENE_MATERIAL_PROXY,
+			// Only drawn into shadow map
+			SCENE_MATERIAL_NONE
+		};
+		// Entities scene reserves storage for, more only reallocate
+		const uint32_t SCENE_ENTITY_CAPACITY = 16 * 1024;
+		// Pipeline cache file, saved on shutdown next to asset pack
+		const std::string PIPELINE_CACHE_FILE = "PipelineCache.bin";
+		// How often shader sources are checked for edits
+		const std::chrono::milliseconds SHADER_POLL_INTERVAL = std::chrono::milliseconds(500);
+		// Workers creating graphics pipelines, 0 picks one less than hardware thread count
+		const uint32_t PIPELINE_COMPILE_THREADS = 0;
+		// Block compressed formats textures are cooked into when device can sample them, RGBA8 otherwise
+		const VkFormat MODEL_TEXTURE_FORMAT = VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+		const VkFormat PROJECTED_TEXTURE_FORMAT = VK_FORMAT_BC7_UNORM_BLOCK;
+
+		const uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+		// Uniform ring buffer bytes available to each frame in flight
+		const VkDeviceSize UNIFORM_RING_FRAME_SIZE = 64 * 1024;
+		// Persistently mapped staging ring shared by all uploads
+		const VkDeviceSize STAGING_HEAP_SIZE = 64 * 1024 * 1024;
+		// Upload bytes submitted per frame once loading is done
+		const VkDeviceSize UPLOAD_BUDGET_PER_FRAME = 16 * 1024 * 1024;
+		// Shared vertex & index pools every mesh is sub-allocated from
+		const uint32_t GEOMETRY_POOL_VERTEX_CAPACITY = 1024 * 1024;
+		const uint32_t GEOMETRY_POOL_INDEX_CAPACITY = 4 * 1024 * 1024;
+		// Triangle corners per parallel vertex building task when importing a model
+		const size_t MODEL_CORNERS_PER_RANGE = 64 * 1024;
+		// Bytes resident streamed textures may occupy before least recently requested ones lose their finest levels
+		const VkDeviceSize TEXTURE_STREAMING_BUDGET = 256 * 1024 * 1024;
+		// Largest mip made resident by a texture's first upload, sampled until finer levels stream in
+		const uint32_t TEXTURE_STREAMING_TAIL_EXTENT = 64;
+		// Workers decoding, cooking & uploading streamed textures
+		const uint32_t TEXTURE_LOAD_THREADS = 2;
+		// Workers mip filtering & block compression of streamed textures are spread over, 0 picks one less than hardware thread count
+		const uint32_t TEXTURE_COOK_THREADS = 0;
+		// Cell size positions are snapped to when welding imported vertices, 0 welds only identical vertices
+		const float MODEL_WELD_EPSILON = 0.0f;
+		// Post-transform vertex cache size imported meshes are optimised for
+		const uint32_t VERTEX_CACHE_SIZE = 16;
+		// Reorder clusters of imported meshes so outer surfaces are drawn first
+		const bool OPTIMIZE_MESH_OVERDRAW = true;
+		// Store meshes as PackedVertex, vertex shaders are then compiled with PACKED_VERTICES defined
+		const bool USE_PACKED_VERTICES = false;
 
 		const std::vector<const char*> validationLayers = {
 			"VK_LAYER_KHRONOS_validation"
@@ -223,6 +397,8 @@ namespace AlphonsoGraphicsEngine
 		{
 			std::optional<uint32_t> graphicsFamily;
 			std::optional<uint32_t> presentFamily;
+			// Family without graphics support used for uploads, if device exposes one
+			std::optional<uint32_t> transferFamily;
 
 			bool isComplete()
 			{
@@ -239,7 +415,6 @@ namespace AlphonsoGraphicsEngine
 
 		struct UniformBufferObject
 		{
-			alignas(16) glm::mat4 model;
 			alignas(16) glm::mat4 view;
 			alignas(16) glm::mat4 proj;
 			alignas(16) glm::vec3 lightDirection;
@@ -268,7 +443,114 @@ namespace AlphonsoGraphicsEngine
 
 		struct ProxyModelUniformBufferObject
 		{
-			alignas(16) glm::mat4 mvp;
+			alignas(16) glm::mat4 viewProjection;
+		};
+
+		// Vertex stage push constants turning quantised positions back into model space, identity for float vertices
+		struct MeshConstants
+		{
+			alignas(16) glm::vec4 positionScale;
+			alignas(16) glm::vec4 positionOffset;
+		};
+
+		// Push constants of a single draw, object's world matrix ahead of its mesh's constants
+		struct DrawConstants
+		{
+			alignas(16) glm::mat4 model;
+			MeshConstants mesh;
+		};
+
+		struct LoadedMesh
+		{
+			GeometryPool::MeshHandle geometry;
+			MeshConstants constants;
+			// Model space bounding sphere, used to estimate projected screen size
+			glm::vec3 boundsCenter = glm::vec3(0.0f);
+			float boundsRadius = 0.0f;
+		};
+
+		// Dynamic offsets of uniform slices inside uniformRingBuffer
+		struct UniformOffsets
+		{
+			uint32_t scene = 0;
+			uint32_t fragment = 0;
+			uint32_t proxyModel = 0;
+			uint32_t offscreen = 0;
+
+			bool operator==(const UniformOffsets& other) const
+			{
+				return scene == other.scene && fragment == other.fragment && proxyModel == other.proxyModel && offscreen == other.offscreen;
+			}
+
+			bool operator!=(const UniformOffsets& other) const
+			{
+				return !(*this == other);
+			}
+		};
+
+		// Immutable state simulation hands to rendering once per step
+		struct RenderSnapshot
+		{
+			glm::mat4 cameraView;
+			glm::mat4 cameraProjection;
+			glm::vec3 cameraPosition;
+			glm::vec3 cameraDirection;
+
+			glm::mat4 projectorViewProjection;
+			glm::vec3 projectorPosition;
+			glm::vec3 projectorDirection;
+
+			glm::vec3 lightPosition;
+
+			// Every render component of scene with world matrix of its entity
+			struct RenderItem
+			{
+				glm::mat4 model;
+				Scene::RenderComponent component;
+			};
+			std::vector<RenderItem> renderItems;
+			// Scene version render items were copied at, unchanged items aren't copied again
+			uint64_t sceneVersion = 0;
+		};
+
+		// Input & UI edits main thread hands to simulation, applied on its next step
+		struct SimulationCommands
+		{
+			InputState input;
+			std::optional<glm::vec3> projectorPosition;
+			std::optional<glm::vec3> projectorDirection;
+			std::optional<float> cameraAspectRatio;
+		};
+
+		// Everything a single frame in flight records into, writes to & waits on.
+		// Indexed by currentFrame, so CPU never touches resources GPU is still reading.
+		struct FrameContext
+		{
+			VkCommandPool commandPool = VK_NULL_HANDLE;
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			// Secondary command buffers for passes which only change with scene, pipelines or swapchain
+			VkCommandPool shadowPassCommandPool = VK_NULL_HANDLE;
+			VkCommandBuffer shadowPassCommandBuffer = VK_NULL_HANDLE;
+			VkCommandPool scenePassCommandPool = VK_NULL_HANDLE;
+			VkCommandBuffer scenePassCommandBuffer = VK_NULL_HANDLE;
+			bool staticCommandBuffersDirty = true;
+			// Secondary command buffer for Dear ImGui, re-recorded every frame
+			VkCommandPool uiCommandPool = VK_NULL_HANDLE;
+			VkCommandBuffer uiCommandBuffer = VK_NULL_HANDLE;
+
+			// Uniform slices written this frame & the ones baked into static command buffers
+			UniformOffsets uniformOffsets;
+			UniformOffsets recordedUniformOffsets;
+			// Scene shader features this frame draws with & the ones baked into static command buffers
+			uint32_t sceneFeatures = 0;
+			uint32_t recordedSceneFeatures = 0;
+			PipelineCompiler::PipelineHandle scenePipeline = PipelineCompiler::NoPipeline;
+			// Scene version whose transforms are baked into static command buffers
+			uint64_t recordedSceneVersion = 0;
+
+			VkSemaphore imageAvailableSemaphore = VK_NULL_HANDLE;
+			VkSemaphore renderFinishedSemaphore = VK_NULL_HANDLE;
+			VkFence inFlightFence = VK_NULL_HANDLE;
 		};
 
 	private:
@@ -288,96 +570,117 @@ namespace AlphonsoGraphicsEngine
 
 		VkQueue graphicsQueue;
 		VkQueue presentQueue;
+		VkQueue transferQueue = VK_NULL_HANDLE;
 
 		VkSwapchainKHR swapChain;
 		std::vector<VkImage> swapChainImages;
 		VkFormat swapChainImageFormat;
 		VkExtent2D swapChainExtent;
 		std::vector<VkImageView> swapChainImageViews;
-		std::vector<VkFramebuffer> swapChainFramebuffers;
 
+		// Swapchains replaced on resize, destroyed with their views once no frame in flight can be using them
+		struct RetiredSwapChain
+		{
+			VkSwapchainKHR swapChain = VK_NULL_HANDLE;
+			std::vector<VkImageView> imageViews;
+			uint64_t releaseFrame = 0;
+		};
+		std::vector<RetiredSwapChain> retiredSwapChains;
+
+		// Owns shadow & scene passes, their framebuffers and all attachments except swapchain images
+		RenderGraph renderGraph;
+		RenderGraph::PassHandle shadowMapPass;
+		RenderGraph::PassHandle scenePass;
+		RenderGraph::ResourceHandle shadowMapResource;
+		// Attachments rebuilt when swapchain is resized
+		RenderGraph::ResourceHandle backBufferResource;
+		RenderGraph::ResourceHandle msaaColorResource;
+		RenderGraph::ResourceHandle depthResource;
+
+		// Render passes owned by renderGraph
 		VkRenderPass renderPass;
 		VkRenderPass uiRenderPass;
 		VkDescriptorSetLayout descriptorSetLayout;
 		VkPipelineLayout pipelineLayout;
-		VkPipeline graphicsPipeline;
+		PipelineCompiler::PipelineHandle graphicsPipeline = PipelineCompiler::NoPipeline;
 
-		VkPipeline proxyModelsPipeline;
+		PipelineCompiler::PipelineHandle proxyModelsPipeline = PipelineCompiler::NoPipeline;
 		VkPipelineLayout proxyModelsPipelineLayout;
 		VkDescriptorSetLayout proxyModelsPipelineDescriptorSetLayout;
 		VkDescriptorSet proxyModelsPipelineDescriptorSet;
 
 		VkCommandPool commandPool;
 
-		VkImage msaaColorImage;
-		VkDeviceMemory msaaColorImageMemory;
-		VkImageView msaaColorImageView;
-
-		VkImage depthImage;
-		VkDeviceMemory depthImageMemory;
-		VkImageView depthImageView;
-
-
-		VkPipeline shadowMapPipeline;
+		PipelineCompiler::PipelineHandle shadowMapPipeline = PipelineCompiler::NoPipeline;
 		VkPipelineLayout shadowMapPipelineLayout;
 		VkDescriptorSetLayout shadowMapPipelineDescriptorSetLayout;
-		VkDescriptorSet shadowMapPipelineDescriptorSet;
 		VkRenderPass shadowMapRenderPass;
-		VkImage shadowMapImage;
-		VkDeviceMemory shadowMapImageMemory;
-		VkImageView shadowMapImageView;
-		VkFramebuffer shadowMapFrameBuffer;
 
 		VkSampler shadowMapSampler;
 
-		VkImage textureImage;
-		VkDeviceMemory textureImageMemory;
-		VkImageView textureImageView;
+		// Read by load workers too, so it outlives texture streamer
+		AssetFileSystem assets;
+		// Font atlas reads font from here until ImGui is shut down
+		AssetFileSystem::File fontFile;
+		ShaderCompiler shaderCompiler;
+		PipelineCache pipelineCache;
+		// Owns every graphics pipeline, handles above resolve to their fallbacks while they compile
+		PipelineCompiler pipelineCompiler;
+		// Pipelines still drawn with until all of their replacements are compiled
+		std::vector<PipelineCompiler::PipelineHandle> replacedPipelines;
+		// Scene pipeline permutations by feature mask, graphicsPipeline is the one with every feature & fallback of all others
+		std::unordered_map<uint32_t, PipelineCompiler::PipelineHandle> scenePipelinePermutations;
+		// SPIR-V current scene pipelines were built from, so permutations never pick up an edit that failed to reload
+		std::vector<uint32_t> sceneVertexSpirv;
+		std::vector<uint32_t> sceneFragmentSpirv;
+		// Features enabled from UI, draws drop those which contribute nothing. Filtered shadows are opt-in, default frame keeps single tap compare
+		uint32_t sceneFeatureToggles = SCENE_FEATURES_ALL & ~SCENE_FEATURE_SHADOW_PCF;
+		std::chrono::steady_clock::time_point lastShaderPoll;
+
+		// Never the engine pool, a cook queued ahead of a frame's recording jobs would stall that frame
+		std::unique_ptr<ThreadPool> textureCookPool;
+		TextureStreamer textureStreamer;
+		TextureStreamer::TextureHandle modelTexture = 0;
 		VkSampler textureSampler;
-
-		VkImage projectedTextureImage;
-		VkDeviceMemory projectedTextureImageMemory;
-		VkImageView projectedTextureImageView;
+		TextureStreamer::TextureHandle projectedTexture = 0;
 		VkSampler projectedTextureSampler;
 
-		std::vector<Vertex> vertices;
-		std::vector<uint32_t> indices;
-
-		std::vector<Vertex> cubeVertices;
-		std::vector<uint32_t> cubeIndices;
+		DeviceMemoryAllocator memoryAllocator;
+		UniformRingBuffer uniformRingBuffer;
+		UploadManager uploadManager;
 
-		VkBuffer vertexBuffer;
-		VkDeviceMemory vertexBufferMemory;
-		VkBuffer indexBuffer;
-		VkDeviceMemory indexBufferMemory;
-
-		VkBuffer cubeVertexBuffer;
-		VkDeviceMemory cubeVertexBufferMemory;
-		VkBuffer cubeIndexBuffer;
-		VkDeviceMemory cubeIndexBufferMemory;
-		std::vector<VkBuffer> proxyModelsUniformBuffers;
-		std::vector<VkDeviceMemory> proxyModelsUniformBuffersMemory;
+		GeometryPool geometryPool;
+		// Indexed by SceneMesh
+		std::vector<LoadedMesh> meshes;
 
+		VkDescriptorPool descriptorPool;
+		VkDescriptorSet descriptorSet;
+		VkDescriptorSet proxyModelDescriptorSet;
+		VkDescriptorSet shadowMapDescriptorSet;
 
-		std::vector<VkBuffer> uniformBuffers;
-		std::vector<VkDeviceMemory> uniformBuffersMemory;
-		std::vector<VkBuffer> fragmentUniformBuffers;
-		std::vector<VkDeviceMemory> fragmentUniformBuffersMemory;
-		std::vector<VkBuffer> offscreenUniformBuffers;
-		std::vector<VkDeviceMemory> offscreenUniformBuffersMemory;
+		// Scene sets replaced after streamed textures or shadow map changed, freed once no frame in flight can be using them
+		struct RetiredDescriptorSet
+		{
+			VkDescriptorSet set = VK_NULL_HANDLE;
+			uint64_t releaseFrame = 0;
+		};
+		std::vector<RetiredDescriptorSet> retiredDescriptorSets;
+		uint64_t frameNumber = 0;
 
-		VkDescriptorPool descriptorPool;
-		std::vector<VkDescriptorSet> descriptorSets;
-		std::vector<VkDescriptorSet> proxyModelDescriptorSets;
+		SnapshotBuffer<RenderSnapshot> mRenderSnapshots;
+		// Latest snapshot acquired by main thread at start of frame
+		const RenderSnapshot* mRenderSnapshot = nullptr;
 
-		std::vector<VkCommandBuffer> commandBuffers;
+		std::mutex mSimulationCommandsMutex;
+		SimulationCommands mSimulationCommands;
 
-		std::vector<VkSemaphore> imageAvailableSemaphores;
-		std::vector<VkSemaphore> renderFinishedSemaphores;
-		std::vector<VkFence> inFlightFences;
+		std::vector<FrameContext> frames;
+		uint32_t framesInFlight = 2;
 		size_t currentFrame = 0;
 
 		VkSampleCountFlagBits MSAA_Samples = VK_SAMPLE_COUNT_1_BIT;
+		// Device can sample BCn formats, so textures are uploaded block compressed
+		bool textureCompressionBC = false;
 
 		glm::mat4 mProjectedTextureScalingMatrix;
 		uint32_t mProjectedTextureWidth = 0;
@@ -0,0 +1,373 @@
+#include "Scene.h"
+#include <stdexcept>
+#include <algorithm>
+
+namespace AlphonsoGraphicsEngine
+{
+	const Scene::Entity Scene::NoEntity = UINT32_MAX;
+	const uint32_t Scene::NoRenderable = UINT32_MAX;
+	const uint32_t Scene::UpdateBatchSize = 1024;
+
+	void Scene::Initialize(uint32_t capacity)
+	{
+		mLocalPositions.reserve(capacity);
+		mLocalRotations.reserve(capacity);
+		mLocalScales.reserve(capacity);
+		mWorldMatrices.reserve(capacity);
+		mParents.reserve(capacity);
+		mFirstChildren.reserve(capacity);
+		mNextSiblings.reserve(capacity);
+		mPreviousSiblings.reserve(capacity);
+		mDirty.reserve(capacity);
+		mAlive.reserve(capacity);
+		mRenderIndices.reserve(capacity);
+		mRenderEntities.reserve(capacity);
+		mRenderComponents.reserve(capacity);
+		mUpdateOrder.reserve(capacity);
+	}
+
+	void Scene::Shutdown()
+	{
+		mLocalPositions.clear();
+		mLocalRotations.clear();
+		mLocalScales.clear();
+		mWorldMatrices.clear();
+		mParents.clear();
+		mFirstChildren.clear();
+		mNextSiblings.clear();
+		mPreviousSiblings.clear();
+		mDirty.clear();
+		mAlive.clear();
+		mDirtyEntities.clear();
+		mFreeEntities.clear();
+		mEntityCount = 0;
+		mRenderIndices.clear();
+		mRenderEntities.clear();
+		mRenderComponents.clear();
+		mUpdateOrder.clear();
+		mLevelStarts.clear();
+		++mVersion;
+	}
+
+	Scene::Entity Scene::CreateEntity(Entity parent)
+	{
+		Entity entity;
+		if (mFreeEntities.empty())
+		{
+			entity = static_cast<Entity>(mAlive.size());
+			mLocalPositions.emplace_back();
+			mLocalRotations.emplace_back();
+			mLocalScales.emplace_back();
+			mWorldMatrices.emplace_back();
+			mParents.emplace_back();
+			mFirstChildren.emplace_back();
+			mNextSiblings.emplace_back();
+			mPreviousSiblings.emplace_back();
+			mDirty.emplace_back();
+			mAlive.emplace_back();
+			mRenderIndices.emplace_back();
+		}
+		else
+		{
+			entity = mFreeEntities.back();
+			mFreeEntities.pop_back();
+		}
+
+		mLocalPositions[entity] = glm::vec3(0.0f);
+		mLocalRotations[entity] = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		mLocalScales[entity] = glm::vec3(1.0f);
+		mWorldMatrices[entity] = glm::mat4(1.0f);
+		mParents[entity] = NoEntity;
+		mFirstChildren[entity] = NoEntity;
+		mNextSiblings[entity] = NoEntity;
+		mPreviousSiblings[entity] = NoEntity;
+		mDirty[entity] = DIRTY_NONE;
+		mAlive[entity] = true;
+		mRenderIndices[entity] = NoRenderable;
+		++mEntityCount;
+
+		Link(entity, parent);
+		MarkDirty(entity);
+		return entity;
+	}
+
+	void Scene::DestroyEntity(Entity entity)
+	{
+		if (entity >= mAlive.size() || !mAlive[entity])
+		{
+			return;
+		}
+
+		Unlink(entity);
+
+		// Subtree is collected first, destroying while walking it would follow links already cleared
+		std::vector<Entity> subtree(1, entity);
+		for (size_t i = 0; i < subtree.size(); ++i)
+		{
+			for (Entity child = mFirstChildren[subtree[i]]; child != NoEntity; child = mNextSiblings[child])
+			{
+				subtree.push_back(child);
+			}
+		}
+
+		for (Entity destroyed : subtree)
+		{
+			RemoveRenderComponent(destroyed);
+			mAlive[destroyed] = false;
+			// Entry left in dirty list is skipped, as is a later one should handle be reused
+			mDirty[destroyed] = DIRTY_NONE;
+			mFreeEntities.push_back(destroyed);
+			--mEntityCount;
+		}
+	}
+
+	void Scene::SetParent(Entity entity, Entity parent)
+	{
+		for (Entity ancestor = parent; ancestor != NoEntity; ancestor = mParents[ancestor])
+		{
+			if (ancestor == entity)
+			{
+				throw std::runtime_error("failed to parent entity to itself or one of its descendants!");
+			}
+		}
+
+		Unlink(entity);
+		Link(entity, parent);
+		MarkDirty(entity);
+	}
+
+	Scene::Entity Scene::Parent(Entity entity) const
+	{
+		return mParents[entity];
+	}
+
+	void Scene::SetLocalTransform(Entity entity, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+	{
+		mLocalPositions[entity] = position;
+		mLocalRotations[entity] = rotation;
+		mLocalScales[entity] = scale;
+		MarkDirty(entity);
+	}
+
+	void Scene::SetLocalPosition(Entity entity, const glm::vec3& position)
+	{
+		mLocalPositions[entity] = position;
+		MarkDirty(entity);
+	}
+
+	void Scene::SetLocalRotation(Entity entity, const glm::quat& rotation)
+	{
+		mLocalRotations[entity] = rotation;
+		MarkDirty(entity);
+	}
+
+	void Scene::SetLocalScale(Entity entity, const glm::vec3& scale)
+	{
+		mLocalScales[entity] = scale;
+		MarkDirty(entity);
+	}
+
+	const glm::mat4& Scene::WorldMatrix(Entity entity) const
+	{
+		return mWorldMatrices[entity];
+	}
+
+	void Scene::SetRenderComponent(Entity entity, const RenderComponent& component)
+	{
+		if (mRenderIndices[entity] == NoRenderable)
+		{
+			mRenderIndices[entity] = static_cast<uint32_t>(mRenderEntities.size());
+			mRenderEntities.push_back(entity);
+			mRenderComponents.push_back(component);
+		}
+		else
+		{
+			mRenderComponents[mRenderIndices[entity]] = component;
+		}
+		++mVersion;
+	}
+
+	void Scene::RemoveRenderComponent(Entity entity)
+	{
+		uint32_t index = mRenderIndices[entity];
+		if (index == NoRenderable)
+		{
+			return;
+		}
+
+		// Last component fills the gap, so components stay densely packed
+		Entity last = mRenderEntities.back();
+		mRenderEntities[index] = last;
+		mRenderComponents[index] = mRenderComponents.back();
+		mRenderIndices[last] = index;
+		mRenderEntities.pop_back();
+		mRenderComponents.pop_back();
+		mRenderIndices[entity] = NoRenderable;
+		++mVersion;
+	}
+
+	uint32_t Scene::RenderableCount() const
+	{
+		return static_cast<uint32_t>(mRenderEntities.size());
+	}
+
+	Scene::Entity Scene::RenderableEntity(uint32_t index) const
+	{
+		return mRenderEntities[index];
+	}
+
+	const Scene::RenderComponent& Scene::Renderable(uint32_t index) const
+	{
+		return mRenderComponents[index];
+	}
+
+	void Scene::Update(ThreadPool& threadPool)
+	{
+		if (mDirtyEntities.empty())
+		{
+			return;
+		}
+
+		// Walks from dirty entities with a dirty ancestor are left to that ancestor's, so subtrees never overlap
+		mUpdateOrder.clear();
+		mLevelStarts.clear();
+		mLevelStarts.push_back(0);
+		for (Entity entity : mDirtyEntities)
+		{
+			if (mDirty[entity] == DIRTY_PENDING && !HasDirtyAncestor(entity))
+			{
+				mDirty[entity] = DIRTY_COLLECTED;
+				mUpdateOrder.push_back(entity);
+			}
+		}
+		mDirtyEntities.clear();
+
+		// Children of each level form the next one, so a level only reads world matrices written by levels before it
+		uint32_t levelBegin = 0;
+		while (levelBegin < mUpdateOrder.size())
+		{
+			uint32_t levelEnd = static_cast<uint32_t>(mUpdateOrder.size());
+			for (uint32_t i = levelBegin; i < levelEnd; ++i)
+			{
+				for (Entity child = mFirstChildren[mUpdateOrder[i]]; child != NoEntity; child = mNextSiblings[child])
+				{
+					mUpdateOrder.push_back(child);
+				}
+			}
+			mLevelStarts.push_back(levelEnd);
+			levelBegin = levelEnd;
+		}
+
+		for (size_t level = 0; level + 1 < mLevelStarts.size(); ++level)
+		{
+			uint32_t begin = mLevelStarts[level];
+			uint32_t end = mLevelStarts[level + 1];
+			uint32_t batchCount = (end - begin + UpdateBatchSize - 1) / UpdateBatchSize;
+			if (batchCount <= 1)
+			{
+				UpdateRange(begin, end);
+				continue;
+			}
+
+			threadPool.ParallelFor(batchCount, [this, begin, end](uint32_t batch)
+			{
+				uint32_t batchBegin = begin + batch * UpdateBatchSize;
+				UpdateRange(batchBegin, std::min(batchBegin + UpdateBatchSize, end));
+			});
+		}
+
+		++mVersion;
+	}
+
+	uint64_t Scene::Version() const
+	{
+		return mVersion;
+	}
+
+	uint32_t Scene::EntityCount() const
+	{
+		return mEntityCount;
+	}
+
+	void Scene::MarkDirty(Entity entity)
+	{
+		if (mDirty[entity] == DIRTY_NONE)
+		{
+			mDirty[entity] = DIRTY_PENDING;
+			mDirtyEntities.push_back(entity);
+		}
+	}
+
+	void Scene::Unlink(Entity entity)
+	{
+		Entity parent = mParents[entity];
+		if (parent == NoEntity)
+		{
+			return;
+		}
+
+		if (mPreviousSiblings[entity] != NoEntity)
+		{
+			mNextSiblings[mPreviousSiblings[entity]] = mNextSiblings[entity];
+		}
+		else
+		{
+			mFirstChildren[parent] = mNextSiblings[entity];
+		}
+		if (mNextSiblings[entity] != NoEntity)
+		{
+			mPreviousSiblings[mNextSiblings[entity]] = mPreviousSiblings[entity];
+		}
+
+		mParents[entity] = NoEntity;
+		mNextSiblings[entity] = NoEntity;
+		mPreviousSiblings[entity] = NoEntity;
+	}
+
+	void Scene::Link(Entity entity, Entity parent)
+	{
+		mParents[entity] = parent;
+		if (parent == NoEntity)
+		{
+			return;
+		}
+
+		mNextSiblings[entity] = mFirstChildren[parent];
+		if (mFirstChildren[parent] != NoEntity)
+		{
+			mPreviousSiblings[mFirstChildren[parent]] = entity;
+		}
+		mFirstChildren[parent] = entity;
+	}
+
+	bool Scene::HasDirtyAncestor(Entity entity) const
+	{
+		for (Entity ancestor = mParents[entity]; ancestor != NoEntity; ancestor = mParents[ancestor])
+		{
+			if (mDirty[ancestor] != DIRTY_NONE)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Scene::UpdateRange(uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			Entity entity = mUpdateOrder[i];
+
+			// Scaled rotation columns & translation, same as translate * rotate * scale without two full matrix products
+			glm::mat4 local = glm::mat4_cast(mLocalRotations[entity]);
+			local[0] *= mLocalScales[entity].x;
+			local[1] *= mLocalScales[entity].y;
+			local[2] *= mLocalScales[entity].z;
+			local[3] = glm::vec4(mLocalPositions[entity], 1.0f);
+
+			Entity parent = mParents[entity];
+			mWorldMatrices[entity] = parent == NoEntity ? local : mWorldMatrices[parent] * local;
+			mDirty[entity] = DIRTY_NONE;
+		}
+	}
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "ThreadPool.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Entities of the scene with their transform hierarchy & render components, stored as structure of arrays.
+	/// Editing a local transform only flags entity dirty, Update() then recomputes world matrices of dirty subtrees alone,
+	/// level by level with each level split into batches across workers, so unchanged objects cost nothing.
+	/// Every method must be called from the same thread, which is simulation thread once it runs.
+	/// </summary>
+	class Scene final
+	{
+	public:
+		using Entity = uint32_t;
+		static const Entity NoEntity;
+
+		/// <summary>What renderer draws an entity with. Values are renderer's own, scene only stores them.</summary>
+		struct RenderComponent
+		{
+			uint32_t mesh = 0;
+			uint32_t material = 0;
+			bool castsShadow = false;
+		};
+
+		Scene() = default;
+		Scene(const Scene&) = delete;
+		Scene& operator=(const Scene&) = delete;
+		Scene(Scene&&) = delete;
+		Scene& operator=(Scene&&) = delete;
+		~Scene() = default;
+
+		/// <summary>Reserves storage.</summary>
+		/// <param name="capacity">Number of entities expected, more only reallocate.</param>
+		void Initialize(uint32_t capacity);
+
+		/// <summary>Destroys every entity.</summary>
+		void Shutdown();
+
+		/// <summary>Creates an entity with identity local transform.</summary>
+		/// <param name="parent">Entity local transform is relative to, NoEntity for a root.</param>
+		/// <returns>New entity.</returns>
+		Entity CreateEntity(Entity parent = NoEntity);
+
+		/// <summary>Destroys entity together with all of its descendants.</summary>
+		/// <param name="entity">Entity, invalid afterwards.</param>
+		void DestroyEntity(Entity entity);
+
+		/// <summary>Moves entity & its subtree under another parent. Local transform is kept, so world matrices change.</summary>
+		/// <param name="entity">Entity to move.</param>
+		/// <param name="parent">New parent, NoEntity for a root. Must not be entity itself or one of its descendants.</param>
+		void SetParent(Entity entity, Entity parent);
+
+		Entity Parent(Entity entity) const;
+
+		void SetLocalTransform(Entity entity, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+		void SetLocalPosition(Entity entity, const glm::vec3& position);
+		void SetLocalRotation(Entity entity, const glm::quat& rotation);
+		void SetLocalScale(Entity entity, const glm::vec3& scale);
+
+		/// <summary>Gets world matrix as of last Update().</summary>
+		const glm::mat4& WorldMatrix(Entity entity) const;
+
+		/// <summary>Adds render component to entity or replaces its current one.</summary>
+		void SetRenderComponent(Entity entity, const RenderComponent& component);
+		void RemoveRenderComponent(Entity entity);
+
+		/// <summary>Gets number of entities with a render component. Those are densely packed, indices change when one is removed.</summary>
+		uint32_t RenderableCount() const;
+		Entity RenderableEntity(uint32_t index) const;
+		const RenderComponent& Renderable(uint32_t index) const;
+
+		/// <summary>Recomputes world matrices of dirty entities & all of their descendants.</summary>
+		/// <param name="threadPool">Pool batches of a hierarchy level are spread over. Must not be called from one of its workers.</param>
+		void Update(ThreadPool& threadPool);
+
+		/// <summary>Gets a number which changes whenever a world matrix or render component did. Zero is never a version.</summary>
+		uint64_t Version() const;
+
+		uint32_t EntityCount() const;
+
+	private:
+		static const uint32_t NoRenderable;
+		// Entities of one level a single task updates, small levels aren't worth handing to workers
+		static const uint32_t UpdateBatchSize;
+
+		enum DirtyState : uint8_t
+		{
+			DIRTY_NONE = 0,
+			DIRTY_PENDING = 1,
+			// Root of a subtree collected for this update, stale duplicates in dirty list are skipped
+			DIRTY_COLLECTED = 2
+		};
+
+		void MarkDirty(Entity entity);
+		void Unlink(Entity entity);
+		void Link(Entity entity, Entity parent);
+		bool HasDirtyAncestor(Entity entity) const;
+		void UpdateRange(uint32_t begin, uint32_t end);
+
+		// Local transforms
+		std::vector<glm::vec3> mLocalPositions;
+		std::vector<glm::quat> mLocalRotations;
+		std::vector<glm::vec3> mLocalScales;
+		std::vector<glm::mat4> mWorldMatrices;
+
+		// Hierarchy, children of an entity form a doubly linked list so unlinking one is constant time
+		std::vector<Entity> mParents;
+		std::vector<Entity> mFirstChildren;
+		std::vector<Entity> mNextSiblings;
+		std::vector<Entity> mPreviousSiblings;
+
+		std::vector<uint8_t> mDirty;
+		std::vector<uint8_t> mAlive;
+		std::vector<Entity> mDirtyEntities;
+		std::vector<Entity> mFreeEntities;
+		uint32_t mEntityCount = 0;
+
+		// Render components, dense arrays & index of each entity's component into them
+		std::vector<uint32_t> mRenderIndices;
+		std::vector<Entity> mRenderEntities;
+		std::vector<RenderComponent> mRenderComponents;
+
+		// Dirty subtrees flattened breadth first, every level only depends on levels before it
+		std::vector<Entity> mUpdateOrder;
+		std::vector<uint32_t> mLevelStarts;
+
+		uint64_t mVersion = 1;
+	};
+}
@@ -0,0 +1,318 @@
+#include "ShaderCompiler.h"
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <cstdio>
+#include <thread>
+#include <functional>
+#include <shaderc/shaderc.hpp>
+#include "SourceFingerprint.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	// "ASPV"
+	const uint32_t ShaderCompiler::CacheMagic = 0x56505341;
+	const uint32_t ShaderCompiler::CacheVersion = 1;
+	const char* const ShaderCompiler::CacheDirectory = "ShaderCache";
+
+	/// <summary>Resolves #include through asset file system & records content hash of every included file.</summary>
+	class ShaderCompiler::Includer final : public shaderc::CompileOptions::IncluderInterface
+	{
+	public:
+		Includer(const AssetFileSystem& assets, std::vector<Dependency>& dependencies) :
+			mAssets(assets), mDependencies(dependencies)
+		{
+		}
+
+		shaderc_include_result* GetInclude(const char* requestedSource, shaderc_include_type type, const char* requestingSource, size_t /*includeDepth*/) override
+		{
+			// "file" is relative to including file, <file> to shader directory
+			std::filesystem::path directory = type == shaderc_include_type_relative ? std::filesystem::path(requestingSource).parent_path() : std::filesystem::path("Shaders");
+			auto include = new Include();
+			include->name = (directory / requestedSource).lexically_normal().generic_string();
+			include->file = mAssets.Read(include->name, AssetFileSystem::Lookup::LooseFirst);
+			if (include->file)
+			{
+				mDependencies.push_back({ include->name, include->file.ContentHash() });
+				include->result.source_name = include->name.c_str();
+				include->result.source_name_length = include->name.size();
+				include->result.content = reinterpret_cast<const char*>(include->file.data);
+				include->result.content_length = include->file.size;
+			}
+			else
+			{
+				// Empty source name tells shaderc content is an error message
+				include->error = "failed to open include " + include->name;
+				include->result.source_name = "";
+				include->result.source_name_length = 0;
+				include->result.content = include->error.c_str();
+				include->result.content_length = include->error.size();
+			}
+			include->result.user_data = include;
+			return &include->result;
+		}
+
+		void ReleaseInclude(shaderc_include_result* data) override
+		{
+			delete static_cast<Include*>(data->user_data);
+		}
+
+	private:
+		struct Include
+		{
+			shaderc_include_result result = {};
+			std::string name;
+			AssetFileSystem::File file;
+			std::string error;
+		};
+
+		const AssetFileSystem& mAssets;
+		std::vector<Dependency>& mDependencies;
+	};
+
+	ShaderCompiler::ShaderCompiler() = default;
+
+	ShaderCompiler::~ShaderCompiler() = default;
+
+	void ShaderCompiler::Initialize(const AssetFileSystem& assets)
+	{
+		mAssets = &assets;
+		mCompiler = std::make_unique<shaderc::Compiler>();
+	}
+
+	void ShaderCompiler::Shutdown()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mEntries.clear();
+		mWatchedSources.clear();
+		mCompiler.reset();
+		mAssets = nullptr;
+	}
+
+	bool ShaderCompiler::Compile(const Request& request, std::vector<uint32_t>& spirv, std::string& log)
+	{
+		log.clear();
+
+		AssetFileSystem::File source = mAssets->Read(request.name, AssetFileSystem::Lookup::LooseFirst);
+		if (!source)
+		{
+			log = "failed to open " + request.name;
+			return false;
+		}
+		uint64_t sourceHash = source.ContentHash();
+		uint64_t key = Key(request, sourceHash);
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			auto cached = mEntries.find(key);
+			if (cached != mEntries.end() && IsUpToDate(cached->second))
+			{
+				spirv = cached->second.spirv;
+				return true;
+			}
+		}
+
+		// Warm start: entry cooked by an earlier run or shipped in pack, nothing is compiled
+		Entry entry;
+		if (!ReadCacheEntry(key, entry) || !IsUpToDate(entry))
+		{
+			entry.dependencies = { { request.name, sourceHash } };
+
+			shaderc::CompileOptions options;
+			for (const auto& define : request.defines)
+			{
+				options.AddMacroDefinition(define.first, define.second);
+			}
+			options.SetOptimizationLevel(request.optimize ? shaderc_optimization_level_performance : shaderc_optimization_level_zero);
+			options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_0);
+			options.SetIncluder(std::make_unique<Includer>(*mAssets, entry.dependencies));
+
+			shaderc_shader_kind kind = request.stage == Stage::Vertex ? shaderc_glsl_vertex_shader : shaderc_glsl_fragment_shader;
+			shaderc::SpvCompilationResult result = mCompiler->CompileGlslToSpv(reinterpret_cast<const char*>(source.data), source.size, kind, request.name.c_str(), options);
+			log = result.GetErrorMessage();
+			if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+			{
+				return false;
+			}
+
+			entry.spirv.assign(result.cbegin(), result.cend());
+			WriteCacheEntry(key, entry);
+		}
+
+		spirv = entry.spirv;
+		Watch(entry.dependencies);
+		std::lock_guard<std::mutex> lock(mMutex);
+		mEntries[key] = std::move(entry);
+		return true;
+	}
+
+	bool ShaderCompiler::PollChangedSources()
+	{
+		std::map<std::string, uint64_t> watchedSources;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			watchedSources = mWatchedSources;
+		}
+
+		bool changed = false;
+		for (auto& watched : watchedSources)
+		{
+			AssetFileSystem::File file = mAssets->Read(watched.first, AssetFileSystem::Lookup::LooseFirst);
+			uint64_t hash = file ? file.ContentHash() : 0;
+			if (hash != watched.second)
+			{
+				// Remembered as seen, so a shader which fails to compile isn't reported again every poll
+				watched.second = hash;
+				changed = true;
+			}
+		}
+
+		if (changed)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			for (const auto& watched : watchedSources)
+			{
+				mWatchedSources[watched.first] = watched.second;
+			}
+		}
+		return changed;
+	}
+
+	uint64_t ShaderCompiler::Key(const Request& request, uint64_t sourceHash) const
+	{
+		std::string keyData;
+		keyData.append(reinterpret_cast<const char*>(&CacheVersion), sizeof(CacheVersion));
+		keyData.append(reinterpret_cast<const char*>(&sourceHash), sizeof(sourceHash));
+		keyData += request.stage == Stage::Vertex ? 'v' : 'f';
+		keyData += request.optimize ? 'o' : '-';
+		keyData += request.name;
+		for (const auto& define : request.defines)
+		{
+			keyData += '\0' + define.first + '=' + define.second;
+		}
+		return SourceFingerprint::Hash(reinterpret_cast<const uint8_t*>(keyData.data()), keyData.size());
+	}
+
+	bool ShaderCompiler::IsUpToDate(const Entry& entry) const
+	{
+		for (const Dependency& dependency : entry.dependencies)
+		{
+			AssetFileSystem::File file = mAssets->Read(dependency.name, AssetFileSystem::Lookup::LooseFirst);
+			if (!file || file.ContentHash() != dependency.hash)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool ShaderCompiler::ReadCacheEntry(uint64_t key, Entry& entry) const
+	{
+		// Header, dependencies as hash, name length & name, then SPIR-V words
+		AssetFileSystem::File file = mAssets->Read(CacheName(key));
+		const CacheHeader* header = reinterpret_cast<const CacheHeader*>(file.data);
+		if (!file || file.size < sizeof(CacheHeader) || header->magic != CacheMagic || header->version != CacheVersion || header->key != key
+			|| header->dependencyCount > file.size)
+		{
+			return false;
+		}
+
+		const uint8_t* cursor = file.data + sizeof(CacheHeader);
+		const uint8_t* end = file.data + file.size;
+		entry.dependencies.resize(header->dependencyCount);
+		for (Dependency& dependency : entry.dependencies)
+		{
+			uint32_t nameLength;
+			if (static_cast<size_t>(end - cursor) < sizeof(uint64_t) + sizeof(uint32_t))
+			{
+				return false;
+			}
+			memcpy(&dependency.hash, cursor, sizeof(uint64_t));
+			memcpy(&nameLength, cursor + sizeof(uint64_t), sizeof(uint32_t));
+			cursor += sizeof(uint64_t) + sizeof(uint32_t);
+			if (static_cast<size_t>(end - cursor) < nameLength)
+			{
+				return false;
+			}
+			dependency.name.assign(reinterpret_cast<const char*>(cursor), nameLength);
+			cursor += nameLength;
+		}
+
+		if (static_cast<size_t>(end - cursor) != static_cast<size_t>(header->spirvWordCount) * sizeof(uint32_t))
+		{
+			return false;
+		}
+		entry.spirv.resize(header->spirvWordCount);
+		memcpy(entry.spirv.data(), cursor, entry.spirv.size() * sizeof(uint32_t));
+		return true;
+	}
+
+	void ShaderCompiler::WriteCacheEntry(uint64_t key, const Entry& entry) const
+	{
+		// Without a loose Assets directory, e.g. a read-only install, shaders just compile again next launch
+		std::string path = mAssets->LoosePath(CacheName(key));
+		if (path.empty())
+		{
+			return;
+		}
+
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+		CacheHeader header = {};
+		header.magic = CacheMagic;
+		header.version = CacheVersion;
+		header.key = key;
+		header.dependencyCount = static_cast<uint32_t>(entry.dependencies.size());
+		header.spirvWordCount = static_cast<uint32_t>(entry.spirv.size());
+
+		// Several threads may write same entry, each through its own temporary file
+		std::string temporaryPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!file)
+			{
+				return;
+			}
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			for (const Dependency& dependency : entry.dependencies)
+			{
+				uint32_t nameLength = static_cast<uint32_t>(dependency.name.size());
+				file.write(reinterpret_cast<const char*>(&dependency.hash), sizeof(dependency.hash));
+				file.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+				file.write(dependency.name.data(), nameLength);
+			}
+			file.write(reinterpret_cast<const char*>(entry.spirv.data()), static_cast<std::streamsize>(entry.spirv.size() * sizeof(uint32_t)));
+
+			if (!file)
+			{
+				file.close();
+				std::filesystem::remove(temporaryPath, error);
+				return;
+			}
+		}
+
+		std::filesystem::rename(temporaryPath, path, error);
+		if (error)
+		{
+			std::filesystem::remove(temporaryPath, error);
+		}
+	}
+
+	std::string ShaderCompiler::CacheName(uint64_t key)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.spv", static_cast<unsigned long long>(key));
+		return std::string(CacheDirectory) + "/" + name;
+	}
+
+	void ShaderCompiler::Watch(const std::vector<Dependency>& dependencies)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (const Dependency& dependency : dependencies)
+		{
+			mWatchedSources[dependency.name] = dependency.hash;
+		}
+	}
+}
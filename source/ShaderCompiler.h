@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <mutex>
+#include <memory>
+#include "AssetFileSystem.h"
+
+namespace shaderc
+{
+	class Compiler;
+}
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Compiles GLSL shader assets to SPIR-V with shaderc & caches results in memory & on disk. Cache entries are keyed by hash of
+	/// source, defines & options, & record content hash of every file they included, so an entry whose includes changed is compiled
+	/// again. Entries are written to "ShaderCache" in loose Assets directory & read pack first, so a packed cache makes even a
+	/// first start compile nothing. Sources are read loose first, so shaders edited while engine runs are picked up.
+	/// Compile() may be called from several threads at once.
+	/// </summary>
+	class ShaderCompiler final
+	{
+	public:
+		enum class Stage
+		{
+			Vertex,
+			Fragment
+		};
+
+		struct Request
+		{
+			// Asset name of GLSL source, e.g. "Shaders/shader.frag"
+			std::string name;
+			Stage stage = Stage::Vertex;
+			// Preprocessor definitions, name & value
+			std::vector<std::pair<std::string, std::string>> defines;
+			bool optimize = true;
+		};
+
+		ShaderCompiler();
+		ShaderCompiler(const ShaderCompiler&) = delete;
+		ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+		ShaderCompiler(ShaderCompiler&&) = delete;
+		ShaderCompiler& operator=(ShaderCompiler&&) = delete;
+		~ShaderCompiler();
+
+		/// <summary>Starts compiler. Assets must outlive it.</summary>
+		void Initialize(const AssetFileSystem& assets);
+
+		/// <summary>Drops in-memory cache & watched sources.</summary>
+		void Shutdown();
+
+		/// <summary>Gets SPIR-V of a shader, compiling it only if no cache entry is up to date.</summary>
+		/// <param name="request">Source, stage, defines & options.</param>
+		/// <param name="spirv">Receives SPIR-V words.</param>
+		/// <param name="log">Receives compiler errors & warnings.</param>
+		/// <returns>False if source is missing or doesn't compile.</returns>
+		bool Compile(const Request& request, std::vector<uint32_t>& spirv, std::string& log);
+
+		/// <summary>Checks whether any source or include compiled so far changed since it was compiled or last polled.</summary>
+		/// <returns>True if shaders using changed files must be compiled again & their pipelines rebuilt.</returns>
+		bool PollChangedSources();
+
+	private:
+		struct Dependency
+		{
+			std::string name;
+			uint64_t hash = 0;
+		};
+
+		struct Entry
+		{
+			std::vector<Dependency> dependencies;
+			std::vector<uint32_t> spirv;
+		};
+
+		struct CacheHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t key;
+			uint32_t dependencyCount;
+			uint32_t spirvWordCount;
+		};
+
+		class Includer;
+
+		uint64_t Key(const Request& request, uint64_t sourceHash) const;
+		bool IsUpToDate(const Entry& entry) const;
+		bool ReadCacheEntry(uint64_t key, Entry& entry) const;
+		void WriteCacheEntry(uint64_t key, const Entry& entry) const;
+		static std::string CacheName(uint64_t key);
+		void Watch(const std::vector<Dependency>& dependencies);
+
+		static const uint32_t CacheMagic;
+		static const uint32_t CacheVersion;
+		static const char* const CacheDirectory;
+
+		const AssetFileSystem* mAssets = nullptr;
+		std::unique_ptr<shaderc::Compiler> mCompiler;
+
+		std::mutex mMutex;
+		std::unordered_map<uint64_t, Entry> mEntries;
+		// Content hash of every file compiled so far, as of its last compile or poll
+		std::map<std::string, uint64_t> mWatchedSources;
+	};
+}
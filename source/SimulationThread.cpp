@@ -0,0 +1,65 @@
+#include "SimulationThread.h"
+#include <algorithm>
+
+using namespace std::chrono;
+
+namespace AlphonsoGraphicsEngine
+{
+	SimulationThread::SimulationThread(high_resolution_clock::duration stepDuration) :
+		mStepDuration(stepDuration)
+	{
+	}
+
+	SimulationThread::~SimulationThread()
+	{
+		Stop();
+	}
+
+	void SimulationThread::Start(StepCallback step)
+	{
+		Stop();
+
+		mStep = std::move(step);
+		mRunning = true;
+		mThread = std::thread(&SimulationThread::Run, this);
+	}
+
+	void SimulationThread::Stop()
+	{
+		mRunning = false;
+		if (mThread.joinable())
+		{
+			mThread.join();
+		}
+	}
+
+	const high_resolution_clock::duration& SimulationThread::StepDuration() const
+	{
+		return mStepDuration;
+	}
+
+	void SimulationThread::Run()
+	{
+		GameTime realTime;
+		GameTime stepTime;
+		high_resolution_clock::duration accumulator{ 0 };
+
+		mGameClock.Reset();
+		while (mRunning)
+		{
+			mGameClock.UpdateGameTime(realTime);
+			accumulator += std::min(realTime.ElapsedGameTime(), mStepDuration * MaxStepsPerUpdate);
+
+			while (accumulator >= mStepDuration)
+			{
+				stepTime.SetCurrentTime(realTime.CurrentTime());
+				stepTime.SetElapsedGameTime(mStepDuration);
+				stepTime.SetTotalGameTime(stepTime.TotalGameTime() + mStepDuration);
+				mStep(stepTime);
+				accumulator -= mStepDuration;
+			}
+
+			std::this_thread::sleep_for(mStepDuration - accumulator);
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include "GameClock.h"
+#include "GameTime.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Runs a step callback at a fixed rate on its own thread, independent of render frame rate.
+	/// Real time measured by GameClock is accumulated & consumed in whole steps, so every step sees same elapsed time.
+	/// </summary>
+	class SimulationThread final
+	{
+	public:
+		using StepCallback = std::function<void(const GameTime& gameTime)>;
+
+		/// <summary>Creates stopped simulation thread.</summary>
+		/// <param name="stepDuration">Simulated time advanced by each step.</param>
+		explicit SimulationThread(std::chrono::high_resolution_clock::duration stepDuration = std::chrono::microseconds(16667));
+		SimulationThread(const SimulationThread&) = delete;
+		SimulationThread& operator=(const SimulationThread&) = delete;
+		SimulationThread(SimulationThread&&) = delete;
+		SimulationThread& operator=(SimulationThread&&) = delete;
+
+		/// <summary>Stops thread if still running.</summary>
+		~SimulationThread();
+
+		/// <summary>Starts thread calling step for every fixed step of elapsed real time.</summary>
+		/// <param name="step">Callback invoked on simulation thread.</param>
+		void Start(StepCallback step);
+
+		/// <summary>Finishes current step & joins thread.</summary>
+		void Stop();
+
+		const std::chrono::high_resolution_clock::duration& StepDuration() const;
+
+	private:
+		void Run();
+
+		// Upper bound of real time consumed per wake up, so a stall doesn't trigger an endless catch up
+		static const uint32_t MaxStepsPerUpdate = 8;
+
+		std::chrono::high_resolution_clock::duration mStepDuration;
+		StepCallback mStep;
+		std::thread mThread;
+		std::atomic<bool> mRunning{ false };
+
+		GameClock mGameClock;
+	};
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Lock-free hand-off of snapshots from a single producer thread to a single consumer thread.
+	/// Producer fills back buffer & publishes it, consumer always picks up latest published snapshot.
+	/// Front & back buffer are backed by three slots, so producer can start next snapshot
+	/// while consumer still reads previous one without either side ever waiting.
+	/// </summary>
+	template <typename T>
+	class SnapshotBuffer final
+	{
+	public:
+		SnapshotBuffer() = default;
+		SnapshotBuffer(const SnapshotBuffer&) = delete;
+		SnapshotBuffer& operator=(const SnapshotBuffer&) = delete;
+		SnapshotBuffer(SnapshotBuffer&&) = delete;
+		SnapshotBuffer& operator=(SnapshotBuffer&&) = delete;
+		~SnapshotBuffer() = default;
+
+		/// <summary>Gets back buffer producer writes next snapshot into. Producer thread only.</summary>
+		/// <returns>Reference to back buffer.</returns>
+		T& BackBuffer()
+		{
+			return mSlots[mBackIndex];
+		}
+
+		/// <summary>Makes back buffer visible to consumer & hands producer a free slot. Producer thread only.</summary>
+		void Publish()
+		{
+			mBackIndex = mSharedIndex.exchange(mBackIndex | PublishedBit, std::memory_order_acq_rel) & IndexMask;
+		}
+
+		/// <summary>Gets latest published snapshot. Stays valid until next call. Consumer thread only.</summary>
+		/// <returns>Const reference to front buffer.</returns>
+		const T& AcquireLatest()
+		{
+			if (mSharedIndex.load(std::memory_order_relaxed) & PublishedBit)
+			{
+				mFrontIndex = mSharedIndex.exchange(mFrontIndex, std::memory_order_acq_rel) & IndexMask;
+			}
+			return mSlots[mFrontIndex];
+		}
+
+	private:
+		static const uint32_t IndexMask = 0x3;
+		static const uint32_t PublishedBit = 0x4;
+
+		std::array<T, 3> mSlots = {};
+		uint32_t mBackIndex = 0;
+		uint32_t mFrontIndex = 1;
+		std::atomic<uint32_t> mSharedIndex{ 2 };
+	};
+}
@@ -0,0 +1,71 @@
+#include "SourceFingerprint.h"
+#include <filesystem>
+#include "MappedFile.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	bool SourceFingerprint::Capture(const std::string& path, SourceFingerprint& fingerprint)
+	{
+		return GetFileInfo(path, fingerprint.size, fingerprint.modifiedTime) && HashFile(path, fingerprint.hash);
+	}
+
+	bool SourceFingerprint::Matches(const std::string& path) const
+	{
+		uint64_t currentSize;
+		int64_t currentModifiedTime;
+		if (!GetFileInfo(path, currentSize, currentModifiedTime) || currentSize != size)
+		{
+			return false;
+		}
+
+		// Same size but different time is only stale if contents changed too
+		if (currentModifiedTime != modifiedTime)
+		{
+			uint64_t currentHash;
+			return HashFile(path, currentHash) && currentHash == hash;
+		}
+		return true;
+	}
+
+	bool SourceFingerprint::GetFileInfo(const std::string& path, uint64_t& size, int64_t& modifiedTime)
+	{
+		std::error_code error;
+		size = static_cast<uint64_t>(std::filesystem::file_size(path, error));
+		if (error)
+		{
+			return false;
+		}
+
+		auto time = std::filesystem::last_write_time(path, error);
+		if (error)
+		{
+			return false;
+		}
+		modifiedTime = static_cast<int64_t>(time.time_since_epoch().count());
+		return true;
+	}
+
+	bool SourceFingerprint::HashFile(const std::string& path, uint64_t& hash)
+	{
+		MappedFile file;
+		if (!file.Open(path))
+		{
+			return false;
+		}
+
+		hash = Hash(file.Data(), file.Size());
+		return true;
+	}
+
+	uint64_t SourceFingerprint::Hash(const uint8_t* data, size_t size)
+	{
+		// 64 bit FNV-1a
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= data[i];
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Identity of a source asset a cooked file was built from. Size & modification time are compared first;
+	/// content hash only when time alone differs, e.g. after a fresh checkout touched every file.
+	/// </summary>
+	struct SourceFingerprint
+	{
+		uint64_t size = 0;
+		int64_t modifiedTime = 0;
+		// 64 bit FNV-1a of contents
+		uint64_t hash = 0;
+
+		/// <summary>Fingerprints source file, hashing its whole contents.</summary>
+		/// <param name="path">Path of source file.</param>
+		/// <param name="fingerprint">Receives fingerprint.</param>
+		/// <returns>False if file can't be read.</returns>
+		static bool Capture(const std::string& path, SourceFingerprint& fingerprint);
+
+		/// <summary>Checks whether source file still is what this fingerprint was captured from.</summary>
+		/// <param name="path">Path of source file.</param>
+		/// <returns>False if file changed or can't be read.</returns>
+		bool Matches(const std::string& path) const;
+
+		/// <summary>Hashes contents the way fingerprints do, 64 bit FNV-1a.</summary>
+		static uint64_t Hash(const uint8_t* data, size_t size);
+
+	private:
+		static bool GetFileInfo(const std::string& path, uint64_t& size, int64_t& modifiedTime);
+		static bool HashFile(const std::string& path, uint64_t& hash);
+	};
+}
@@ -0,0 +1,127 @@
+#include "StagingHeap.h"
+#include <stdexcept>
+
+namespace AlphonsoGraphicsEngine
+{
+	void StagingHeap::Initialize(VkDevice device, DeviceMemoryAllocator& allocator, VkDeviceSize capacity)
+	{
+		mDevice = device;
+		mAllocator = &allocator;
+		mCapacity = capacity;
+
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = capacity;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (vkCreateBuffer(mDevice, &bufferInfo, nullptr, &mBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create staging heap buffer!");
+		}
+
+		mAllocation = mAllocator->AllocateForBuffer(mBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		mMappedData = static_cast<uint8_t*>(mAllocation.mappedData);
+	}
+
+	void StagingHeap::Shutdown()
+	{
+		vkDestroyBuffer(mDevice, mBuffer, nullptr);
+		mAllocator->Free(mAllocation);
+		mBuffer = VK_NULL_HANDLE;
+		mMappedData = nullptr;
+
+		mReservations.clear();
+		mHead = mTail = mBytesInUse = 0;
+	}
+
+	bool StagingHeap::TryReserve(VkDeviceSize size, VkDeviceSize alignment, Region& region)
+	{
+		// Rewind an empty ring, so next reservation gets whole capacity
+		if (mBytesInUse == 0)
+		{
+			mHead = mTail = 0;
+		}
+		else if (mHead == mTail)
+		{
+			return false;
+		}
+
+		VkDeviceSize offset = (mHead + alignment - 1) & ~(alignment - 1);
+		VkDeviceSize consumed;
+
+		if (mHead >= mTail)
+		{
+			// Free space is [head, capacity) followed by [0, tail)
+			if (offset + size <= mCapacity)
+			{
+				consumed = offset + size - mHead;
+			}
+			else if (size <= mTail)
+			{
+				offset = 0;
+				consumed = mCapacity - mHead + size;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		else
+		{
+			// Free space is [head, tail)
+			if (offset + size > mTail)
+			{
+				return false;
+			}
+			consumed = offset + size - mHead;
+		}
+
+		mHead = offset + size;
+		if (mHead == mCapacity)
+		{
+			mHead = 0;
+		}
+		mBytesInUse += consumed;
+
+		Reservation reservation;
+		reservation.bytes = consumed;
+		mReservations.push_back(reservation);
+
+		region.data = mMappedData + offset;
+		region.offset = offset;
+		region.size = size;
+		region.id = mFirstReservationId + mReservations.size() - 1;
+		return true;
+	}
+
+	void StagingHeap::Release(const Region& region)
+	{
+		mReservations[static_cast<size_t>(region.id - mFirstReservationId)].released = true;
+
+		while (!mReservations.empty() && mReservations.front().released)
+		{
+			VkDeviceSize bytes = mReservations.front().bytes;
+			mTail = (mTail + bytes) % mCapacity;
+			mBytesInUse -= bytes;
+
+			mReservations.pop_front();
+			mFirstReservationId++;
+		}
+	}
+
+	VkBuffer StagingHeap::Buffer() const
+	{
+		return mBuffer;
+	}
+
+	VkDeviceSize StagingHeap::Capacity() const
+	{
+		return mCapacity;
+	}
+
+	VkDeviceSize StagingHeap::BytesInUse() const
+	{
+		return mBytesInUse;
+	}
+}
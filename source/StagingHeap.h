@@ -0,0 +1,79 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <deque>
+#include "DeviceMemoryAllocator.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Ring of persistently mapped, host coherent staging memory backing a single transfer source buffer.
+	/// Reservations are handed out in ring order and may be released in any order; space is only reclaimed
+	/// once every reservation before it was released too, so a slow upload holds back the ones after it.
+	/// </summary>
+	class StagingHeap final
+	{
+	public:
+		struct Region
+		{
+			uint8_t* data = nullptr;
+			VkDeviceSize offset = 0;
+			VkDeviceSize size = 0;
+			uint64_t id = 0;
+		};
+
+		StagingHeap() = default;
+		StagingHeap(const StagingHeap&) = delete;
+		StagingHeap& operator=(const StagingHeap&) = delete;
+		StagingHeap(StagingHeap&&) = delete;
+		StagingHeap& operator=(StagingHeap&&) = delete;
+		~StagingHeap() = default;
+
+		/// <summary>Creates staging buffer & maps its memory.</summary>
+		/// <param name="device">Logical device.</param>
+		/// <param name="allocator">Allocator memory is taken from.</param>
+		/// <param name="capacity">Size of ring in bytes.</param>
+		void Initialize(VkDevice device, DeviceMemoryAllocator& allocator, VkDeviceSize capacity);
+
+		/// <summary>Destroys staging buffer. GPU must be done reading from it.</summary>
+		void Shutdown();
+
+		/// <summary>Reserves contiguous space at head of ring.</summary>
+		/// <param name="size">Bytes needed.</param>
+		/// <param name="alignment">Required alignment of region offset. Must be a power of two.</param>
+		/// <param name="region">Reserved region, valid if reservation succeeded.</param>
+		/// <returns>False if ring has no contiguous free space of that size right now.</returns>
+		bool TryReserve(VkDeviceSize size, VkDeviceSize alignment, Region& region);
+
+		/// <summary>Marks region free. Its space is reused once all older regions are released as well.</summary>
+		/// <param name="region">Region returned by TryReserve().</param>
+		void Release(const Region& region);
+
+		VkBuffer Buffer() const;
+		VkDeviceSize Capacity() const;
+		VkDeviceSize BytesInUse() const;
+
+	private:
+		struct Reservation
+		{
+			// Bytes taken from ring, including alignment padding & space skipped when wrapping
+			VkDeviceSize bytes = 0;
+			bool released = false;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		DeviceMemoryAllocator* mAllocator = nullptr;
+		VkBuffer mBuffer = VK_NULL_HANDLE;
+		DeviceMemoryAllocator::Allocation mAllocation;
+		uint8_t* mMappedData = nullptr;
+
+		VkDeviceSize mCapacity = 0;
+		VkDeviceSize mHead = 0;
+		VkDeviceSize mTail = 0;
+		VkDeviceSize mBytesInUse = 0;
+
+		// Outstanding reservations in ring order, front one has id mFirstReservationId
+		std::deque<Reservation> mReservations;
+		uint64_t mFirstReservationId = 0;
+	};
+}
@@ -0,0 +1,533 @@
+#include "TextureCompressor.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace AlphonsoGraphicsEngine
+{
+	const uint32_t TextureCompressor::BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	bool TextureCompressor::IsSupported(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	uint32_t TextureCompressor::BlockSize(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+			return 8;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return 16;
+		default:
+			throw std::runtime_error("failed to compress texture, unsupported block format!");
+		}
+	}
+
+	size_t TextureCompressor::CompressedSize(VkFormat format, uint32_t width, uint32_t height)
+	{
+		return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * BlockSize(format);
+	}
+
+	void TextureCompressor::Compress(VkFormat format, const uint8_t* pixels, uint32_t width, uint32_t height, ThreadPool& threadPool, uint8_t* blocks)
+	{
+		const uint32_t blockSize = BlockSize(format);
+		const uint32_t blocksX = (width + 3) / 4;
+		const uint32_t blocksY = (height + 3) / 4;
+
+		threadPool.ParallelFor(blocksY, [&](uint32_t blockY)
+		{
+			Block texels;
+			for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+			{
+				for (uint32_t texel = 0; texel < 16; ++texel)
+				{
+					uint32_t x = std::min(blockX * 4 + texel % 4, width - 1);
+					uint32_t y = std::min(blockY * 4 + texel / 4, height - 1);
+					const uint8_t* source = pixels + (static_cast<size_t>(y) * width + x) * 4;
+					for (uint32_t channel = 0; channel < 4; ++channel)
+					{
+						texels[texel][channel] = source[channel];
+					}
+				}
+
+				uint8_t* output = blocks + (static_cast<size_t>(blockY) * blocksX + blockX) * blockSize;
+				switch (format)
+				{
+				case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+				case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+					EncodeBC1(texels, output);
+					break;
+				case VK_FORMAT_BC3_UNORM_BLOCK:
+				case VK_FORMAT_BC3_SRGB_BLOCK:
+					EncodeBC4(texels, 3, output);
+					EncodeBC1(texels, output + 8);
+					break;
+				case VK_FORMAT_BC4_UNORM_BLOCK:
+					EncodeBC4(texels, 0, output);
+					break;
+				case VK_FORMAT_BC5_UNORM_BLOCK:
+					EncodeBC4(texels, 0, output);
+					EncodeBC4(texels, 1, output + 8);
+					break;
+				default:
+					EncodeBC7(texels, output);
+					break;
+				}
+			}
+		});
+	}
+
+	void TextureCompressor::EncodeBC1(const Block& texels, uint8_t* output)
+	{
+		auto quantize = [](const float endpoint[4])
+		{
+			uint32_t r = static_cast<uint32_t>(std::lround(std::clamp(endpoint[0], 0.0f, 255.0f) * 31.0f / 255.0f));
+			uint32_t g = static_cast<uint32_t>(std::lround(std::clamp(endpoint[1], 0.0f, 255.0f) * 63.0f / 255.0f));
+			uint32_t b = static_cast<uint32_t>(std::lround(std::clamp(endpoint[2], 0.0f, 255.0f) * 31.0f / 255.0f));
+			return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+		};
+
+		auto expand = [](uint16_t color, float rgb[3])
+		{
+			uint32_t r = (color >> 11) & 31;
+			uint32_t g = (color >> 5) & 63;
+			uint32_t b = color & 31;
+			rgb[0] = static_cast<float>((r << 3) | (r >> 2));
+			rgb[1] = static_cast<float>((g << 2) | (g >> 4));
+			rgb[2] = static_cast<float>((b << 3) | (b >> 2));
+		};
+
+		// Quantises endpoints, orders them for four colour mode & picks nearest palette entry of every texel
+		auto encode = [&texels, &quantize, &expand](const float endpoint0[4], const float endpoint1[4], uint16_t& color0, uint16_t& color1, uint8_t indices[16])
+		{
+			color0 = quantize(endpoint0);
+			color1 = quantize(endpoint1);
+			if (color0 < color1)
+			{
+				std::swap(color0, color1);
+			}
+			if (color0 == color1)
+			{
+				memset(indices, 0, 16);
+				float rgb[3];
+				expand(color0, rgb);
+				float error = 0.0f;
+				for (uint32_t texel = 0; texel < 16; ++texel)
+				{
+					for (uint32_t channel = 0; channel < 3; ++channel)
+					{
+						error += (texels[texel][channel] - rgb[channel]) * (texels[texel][channel] - rgb[channel]);
+					}
+				}
+				return error;
+			}
+
+			float palette[4][3];
+			expand(color0, palette[0]);
+			expand(color1, palette[1]);
+			for (uint32_t channel = 0; channel < 3; ++channel)
+			{
+				palette[2][channel] = (2.0f * palette[0][channel] + palette[1][channel]) / 3.0f;
+				palette[3][channel] = (palette[0][channel] + 2.0f * palette[1][channel]) / 3.0f;
+			}
+
+			float error = 0.0f;
+			for (uint32_t texel = 0; texel < 16; ++texel)
+			{
+				float bestDistance = FLT_MAX;
+				for (uint8_t entry = 0; entry < 4; ++entry)
+				{
+					float distance = 0.0f;
+					for (uint32_t channel = 0; channel < 3; ++channel)
+					{
+						distance += (texels[texel][channel] - palette[entry][channel]) * (texels[texel][channel] - palette[entry][channel]);
+					}
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						indices[texel] = entry;
+					}
+				}
+				error += bestDistance;
+			}
+			return error;
+		};
+
+		float endpoint0[4];
+		float endpoint1[4];
+		FitEndpoints(texels, 3, endpoint0, endpoint1);
+
+		uint16_t color0, color1;
+		uint8_t indices[16];
+		float error = encode(endpoint0, endpoint1, color0, color1, indices);
+
+		// Palette entries in terms of blend weight from colour 0 to colour 1
+		if (color0 != color1)
+		{
+			static const float Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+			float rgb0[3], rgb1[3];
+			expand(color0, rgb0);
+			expand(color1, rgb1);
+			float refined0[4] = { rgb0[0], rgb0[1], rgb0[2], 0.0f };
+			float refined1[4] = { rgb1[0], rgb1[1], rgb1[2], 0.0f };
+			RefineEndpoints(texels, 3, indices, Weights, refined0, refined1);
+
+			uint16_t refinedColor0, refinedColor1;
+			uint8_t refinedIndices[16];
+			float refinedError = encode(refined0, refined1, refinedColor0, refinedColor1, refinedIndices);
+			if (refinedError < error)
+			{
+				color0 = refinedColor0;
+				color1 = refinedColor1;
+				memcpy(indices, refinedIndices, sizeof(indices));
+			}
+		}
+
+		uint32_t packedIndices = 0;
+		for (uint32_t texel = 0; texel < 16; ++texel)
+		{
+			packedIndices |= static_cast<uint32_t>(indices[texel]) << (texel * 2);
+		}
+
+		output[0] = static_cast<uint8_t>(color0 & 0xff);
+		output[1] = static_cast<uint8_t>(color0 >> 8);
+		output[2] = static_cast<uint8_t>(color1 & 0xff);
+		output[3] = static_cast<uint8_t>(color1 >> 8);
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			output[4 + i] = static_cast<uint8_t>(packedIndices >> (i * 8));
+		}
+	}
+
+	void TextureCompressor::EncodeBC4(const Block& texels, uint32_t channel, uint8_t* output)
+	{
+		float minimum = texels[0][channel];
+		float maximum = texels[0][channel];
+		for (uint32_t texel = 1; texel < 16; ++texel)
+		{
+			minimum = std::min(minimum, texels[texel][channel]);
+			maximum = std::max(maximum, texels[texel][channel]);
+		}
+
+		// Eight value mode, endpoint 0 greater than endpoint 1; equal endpoints decode to a constant block
+		uint32_t value0 = static_cast<uint32_t>(std::lround(maximum));
+		uint32_t value1 = static_cast<uint32_t>(std::lround(minimum));
+		output[0] = static_cast<uint8_t>(value0);
+		output[1] = static_cast<uint8_t>(value1);
+
+		float palette[8] = { static_cast<float>(value0), static_cast<float>(value1) };
+		for (uint32_t entry = 2; entry < 8; ++entry)
+		{
+			palette[entry] = ((8 - entry) * static_cast<float>(value0) + (entry - 1) * static_cast<float>(value1)) / 7.0f;
+		}
+
+		uint64_t packedIndices = 0;
+		if (value0 != value1)
+		{
+			for (uint32_t texel = 0; texel < 16; ++texel)
+			{
+				uint64_t bestEntry = 0;
+				float bestDistance = FLT_MAX;
+				for (uint32_t entry = 0; entry < 8; ++entry)
+				{
+					float distance = std::abs(texels[texel][channel] - palette[entry]);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestEntry = entry;
+					}
+				}
+				packedIndices |= bestEntry << (texel * 3);
+			}
+		}
+
+		for (uint32_t i = 0; i < 6; ++i)
+		{
+			output[2 + i] = static_cast<uint8_t>(packedIndices >> (i * 8));
+		}
+	}
+
+	void TextureCompressor::EncodeBC7(const Block& texels, uint8_t* output)
+	{
+		// Mode 6: one subset, RGBA endpoints of 7 bits plus a unique p-bit each, 4 bit indices
+		struct Endpoints
+		{
+			uint32_t quantized[2][4];
+			uint32_t pBits[2];
+			uint8_t indices[16];
+		};
+
+		auto quantize = [](const float endpoint[4], uint32_t quantized[4], uint32_t& pBit)
+		{
+			float bestError = FLT_MAX;
+			for (uint32_t candidate = 0; candidate < 2; ++candidate)
+			{
+				uint32_t values[4];
+				float error = 0.0f;
+				for (uint32_t channel = 0; channel < 4; ++channel)
+				{
+					float value = std::clamp(endpoint[channel], 0.0f, 255.0f);
+					values[channel] = static_cast<uint32_t>(std::clamp(std::lround((value - candidate) / 2.0f), 0l, 127l));
+					float reconstructed = static_cast<float>((values[channel] << 1) | candidate);
+					error += (reconstructed - value) * (reconstructed - value);
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					pBit = candidate;
+					memcpy(quantized, values, sizeof(values));
+				}
+			}
+		};
+
+		auto encode = [&texels, &quantize](const float endpoint0[4], const float endpoint1[4], Endpoints& endpoints)
+		{
+			quantize(endpoint0, endpoints.quantized[0], endpoints.pBits[0]);
+			quantize(endpoint1, endpoints.quantized[1], endpoints.pBits[1]);
+
+			uint32_t colors[2][4];
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				colors[0][channel] = (endpoints.quantized[0][channel] << 1) | endpoints.pBits[0];
+				colors[1][channel] = (endpoints.quantized[1][channel] << 1) | endpoints.pBits[1];
+			}
+
+			float palette[16][4];
+			for (uint32_t entry = 0; entry < 16; ++entry)
+			{
+				for (uint32_t channel = 0; channel < 4; ++channel)
+				{
+					palette[entry][channel] = static_cast<float>(((64 - BC7Weights[entry]) * colors[0][channel] + BC7Weights[entry] * colors[1][channel] + 32) >> 6);
+				}
+			}
+
+			float error = 0.0f;
+			for (uint32_t texel = 0; texel < 16; ++texel)
+			{
+				float bestDistance = FLT_MAX;
+				for (uint8_t entry = 0; entry < 16; ++entry)
+				{
+					float distance = 0.0f;
+					for (uint32_t channel = 0; channel < 4; ++channel)
+					{
+						distance += (texels[texel][channel] - palette[entry][channel]) * (texels[texel][channel] - palette[entry][channel]);
+					}
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						endpoints.indices[texel] = entry;
+					}
+				}
+				error += bestDistance;
+			}
+			return error;
+		};
+
+		float endpoint0[4];
+		float endpoint1[4];
+		FitEndpoints(texels, 4, endpoint0, endpoint1);
+
+		Endpoints endpoints;
+		float error = encode(endpoint0, endpoint1, endpoints);
+
+		float weights[16];
+		for (uint32_t entry = 0; entry < 16; ++entry)
+		{
+			weights[entry] = BC7Weights[entry] / 64.0f;
+		}
+		float refined0[4];
+		float refined1[4];
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			refined0[channel] = static_cast<float>((endpoints.quantized[0][channel] << 1) | endpoints.pBits[0]);
+			refined1[channel] = static_cast<float>((endpoints.quantized[1][channel] << 1) | endpoints.pBits[1]);
+		}
+		RefineEndpoints(texels, 4, endpoints.indices, weights, refined0, refined1);
+
+		Endpoints refinedEndpoints;
+		if (encode(refined0, refined1, refinedEndpoints) < error)
+		{
+			endpoints = refinedEndpoints;
+		}
+
+		// Most significant index bit of first texel is implicitly 0, so flip block when it is set
+		if (endpoints.indices[0] & 8)
+		{
+			std::swap(endpoints.quantized[0], endpoints.quantized[1]);
+			std::swap(endpoints.pBits[0], endpoints.pBits[1]);
+			for (uint8_t& index : endpoints.indices)
+			{
+				index = static_cast<uint8_t>(15 - index);
+			}
+		}
+
+		memset(output, 0, 16);
+		uint32_t bitPosition = 0;
+		auto writeBits = [output, &bitPosition](uint32_t value, uint32_t bitCount)
+		{
+			for (uint32_t bit = 0; bit < bitCount; ++bit, ++bitPosition)
+			{
+				output[bitPosition / 8] |= static_cast<uint8_t>(((value >> bit) & 1) << (bitPosition % 8));
+			}
+		};
+
+		writeBits(1 << 6, 7);
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			writeBits(endpoints.quantized[0][channel], 7);
+			writeBits(endpoints.quantized[1][channel], 7);
+		}
+		writeBits(endpoints.pBits[0], 1);
+		writeBits(endpoints.pBits[1], 1);
+		writeBits(endpoints.indices[0], 3);
+		for (uint32_t texel = 1; texel < 16; ++texel)
+		{
+			writeBits(endpoints.indices[texel], 4);
+		}
+	}
+
+	void TextureCompressor::FitEndpoints(const Block& texels, uint32_t channels, float endpoint0[4], float endpoint1[4])
+	{
+		float mean[4] = {};
+		float minimum[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+		float maximum[4] = {};
+		for (uint32_t texel = 0; texel < 16; ++texel)
+		{
+			for (uint32_t channel = 0; channel < channels; ++channel)
+			{
+				mean[channel] += texels[texel][channel] / 16.0f;
+				minimum[channel] = std::min(minimum[channel], texels[texel][channel]);
+				maximum[channel] = std::max(maximum[channel], texels[texel][channel]);
+			}
+		}
+
+		float covariance[4][4] = {};
+		for (uint32_t texel = 0; texel < 16; ++texel)
+		{
+			for (uint32_t row = 0; row < channels; ++row)
+			{
+				for (uint32_t column = 0; column < channels; ++column)
+				{
+					covariance[row][column] += (texels[texel][row] - mean[row]) * (texels[texel][column] - mean[column]);
+				}
+			}
+		}
+
+		// Principal axis by power iteration, starting from bounding box diagonal
+		float axis[4] = {};
+		for (uint32_t channel = 0; channel < channels; ++channel)
+		{
+			axis[channel] = maximum[channel] - minimum[channel];
+		}
+		for (uint32_t iteration = 0; iteration < 8; ++iteration)
+		{
+			float next[4] = {};
+			float length = 0.0f;
+			for (uint32_t row = 0; row < channels; ++row)
+			{
+				for (uint32_t column = 0; column < channels; ++column)
+				{
+					next[row] += covariance[row][column] * axis[column];
+				}
+				length += next[row] * next[row];
+			}
+			if (length <= 0.0f)
+			{
+				break;
+			}
+			length = std::sqrt(length);
+			for (uint32_t channel = 0; channel < channels; ++channel)
+			{
+				axis[channel] = next[channel] / length;
+			}
+		}
+
+		float axisLength = 0.0f;
+		for (uint32_t channel = 0; channel < channels; ++channel)
+		{
+			axisLength += axis[channel] * axis[channel];
+		}
+		axisLength = std::sqrt(axisLength);
+
+		float projectionMinimum = 0.0f;
+		float projectionMaximum = 0.0f;
+		if (axisLength > 0.0f)
+		{
+			for (uint32_t channel = 0; channel < channels; ++channel)
+			{
+				axis[channel] /= axisLength;
+			}
+			for (uint32_t texel = 0; texel < 16; ++texel)
+			{
+				float projection = 0.0f;
+				for (uint32_t channel = 0; channel < channels; ++channel)
+				{
+					projection += (texels[texel][channel] - mean[channel]) * axis[channel];
+				}
+				projectionMinimum = std::min(projectionMinimum, projection);
+				projectionMaximum = std::max(projectionMaximum, projection);
+			}
+		}
+
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			endpoint0[channel] = channel < channels ? std::clamp(mean[channel] + axis[channel] * projectionMinimum, 0.0f, 255.0f) : 0.0f;
+			endpoint1[channel] = channel < channels ? std::clamp(mean[channel] + axis[channel] * projectionMaximum, 0.0f, 255.0f) : 0.0f;
+		}
+	}
+
+	void TextureCompressor::RefineEndpoints(const Block& texels, uint32_t channels, const uint8_t indices[16], const float* weights, float endpoint0[4], float endpoint1[4])
+	{
+		// Least squares endpoints for fixed indices: every texel is (1 - w) * endpoint0 + w * endpoint1
+		float a00 = 0.0f, a01 = 0.0f, a11 = 0.0f;
+		float b0[4] = {};
+		float b1[4] = {};
+		for (uint32_t texel = 0; texel < 16; ++texel)
+		{
+			float weight = weights[indices[texel]];
+			a00 += (1.0f - weight) * (1.0f - weight);
+			a01 += (1.0f - weight) * weight;
+			a11 += weight * weight;
+			for (uint32_t channel = 0; channel < channels; ++channel)
+			{
+				b0[channel] += (1.0f - weight) * texels[texel][channel];
+				b1[channel] += weight * texels[texel][channel];
+			}
+		}
+
+		float determinant = a00 * a11 - a01 * a01;
+		if (std::abs(determinant) < 1e-6f)
+		{
+			return;
+		}
+
+		for (uint32_t channel = 0; channel < channels; ++channel)
+		{
+			endpoint0[channel] = std::clamp((a11 * b0[channel] - a01 * b1[channel]) / determinant, 0.0f, 255.0f);
+			endpoint1[channel] = std::clamp((a00 * b1[channel] - a01 * b0[channel]) / determinant, 0.0f, 255.0f);
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <cstddef>
+#include "ThreadPool.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// CPU encoder of RGBA8 images into BCn blocks, meant for cook time rather than per frame use.
+	/// Supports BC1 ( opaque colour, 8 bytes per block ), BC3 ( colour + alpha ), BC4 & BC5 ( one & two channels,
+	/// e.g. masks & normal maps ) and BC7 ( colour + alpha, 16 bytes per block, encoded in mode 6 only ).
+	/// Endpoints are fit along principal axis of each block & refined by least squares over chosen indices.
+	/// </summary>
+	class TextureCompressor final
+	{
+	public:
+		/// <summary>Checks whether format is one encoder can write.</summary>
+		static bool IsSupported(VkFormat format);
+
+		/// <summary>Gets bytes of one 4x4 block of a supported format.</summary>
+		static uint32_t BlockSize(VkFormat format);
+
+		/// <summary>Gets bytes of a compressed image, partial blocks at edges counting as whole ones.</summary>
+		static size_t CompressedSize(VkFormat format, uint32_t width, uint32_t height);
+
+		/// <summary>Encodes image into blocks in row major order. Edge blocks repeat last row & column.</summary>
+		/// <param name="format">Supported format to encode into.</param>
+		/// <param name="pixels">width * height RGBA8 texels.</param>
+		/// <param name="width">Image width.</param>
+		/// <param name="height">Image height.</param>
+		/// <param name="threadPool">Pool rows of blocks are encoded on.</param>
+		/// <param name="blocks">Destination of CompressedSize() bytes.</param>
+		static void Compress(VkFormat format, const uint8_t* pixels, uint32_t width, uint32_t height, ThreadPool& threadPool, uint8_t* blocks);
+
+	private:
+		// Texels of one block as floats, RGBA
+		using Block = float[16][4];
+
+		static void EncodeBC1(const Block& texels, uint8_t* output);
+		static void EncodeBC4(const Block& texels, uint32_t channel, uint8_t* output);
+		static void EncodeBC7(const Block& texels, uint8_t* output);
+
+		static void FitEndpoints(const Block& texels, uint32_t channels, float endpoint0[4], float endpoint1[4]);
+		static void RefineEndpoints(const Block& texels, uint32_t channels, const uint8_t indices[16], const float* weights, float endpoint0[4], float endpoint1[4]);
+
+		static const uint32_t BC7Weights[16];
+	};
+}
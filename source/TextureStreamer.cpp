@@ -0,0 +1,413 @@
+#include "TextureStreamer.h"
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include "MipGenerator.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	void TextureStreamer::Initialize(VkDevice device, DeviceMemoryAllocator& allocator, UploadManager& uploadManager, VkDeviceSize budget, uint32_t tailExtent, uint32_t loadThreads)
+	{
+		mDevice = device;
+		mAllocator = &allocator;
+		mUploadManager = &uploadManager;
+		mBudget = budget;
+		mTailExtent = tailExtent;
+
+		// Two jobs per worker keeps workers busy while finished jobs wait for their uploads
+		mLoadPool = std::make_unique<ThreadPool>(loadThreads);
+		mMaxRunningJobs = mLoadPool->ThreadCount() * 2;
+
+		const uint8_t grey[4] = { 128, 128, 128, 255 };
+		mPlaceholder = CreateImage(VK_FORMAT_R8G8B8A8_UNORM, 1, 1, 1);
+		mUploadManager->UploadImage(grey, sizeof(grey), mPlaceholder.image, 1, 1);
+	}
+
+	void TextureStreamer::Shutdown()
+	{
+		// Destroying pool finishes queued jobs first, so none of them touches an image destroyed below
+		mLoadPool.reset();
+
+		for (std::unique_ptr<Job>& job : mJobs)
+		{
+			DestroyImage(job->image);
+		}
+		mJobs.clear();
+
+		for (RetiredImage& retired : mRetiredImages)
+		{
+			DestroyImage(retired.image);
+		}
+		mRetiredImages.clear();
+
+		for (Texture& texture : mTextures)
+		{
+			DestroyImage(texture.resident);
+		}
+		mTextures.clear();
+
+		DestroyImage(mPlaceholder);
+		mResidentBytes = 0;
+	}
+
+	TextureStreamer::TextureHandle TextureStreamer::Register(Loader loader)
+	{
+		Texture texture;
+		texture.loader = std::move(loader);
+		mTextures.push_back(std::move(texture));
+		return static_cast<TextureHandle>(mTextures.size() - 1);
+	}
+
+	void TextureStreamer::RequestResidency(TextureHandle texture, uint32_t finestLevel, float priority)
+	{
+		Texture& streamed = mTextures[texture];
+		if (streamed.mipLevels > 0)
+		{
+			finestLevel = std::min(finestLevel, streamed.mipLevels - 1);
+		}
+
+		// Several draws of one texture in a frame keep finest level & highest priority any of them asked for
+		bool firstRequestThisFrame = streamed.lastRequestedFrame != mFrame || streamed.requestedLevel == UINT32_MAX;
+		streamed.requestedLevel = firstRequestThisFrame ? finestLevel : std::min(streamed.requestedLevel, finestLevel);
+		streamed.priority = firstRequestThisFrame ? priority : std::max(streamed.priority, priority);
+		streamed.lastRequestedFrame = mFrame;
+	}
+
+	bool TextureStreamer::Update(uint32_t framesInFlight)
+	{
+		auto released = std::remove_if(mRetiredImages.begin(), mRetiredImages.end(), [this](RetiredImage& retired)
+		{
+			if (retired.releaseFrame > mFrame)
+			{
+				return false;
+			}
+			DestroyImage(retired.image);
+			return true;
+		});
+		mRetiredImages.erase(released, mRetiredImages.end());
+
+		bool viewsChanged = FinishJobs(framesInFlight);
+		EvictFor(0);
+		SharpenRequested();
+
+		++mFrame;
+		return viewsChanged;
+	}
+
+	VkImageView TextureStreamer::View(TextureHandle texture) const
+	{
+		const Texture& streamed = mTextures[texture];
+		return streamed.resident.view != VK_NULL_HANDLE ? streamed.resident.view : mPlaceholder.view;
+	}
+
+	uint32_t TextureStreamer::Width(TextureHandle texture) const
+	{
+		const Texture& streamed = mTextures[texture];
+		return streamed.source ? streamed.source->width : 0;
+	}
+
+	uint32_t TextureStreamer::Height(TextureHandle texture) const
+	{
+		const Texture& streamed = mTextures[texture];
+		return streamed.source ? streamed.source->height : 0;
+	}
+
+	uint32_t TextureStreamer::MipLevels(TextureHandle texture) const
+	{
+		return mTextures[texture].mipLevels;
+	}
+
+	uint32_t TextureStreamer::ResidentLevel(TextureHandle texture) const
+	{
+		const Texture& streamed = mTextures[texture];
+		return std::min(streamed.residentLevel, streamed.mipLevels);
+	}
+
+	VkDeviceSize TextureStreamer::ResidentBytes() const
+	{
+		return mResidentBytes;
+	}
+
+	void TextureStreamer::RunJob(Job& job)
+	{
+		if (!job.source)
+		{
+			job.source = std::make_shared<const SourceLevels>(job.loader());
+		}
+		const SourceLevels& source = *job.source;
+		if (source.levelData.empty() || source.levelData.size() != source.levelSizes.size())
+		{
+			throw std::runtime_error("texture loader returned no levels!");
+		}
+
+		// First job of a texture only knows which levels form its tail once texture is loaded
+		uint32_t mipLevels = static_cast<uint32_t>(source.levelData.size());
+		if (job.firstLevel >= mipLevels)
+		{
+			job.firstLevel = TailLevel(source);
+		}
+
+		uint32_t levelCount = mipLevels - job.firstLevel;
+		uint32_t width = MipGenerator::MipExtent(source.width, job.firstLevel);
+		uint32_t height = MipGenerator::MipExtent(source.height, job.firstLevel);
+		job.image = CreateImage(source.format, width, height, levelCount);
+
+		// Resident levels are copied largest first, which is how one multi-level upload reads them
+		UploadManager::StagingRegion staging = mUploadManager->ReserveStaging(ImageBytes(source, job.firstLevel));
+		uint8_t* destination = static_cast<uint8_t*>(staging.data);
+		for (uint32_t level = job.firstLevel; level < mipLevels; ++level)
+		{
+			memcpy(destination, source.levelData[level], source.levelSizes[level]);
+			destination += source.levelSizes[level];
+		}
+		job.ticket = mUploadManager->UploadImage(staging, job.image.image, width, height, levelCount, source.blockExtent);
+	}
+
+	void TextureStreamer::StartJob(TextureHandle texture, uint32_t firstLevel)
+	{
+		Texture& streamed = mTextures[texture];
+		streamed.jobRunning = true;
+
+		auto job = std::make_unique<Job>();
+		job->texture = texture;
+		job->firstLevel = firstLevel;
+		job->source = streamed.source;
+		if (!job->source)
+		{
+			job->loader = streamed.loader;
+		}
+
+		Job* runningJob = job.get();
+		job->done = mLoadPool->Enqueue([this, runningJob] { RunJob(*runningJob); });
+		mJobs.push_back(std::move(job));
+	}
+
+	bool TextureStreamer::FinishJobs(uint32_t framesInFlight)
+	{
+		bool viewsChanged = false;
+		for (size_t i = 0; i < mJobs.size();)
+		{
+			Job& job = *mJobs[i];
+			if (job.done.valid())
+			{
+				if (job.done.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				{
+					++i;
+					continue;
+				}
+				// Rethrows whatever loading or uploading threw on worker
+				job.done.get();
+			}
+			if (!mUploadManager->IsComplete(job.ticket))
+			{
+				++i;
+				continue;
+			}
+
+			Texture& streamed = mTextures[job.texture];
+			if (!streamed.source)
+			{
+				streamed.source = job.source;
+				streamed.mipLevels = static_cast<uint32_t>(job.source->levelData.size());
+				streamed.requestedLevel = std::min(streamed.requestedLevel, streamed.mipLevels - 1);
+			}
+
+			if (streamed.resident.image != VK_NULL_HANDLE)
+			{
+				mResidentBytes -= ImageBytes(*streamed.source, streamed.residentLevel);
+				Retire(streamed.resident, framesInFlight);
+			}
+			streamed.resident = job.image;
+			streamed.residentLevel = job.firstLevel;
+			streamed.jobRunning = false;
+			mResidentBytes += ImageBytes(*streamed.source, streamed.residentLevel);
+			viewsChanged = true;
+
+			mJobs.erase(mJobs.begin() + i);
+		}
+		return viewsChanged;
+	}
+
+	void TextureStreamer::EvictFor(VkDeviceSize bytesNeeded)
+	{
+		VkDeviceSize projectedBytes = ProjectedBytes();
+		while (projectedBytes + bytesNeeded > mBudget)
+		{
+			// Only levels nobody asked for this frame are evicted, least recently requested & lowest priority first.
+			// Tails are never evicted, so a texture always has something to sample.
+			Texture* victim = nullptr;
+			TextureHandle victimHandle = 0;
+			for (TextureHandle handle = 0; handle < mTextures.size(); ++handle)
+			{
+				Texture& candidate = mTextures[handle];
+				if (candidate.jobRunning || candidate.resident.image == VK_NULL_HANDLE || candidate.residentLevel >= TailLevel(*candidate.source))
+				{
+					continue;
+				}
+				bool unused = candidate.lastRequestedFrame != mFrame || candidate.residentLevel < candidate.requestedLevel;
+				if (!unused)
+				{
+					continue;
+				}
+				if (victim == nullptr || candidate.lastRequestedFrame < victim->lastRequestedFrame ||
+					(candidate.lastRequestedFrame == victim->lastRequestedFrame && candidate.priority < victim->priority))
+				{
+					victim = &candidate;
+					victimHandle = handle;
+				}
+			}
+
+			if (victim == nullptr)
+			{
+				return;
+			}
+
+			projectedBytes -= ImageBytes(*victim->source, victim->residentLevel) - ImageBytes(*victim->source, victim->residentLevel + 1);
+			StartJob(victimHandle, victim->residentLevel + 1);
+		}
+	}
+
+	void TextureStreamer::SharpenRequested()
+	{
+		std::vector<TextureHandle> waiting;
+		for (TextureHandle handle = 0; handle < mTextures.size(); ++handle)
+		{
+			const Texture& streamed = mTextures[handle];
+			if (!streamed.jobRunning && streamed.lastRequestedFrame == mFrame && streamed.requestedLevel < streamed.residentLevel)
+			{
+				waiting.push_back(handle);
+			}
+		}
+		std::sort(waiting.begin(), waiting.end(), [this](TextureHandle lhs, TextureHandle rhs) { return mTextures[lhs].priority > mTextures[rhs].priority; });
+
+		for (TextureHandle handle : waiting)
+		{
+			if (mJobs.size() >= mMaxRunningJobs)
+			{
+				return;
+			}
+
+			// Tails are small & needed before anything can be drawn, so they don't wait for budget
+			Texture& streamed = mTextures[handle];
+			if (streamed.resident.image == VK_NULL_HANDLE)
+			{
+				StartJob(handle, UINT32_MAX);
+				continue;
+			}
+
+			// One level at a time, so a texture sharpens progressively & each step's upload stays small
+			uint32_t nextLevel = streamed.residentLevel - 1;
+			VkDeviceSize growth = ImageBytes(*streamed.source, nextLevel) - ImageBytes(*streamed.source, streamed.residentLevel);
+			if (ProjectedBytes() + growth > mBudget)
+			{
+				// Texture is sharpened on a later frame, once evicted levels made room for it
+				EvictFor(growth);
+				continue;
+			}
+			StartJob(handle, nextLevel);
+		}
+	}
+
+	VkDeviceSize TextureStreamer::ProjectedBytes() const
+	{
+		// Resident bytes once every running job has been swapped in
+		VkDeviceSize projectedBytes = mResidentBytes;
+		for (const std::unique_ptr<Job>& job : mJobs)
+		{
+			const Texture& streamed = mTextures[job->texture];
+			if (streamed.resident.image == VK_NULL_HANDLE)
+			{
+				continue;
+			}
+			projectedBytes -= ImageBytes(*streamed.source, streamed.residentLevel);
+			projectedBytes += ImageBytes(*streamed.source, job->firstLevel);
+		}
+		return projectedBytes;
+	}
+
+	uint32_t TextureStreamer::TailLevel(const SourceLevels& source) const
+	{
+		uint32_t mipLevels = static_cast<uint32_t>(source.levelData.size());
+		uint32_t level = 0;
+		while (level + 1 < mipLevels && std::max(MipGenerator::MipExtent(source.width, level), MipGenerator::MipExtent(source.height, level)) > mTailExtent)
+		{
+			++level;
+		}
+		return level;
+	}
+
+	VkDeviceSize TextureStreamer::ImageBytes(const SourceLevels& source, uint32_t firstLevel) const
+	{
+		VkDeviceSize bytes = 0;
+		for (size_t level = firstLevel; level < source.levelSizes.size(); ++level)
+		{
+			bytes += source.levelSizes[level];
+		}
+		return bytes;
+	}
+
+	TextureStreamer::Image TextureStreamer::CreateImage(VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels)
+	{
+		VkImageCreateInfo imageInfo = {};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent.width = width;
+		imageInfo.extent.height = height;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = mipLevels;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = format;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		Image image;
+		if (vkCreateImage(mDevice, &imageInfo, nullptr, &image.image) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create streamed texture image!");
+		}
+		image.allocation = mAllocator->AllocateForImage(image.image, VK_IMAGE_TILING_OPTIMAL, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = mipLevels;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(mDevice, &viewInfo, nullptr, &image.view) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create streamed texture image view!");
+		}
+		return image;
+	}
+
+	void TextureStreamer::DestroyImage(Image& image)
+	{
+		if (image.image == VK_NULL_HANDLE)
+		{
+			return;
+		}
+		vkDestroyImageView(mDevice, image.view, nullptr);
+		vkDestroyImage(mDevice, image.image, nullptr);
+		mAllocator->Free(image.allocation);
+		image = Image();
+	}
+
+	void TextureStreamer::Retire(Image& image, uint32_t framesInFlight)
+	{
+		// Frames recorded before swap may still sample image until each of them has been waited for once more
+		RetiredImage retired;
+		retired.image = image;
+		retired.releaseFrame = mFrame + framesInFlight;
+		mRetiredImages.push_back(retired);
+		image = Image();
+	}
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <future>
+#include <functional>
+#include "DeviceMemoryAllocator.h"
+#include "UploadManager.h"
+#include "ThreadPool.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Streams textures in the background, coarsest levels first. Each texture is decoded once on a load worker & kept in
+	/// system memory; its image then only holds resident levels [first, mipLevels) & is rebuilt one level finer at a time,
+	/// finest requested level & highest priority first. When resident images exceed the budget, least recently requested
+	/// textures drop their finest level. Rebuilt images are uploaded from workers & swapped in once upload completes,
+	/// while old image stays alive until frames in flight are done sampling it.
+	/// Apart from load jobs, every method must be called from the thread which submits frames.
+	/// </summary>
+	class TextureStreamer final
+	{
+	public:
+		using TextureHandle = uint32_t;
+
+		/// <summary>Every level of a texture in system memory, largest first, so any range of them can be uploaded again.</summary>
+		struct SourceLevels
+		{
+			VkFormat format = VK_FORMAT_UNDEFINED;
+			uint32_t width = 0;
+			uint32_t height = 0;
+			// Width & height of a texel block, 4 for block compressed formats
+			uint32_t blockExtent = 1;
+			std::vector<const uint8_t*> levelData;
+			std::vector<size_t> levelSizes;
+			// Keeps whatever levelData points into alive, e.g. a mapped KTX2 file or decoded levels
+			std::shared_ptr<const void> storage;
+		};
+
+		/// <summary>Produces levels of a texture. Runs once, on a load worker.</summary>
+		using Loader = std::function<SourceLevels()>;
+
+		TextureStreamer() = default;
+		TextureStreamer(const TextureStreamer&) = delete;
+		TextureStreamer& operator=(const TextureStreamer&) = delete;
+		TextureStreamer(TextureStreamer&&) = delete;
+		TextureStreamer& operator=(TextureStreamer&&) = delete;
+		~TextureStreamer() = default;
+
+		/// <summary>Starts load workers & uploads placeholder sampled until a texture's first levels are resident.</summary>
+		/// <param name="device">Logical device.</param>
+		/// <param name="allocator">Allocator image memory is taken from.</param>
+		/// <param name="uploadManager">Upload manager levels are copied through.</param>
+		/// <param name="budget">Bytes resident images may occupy before least recently requested ones lose levels.</param>
+		/// <param name="tailExtent">Largest level made resident by a texture's first upload. Smaller levels are never evicted.</param>
+		/// <param name="loadThreads">Number of load workers.</param>
+		void Initialize(VkDevice device, DeviceMemoryAllocator& allocator, UploadManager& uploadManager, VkDeviceSize budget, uint32_t tailExtent, uint32_t loadThreads);
+
+		/// <summary>Waits for running load jobs & destroys every image. GPU must be done sampling them.</summary>
+		void Shutdown();
+
+		/// <summary>Adds a texture. Nothing is loaded until its residency is first requested.</summary>
+		/// <param name="loader">Loader producing levels of texture.</param>
+		/// <returns>Handle of texture.</returns>
+		TextureHandle Register(Loader loader);
+
+		/// <summary>Asks for texture to be sharpened down to a level. Call every frame texture is drawn.</summary>
+		/// <param name="texture">Handle of texture.</param>
+		/// <param name="finestLevel">Finest level worth having, e.g. from projected screen size.</param>
+		/// <param name="priority">Priority among textures waiting for levels, e.g. projected screen area.</param>
+		void RequestResidency(TextureHandle texture, uint32_t finestLevel, float priority);
+
+		/// <summary>
+		/// Swaps in images whose upload completed, destroys images frames in flight no longer sample, evicts levels over budget
+		/// & starts load jobs for textures waiting for finer levels. Call once per frame, after waiting for frame's fence.
+		/// </summary>
+		/// <param name="framesInFlight">Number of frames which may still be sampling an image swapped out this frame.</param>
+		/// <returns>True if view of any texture changed, so descriptors referencing it must be rewritten.</returns>
+		bool Update(uint32_t framesInFlight);
+
+		/// <summary>Gets view of resident levels, or of placeholder while none are resident.</summary>
+		VkImageView View(TextureHandle texture) const;
+
+		/// <summary>Gets size of level 0, 0 until texture has been loaded.</summary>
+		uint32_t Width(TextureHandle texture) const;
+		uint32_t Height(TextureHandle texture) const;
+
+		/// <summary>Gets number of levels texture has, 0 until texture has been loaded.</summary>
+		uint32_t MipLevels(TextureHandle texture) const;
+
+		/// <summary>Gets finest resident level, or MipLevels() while none are resident.</summary>
+		uint32_t ResidentLevel(TextureHandle texture) const;
+
+		/// <summary>Gets bytes held by resident images.</summary>
+		VkDeviceSize ResidentBytes() const;
+
+	private:
+		struct Image
+		{
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView view = VK_NULL_HANDLE;
+			DeviceMemoryAllocator::Allocation allocation;
+		};
+
+		struct Texture
+		{
+			Loader loader;
+			std::shared_ptr<const SourceLevels> source;
+			uint32_t mipLevels = 0;
+
+			// Image holding levels [residentLevel, mipLevels)
+			Image resident;
+			uint32_t residentLevel = UINT32_MAX;
+
+			uint32_t requestedLevel = UINT32_MAX;
+			float priority = 0.0f;
+			uint64_t lastRequestedFrame = 0;
+			bool jobRunning = false;
+		};
+
+		// Rebuild of a texture's image with levels [firstLevel, mipLevels), loading texture first if needed
+		struct Job
+		{
+			TextureHandle texture = 0;
+			uint32_t firstLevel = 0;
+			Loader loader;
+			std::shared_ptr<const SourceLevels> source;
+			Image image;
+			UploadManager::Ticket ticket = 0;
+			std::future<void> done;
+		};
+
+		struct RetiredImage
+		{
+			Image image;
+			uint64_t releaseFrame = 0;
+		};
+
+		void RunJob(Job& job);
+		void StartJob(TextureHandle texture, uint32_t firstLevel);
+		bool FinishJobs(uint32_t framesInFlight);
+		void EvictFor(VkDeviceSize bytesNeeded);
+		void SharpenRequested();
+		VkDeviceSize ProjectedBytes() const;
+		uint32_t TailLevel(const SourceLevels& source) const;
+		VkDeviceSize ImageBytes(const SourceLevels& source, uint32_t firstLevel) const;
+		Image CreateImage(VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels);
+		void DestroyImage(Image& image);
+		void Retire(Image& image, uint32_t framesInFlight);
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		DeviceMemoryAllocator* mAllocator = nullptr;
+		UploadManager* mUploadManager = nullptr;
+		VkDeviceSize mBudget = 0;
+		uint32_t mTailExtent = 0;
+		uint32_t mMaxRunningJobs = 0;
+
+		std::unique_ptr<ThreadPool> mLoadPool;
+		std::vector<Texture> mTextures;
+		std::vector<std::unique_ptr<Job>> mJobs;
+		std::vector<RetiredImage> mRetiredImages;
+		Image mPlaceholder;
+
+		VkDeviceSize mResidentBytes = 0;
+		uint64_t mFrame = 0;
+	};
+}
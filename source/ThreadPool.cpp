@@ -0,0 +1,91 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace AlphonsoGraphicsEngine
+{
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+		{
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			threadCount = std::max(hardwareThreads, 2u) - 1;
+		}
+
+		mWorkers.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; ++i)
+		{
+			mWorkers.emplace_back(&ThreadPool::WorkerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStopping = true;
+		}
+		mCondition.notify_all();
+
+		for (std::thread& worker : mWorkers)
+		{
+			worker.join();
+		}
+	}
+
+	std::future<void> ThreadPool::Enqueue(std::function<void()> task)
+	{
+		std::packaged_task<void()> packagedTask(std::move(task));
+		std::future<void> future = packagedTask.get_future();
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mTasks.push(std::move(packagedTask));
+		}
+		mCondition.notify_one();
+
+		return future;
+	}
+
+	void ThreadPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& task)
+	{
+		std::vector<std::future<void>> futures;
+		futures.reserve(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			futures.push_back(Enqueue([&task, i] { task(i); }));
+		}
+
+		// Every task must be done before rethrowing, since they may reference caller's stack
+		for (std::future<void>& future : futures)
+		{
+			future.wait();
+		}
+		for (std::future<void>& future : futures)
+		{
+			future.get();
+		}
+	}
+
+	uint32_t ThreadPool::ThreadCount() const
+	{
+		return static_cast<uint32_t>(mWorkers.size());
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		for (;;)
+		{
+			std::packaged_task<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mCondition.wait(lock, [this] { return mStopping || !mTasks.empty(); });
+				if (mStopping && mTasks.empty())
+				{
+					return;
+				}
+				task = std::move(mTasks.front());
+				mTasks.pop();
+			}
+			task();
+		}
+	}
+}
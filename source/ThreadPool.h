@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Fixed set of worker threads pulling tasks from a shared queue.
+	/// </summary>
+	class ThreadPool final
+	{
+	public:
+		/// <summary>Starts worker threads.</summary>
+		/// <param name="threadCount">Number of workers. Zero picks one less than hardware thread count ( at least one ).</param>
+		explicit ThreadPool(uint32_t threadCount = 0);
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) = delete;
+		ThreadPool& operator=(ThreadPool&&) = delete;
+
+		/// <summary>Finishes queued tasks & joins worker threads.</summary>
+		~ThreadPool();
+
+		/// <summary>Queues a task for execution on a worker thread.</summary>
+		/// <param name="task">Task to run.</param>
+		/// <returns>Future which becomes ready once task finishes & rethrows any exception it threw.</returns>
+		std::future<void> Enqueue(std::function<void()> task);
+
+		/// <summary>Runs task once for every index in [0, count) on worker threads & waits for all of them.
+		/// Must not be called from a worker thread, which could wait on tasks queued behind itself.</summary>
+		/// <param name="count">Number of invocations.</param>
+		/// <param name="task">Task receiving its index.</param>
+		void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& task);
+
+		uint32_t ThreadCount() const;
+
+	private:
+		void WorkerLoop();
+
+		std::vector<std::thread> mWorkers;
+		std::queue<std::packaged_task<void()>> mTasks;
+		std::mutex mMutex;
+		std::condition_variable mCondition;
+		bool mStopping = false;
+	};
+}
@@ -0,0 +1,64 @@
+#include "UniformRingBuffer.h"
+#include <stdexcept>
+#include <cstring>
+
+namespace AlphonsoGraphicsEngine
+{
+	void UniformRingBuffer::Initialize(VkDevice device, DeviceMemoryAllocator& allocator, VkBuffer buffer, const DeviceMemoryAllocator::Allocation& allocation, VkDeviceSize regionSize, uint32_t regionCount, VkDeviceSize alignment)
+	{
+		mDevice = device;
+		mAllocator = &allocator;
+		mBuffer = buffer;
+		mAllocation = allocation;
+		mRegionSize = regionSize;
+		mRegionCount = regionCount;
+		mAlignment = alignment > 0 ? alignment : 1;
+
+		if (mAllocation.mappedData == nullptr)
+		{
+			throw std::runtime_error("failed to map uniform ring buffer!");
+		}
+		mMappedData = static_cast<uint8_t*>(mAllocation.mappedData);
+
+		BeginFrame(0);
+	}
+
+	void UniformRingBuffer::Shutdown()
+	{
+		mMappedData = nullptr;
+		vkDestroyBuffer(mDevice, mBuffer, nullptr);
+		mAllocator->Free(mAllocation);
+		mBuffer = VK_NULL_HANDLE;
+	}
+
+	void UniformRingBuffer::BeginFrame(uint32_t regionIndex)
+	{
+		mRegionBegin = mRegionSize * (regionIndex % mRegionCount);
+		mHead = mRegionBegin;
+	}
+
+	uint32_t UniformRingBuffer::Allocate(const void* data, VkDeviceSize size)
+	{
+		VkDeviceSize offset = AlignUp(mHead, mAlignment);
+		if (offset + size > mRegionBegin + mRegionSize)
+		{
+			throw std::runtime_error("uniform ring buffer frame region exhausted!");
+		}
+
+		// Memory is host coherent, so no flush is needed before submit.
+		memcpy(mMappedData + offset, data, static_cast<size_t>(size));
+		mHead = offset + size;
+
+		return static_cast<uint32_t>(offset);
+	}
+
+	VkBuffer UniformRingBuffer::Buffer() const
+	{
+		return mBuffer;
+	}
+
+	VkDeviceSize UniformRingBuffer::AlignUp(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		return (size + alignment - 1) / alignment * alignment;
+	}
+}
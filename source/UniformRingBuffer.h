@@ -0,0 +1,70 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include "DeviceMemoryAllocator.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Linear per-frame allocator over one persistently mapped, host coherent uniform buffer.
+	/// Buffer is split into one region per frame in flight & every frame bump allocates from its own region,
+	/// so slices are bound with dynamic offsets instead of mapping a separate allocation per uniform block.
+	/// </summary>
+	class UniformRingBuffer final
+	{
+	public:
+		UniformRingBuffer() = default;
+		UniformRingBuffer(const UniformRingBuffer&) = delete;
+		UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+		UniformRingBuffer(UniformRingBuffer&&) = delete;
+		UniformRingBuffer& operator=(UniformRingBuffer&&) = delete;
+		~UniformRingBuffer() = default;
+
+		/// <summary>Takes ownership of a buffer bound to host visible & coherent memory, which allocator keeps mapped.</summary>
+		/// <param name="device">Logical device owning buffer.</param>
+		/// <param name="allocator">Allocator memory was taken from.</param>
+		/// <param name="buffer">Uniform buffer of at least regionSize * regionCount bytes.</param>
+		/// <param name="allocation">Mapped allocation bound to buffer.</param>
+		/// <param name="regionSize">Bytes available to a single frame. Must be a multiple of alignment.</param>
+		/// <param name="regionCount">Number of frame regions.</param>
+		/// <param name="alignment">Device minUniformBufferOffsetAlignment.</param>
+		void Initialize(VkDevice device, DeviceMemoryAllocator& allocator, VkBuffer buffer, const DeviceMemoryAllocator::Allocation& allocation, VkDeviceSize regionSize, uint32_t regionCount, VkDeviceSize alignment);
+
+		/// <summary>Destroys buffer & returns its memory to allocator.</summary>
+		void Shutdown();
+
+		/// <summary>Rewinds allocation head to start of region belonging to given frame.</summary>
+		/// <param name="regionIndex">Index of frame in flight. GPU must be done reading this region.</param>
+		void BeginFrame(uint32_t regionIndex);
+
+		/// <summary>Copies data into next aligned slice of current frame region.</summary>
+		/// <param name="data">Pointer to data to copy.</param>
+		/// <param name="size">Size of data in bytes.</param>
+		/// <returns>Offset of slice from start of buffer, to be used as dynamic offset.</returns>
+		uint32_t Allocate(const void* data, VkDeviceSize size);
+
+		template <typename T>
+		uint32_t Push(const T& value)
+		{
+			return Allocate(&value, sizeof(T));
+		}
+
+		VkBuffer Buffer() const;
+
+		static VkDeviceSize AlignUp(VkDeviceSize size, VkDeviceSize alignment);
+
+	private:
+		VkDevice mDevice = VK_NULL_HANDLE;
+		VkBuffer mBuffer = VK_NULL_HANDLE;
+		DeviceMemoryAllocator* mAllocator = nullptr;
+		DeviceMemoryAllocator::Allocation mAllocation;
+		uint8_t* mMappedData = nullptr;
+
+		VkDeviceSize mRegionSize = 0;
+		uint32_t mRegionCount = 0;
+		VkDeviceSize mAlignment = 1;
+
+		VkDeviceSize mRegionBegin = 0;
+		VkDeviceSize mHead = 0;
+	};
+}
@@ -0,0 +1,526 @@
+#include "UploadManager.h"
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+namespace AlphonsoGraphicsEngine
+{
+	void UploadManager::Initialize(VkDevice device, DeviceMemoryAllocator& allocator, uint32_t transferFamily, VkQueue transferQueue, uint32_t graphicsFamily, VkQueue graphicsQueue,
+		VkDeviceSize stagingCapacity, VkDeviceSize frameBudget)
+	{
+		mDevice = device;
+		mAllocator = &allocator;
+		mTransferFamily = transferFamily;
+		mTransferQueue = transferQueue;
+		mGraphicsFamily = graphicsFamily;
+		mGraphicsQueue = graphicsQueue;
+		mFrameBudget = frameBudget;
+
+		mStagingHeap.Initialize(device, allocator, stagingCapacity);
+	}
+
+	void UploadManager::Shutdown()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		for (Batch& batch : mSubmittedBatches)
+		{
+			vkWaitForFences(mDevice, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+			DestroyBatch(batch);
+		}
+		mSubmittedBatches.clear();
+
+		for (Batch& batch : mFreeBatches)
+		{
+			DestroyBatch(batch);
+		}
+		mFreeBatches.clear();
+
+		for (PendingUpload& upload : mPendingUploads)
+		{
+			ReleaseStaging(upload.staging);
+		}
+		mPendingUploads.clear();
+
+		mStagingHeap.Shutdown();
+	}
+
+	UploadManager::StagingRegion UploadManager::ReserveStaging(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		StagingRegion staging;
+		staging.size = size;
+
+		// Reclaim space of finished batches before giving up on ring
+		bool reserved = mStagingHeap.TryReserve(size, alignment, staging.ringRegion);
+		if (!reserved)
+		{
+			CollectLocked();
+			reserved = mStagingHeap.TryReserve(size, alignment, staging.ringRegion);
+		}
+
+		if (reserved)
+		{
+			staging.inRing = true;
+			staging.buffer = mStagingHeap.Buffer();
+			staging.offset = staging.ringRegion.offset;
+			staging.data = staging.ringRegion.data;
+			return staging;
+		}
+
+		// Ring is full or upload is bigger than ring, fall back to a one-off staging buffer
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (vkCreateBuffer(mDevice, &bufferInfo, nullptr, &staging.buffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create staging buffer!");
+		}
+		staging.fallbackAllocation = mAllocator->AllocateForBuffer(staging.buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		staging.data = staging.fallbackAllocation.mappedData;
+		return staging;
+	}
+
+	UploadManager::Ticket UploadManager::UploadBuffer(const StagingRegion& staging, VkBuffer buffer, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, VkDeviceSize dstOffset)
+	{
+		PendingUpload upload;
+		upload.staging = staging;
+		upload.buffer = buffer;
+		upload.bufferOffset = dstOffset;
+		upload.dstStage = dstStage;
+		upload.dstAccess = dstAccess;
+		return Enqueue(std::move(upload));
+	}
+
+	UploadManager::Ticket UploadManager::UploadBuffer(const void* data, VkDeviceSize size, VkBuffer buffer, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, VkDeviceSize dstOffset)
+	{
+		StagingRegion staging = ReserveStaging(size);
+		memcpy(staging.data, data, static_cast<size_t>(size));
+		return UploadBuffer(staging, buffer, dstStage, dstAccess, dstOffset);
+	}
+
+	UploadManager::Ticket UploadManager::UploadImage(const StagingRegion& staging, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels, uint32_t blockExtent, VkImageLayout finalLayout, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+	{
+		PendingUpload upload;
+		upload.staging = staging;
+		upload.image = image;
+		upload.width = width;
+		upload.height = height;
+		upload.mipLevels = mipLevels;
+		upload.blockExtent = blockExtent;
+		upload.finalLayout = finalLayout;
+		upload.dstStage = dstStage;
+		upload.dstAccess = dstAccess;
+		return Enqueue(std::move(upload));
+	}
+
+	UploadManager::Ticket UploadManager::UploadImage(const void* data, VkDeviceSize size, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels, uint32_t blockExtent, VkImageLayout finalLayout, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+	{
+		StagingRegion staging = ReserveStaging(size);
+		memcpy(staging.data, data, static_cast<size_t>(size));
+		return UploadImage(staging, image, width, height, mipLevels, blockExtent, finalLayout, dstStage, dstAccess);
+	}
+
+	void UploadManager::BeginFrame()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		CollectLocked();
+		mBytesThisFrame = 0;
+	}
+
+	UploadManager::Ticket UploadManager::Flush(bool ignoreBudget)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return FlushLocked(ignoreBudget);
+	}
+
+	bool UploadManager::IsComplete(Ticket ticket)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		CollectLocked();
+		return ticket <= mLastCompletedTicket;
+	}
+
+	void UploadManager::Wait(Ticket ticket)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		if (ticket > mLastSubmittedTicket)
+		{
+			FlushLocked(true);
+		}
+
+		// Every batch's fence is signalled on same queue, so they complete in submission order
+		for (Batch& batch : mSubmittedBatches)
+		{
+			vkWaitForFences(mDevice, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+			if (batch.ticket >= ticket)
+			{
+				break;
+			}
+		}
+		CollectLocked();
+	}
+
+	bool UploadManager::HasDedicatedTransferQueue() const
+	{
+		return mTransferFamily != mGraphicsFamily;
+	}
+
+	VkDeviceSize UploadManager::BytesUploadedThisFrame() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mBytesThisFrame;
+	}
+
+	UploadManager::Ticket UploadManager::Enqueue(PendingUpload&& upload)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		upload.ticket = ++mLastQueuedTicket;
+		mPendingUploads.push_back(std::move(upload));
+		return mLastQueuedTicket;
+	}
+
+	UploadManager::Ticket UploadManager::FlushLocked(bool ignoreBudget)
+	{
+		auto fitsBudget = [this, ignoreBudget](const PendingUpload& upload)
+		{
+			return ignoreBudget || mFrameBudget == 0 || mBytesThisFrame == 0 || mBytesThisFrame + upload.staging.size <= mFrameBudget;
+		};
+
+		if (mPendingUploads.empty() || !fitsBudget(mPendingUploads.front()))
+		{
+			return mLastSubmittedTicket;
+		}
+
+		Batch batch = AcquireBatch();
+		while (!mPendingUploads.empty() && fitsBudget(mPendingUploads.front()))
+		{
+			PendingUpload& upload = mPendingUploads.front();
+			if (upload.image != VK_NULL_HANDLE)
+			{
+				RecordImageUpload(batch, upload);
+			}
+			else
+			{
+				RecordBufferUpload(batch, upload);
+			}
+
+			mBytesThisFrame += upload.staging.size;
+			batch.stagingRegions.push_back(upload.staging);
+			batch.ticket = upload.ticket;
+			mPendingUploads.pop_front();
+		}
+
+		if (vkEndCommandBuffer(batch.transferCommandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to record upload command buffer!");
+		}
+
+		VkSubmitInfo transferSubmitInfo = {};
+		transferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		transferSubmitInfo.commandBufferCount = 1;
+		transferSubmitInfo.pCommandBuffers = &batch.transferCommandBuffer;
+
+		if (HasDedicatedTransferQueue())
+		{
+			transferSubmitInfo.signalSemaphoreCount = 1;
+			transferSubmitInfo.pSignalSemaphores = &batch.transferCompleteSemaphore;
+			if (vkQueueSubmit(mTransferQueue, 1, &transferSubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to submit upload batch!");
+			}
+
+			// Acquire half of ownership transfer. Graphics work submitted after it is ordered behind these barriers.
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			vkBeginCommandBuffer(batch.acquireCommandBuffer, &beginInfo);
+			vkCmdPipelineBarrier(batch.acquireCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, batch.acquireStages, 0,
+				0, nullptr,
+				static_cast<uint32_t>(batch.acquireBufferBarriers.size()), batch.acquireBufferBarriers.data(),
+				static_cast<uint32_t>(batch.acquireImageBarriers.size()), batch.acquireImageBarriers.data());
+			if (vkEndCommandBuffer(batch.acquireCommandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to record upload acquire command buffer!");
+			}
+
+			VkSubmitInfo acquireSubmitInfo = {};
+			acquireSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			acquireSubmitInfo.waitSemaphoreCount = 1;
+			acquireSubmitInfo.pWaitSemaphores = &batch.transferCompleteSemaphore;
+			acquireSubmitInfo.pWaitDstStageMask = &batch.acquireStages;
+			acquireSubmitInfo.commandBufferCount = 1;
+			acquireSubmitInfo.pCommandBuffers = &batch.acquireCommandBuffer;
+			if (vkQueueSubmit(mGraphicsQueue, 1, &acquireSubmitInfo, batch.fence) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to submit upload acquire batch!");
+			}
+		}
+		else
+		{
+			if (vkQueueSubmit(mTransferQueue, 1, &transferSubmitInfo, batch.fence) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to submit upload batch!");
+			}
+		}
+
+		mLastSubmittedTicket = batch.ticket;
+		mSubmittedBatches.push_back(std::move(batch));
+		return mLastSubmittedTicket;
+	}
+
+	void UploadManager::RecordBufferUpload(Batch& batch, const PendingUpload& upload)
+	{
+		VkBufferCopy copyRegion = {};
+		copyRegion.srcOffset = upload.staging.offset;
+		copyRegion.dstOffset = upload.bufferOffset;
+		copyRegion.size = upload.staging.size;
+		vkCmdCopyBuffer(batch.transferCommandBuffer, upload.staging.buffer, upload.buffer, 1, &copyRegion);
+
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.buffer = upload.buffer;
+		barrier.offset = upload.bufferOffset;
+		barrier.size = upload.staging.size;
+
+		if (HasDedicatedTransferQueue())
+		{
+			// Release half of queue family ownership transfer, acquired on graphics queue by Flush()
+			barrier.dstAccessMask = 0;
+			barrier.srcQueueFamilyIndex = mTransferFamily;
+			barrier.dstQueueFamilyIndex = mGraphicsFamily;
+			vkCmdPipelineBarrier(batch.transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = upload.dstAccess;
+			batch.acquireBufferBarriers.push_back(barrier);
+			batch.acquireStages |= upload.dstStage;
+		}
+		else
+		{
+			barrier.dstAccessMask = upload.dstAccess;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			vkCmdPipelineBarrier(batch.transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, upload.dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+		}
+	}
+
+	void UploadManager::RecordImageUpload(Batch& batch, const PendingUpload& upload)
+	{
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = upload.image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = upload.mipLevels;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		vkCmdPipelineBarrier(batch.transferCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		// Levels smaller than a block still take a whole one
+		auto levelBlocks = [&upload](uint32_t level)
+		{
+			VkDeviceSize blocksX = (std::max(upload.width >> level, 1u) + upload.blockExtent - 1) / upload.blockExtent;
+			VkDeviceSize blocksY = (std::max(upload.height >> level, 1u) + upload.blockExtent - 1) / upload.blockExtent;
+			return blocksX * blocksY;
+		};
+
+		VkDeviceSize chainBlocks = 0;
+		for (uint32_t level = 0; level < upload.mipLevels; ++level)
+		{
+			chainBlocks += levelBlocks(level);
+		}
+		VkDeviceSize blockSize = upload.staging.size / chainBlocks;
+
+		// One copy per level, all recorded together so they overlap on GPU
+		std::vector<VkBufferImageCopy> regions(upload.mipLevels);
+		VkDeviceSize levelOffset = upload.staging.offset;
+		for (uint32_t level = 0; level < upload.mipLevels; ++level)
+		{
+			VkBufferImageCopy& region = regions[level];
+			region.bufferOffset = levelOffset;
+			region.bufferRowLength = 0;
+			region.bufferImageHeight = 0;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = level;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset = { 0, 0, 0 };
+			region.imageExtent = { std::max(upload.width >> level, 1u), std::max(upload.height >> level, 1u), 1 };
+			levelOffset += levelBlocks(level) * blockSize;
+		}
+		vkCmdCopyBufferToImage(batch.transferCommandBuffer, upload.staging.buffer, upload.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = upload.finalLayout;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		if (HasDedicatedTransferQueue())
+		{
+			// Release half of queue family ownership transfer. Layout transition is part of both halves.
+			barrier.dstAccessMask = 0;
+			barrier.srcQueueFamilyIndex = mTransferFamily;
+			barrier.dstQueueFamilyIndex = mGraphicsFamily;
+			vkCmdPipelineBarrier(batch.transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = upload.dstAccess;
+			batch.acquireImageBarriers.push_back(barrier);
+			batch.acquireStages |= upload.dstStage;
+		}
+		else
+		{
+			barrier.dstAccessMask = upload.dstAccess;
+			vkCmdPipelineBarrier(batch.transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, upload.dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+	}
+
+	UploadManager::Batch UploadManager::AcquireBatch()
+	{
+		Batch batch;
+		if (mFreeBatches.empty())
+		{
+			batch = CreateBatch();
+		}
+		else
+		{
+			batch = std::move(mFreeBatches.back());
+			mFreeBatches.pop_back();
+		}
+
+		batch.stagingRegions.clear();
+		batch.acquireBufferBarriers.clear();
+		batch.acquireImageBarriers.clear();
+		batch.acquireStages = 0;
+
+		vkResetCommandPool(mDevice, batch.transferCommandPool, 0);
+		if (batch.acquireCommandPool != VK_NULL_HANDLE)
+		{
+			vkResetCommandPool(mDevice, batch.acquireCommandPool, 0);
+		}
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		if (vkBeginCommandBuffer(batch.transferCommandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to begin recording upload command buffer!");
+		}
+
+		return batch;
+	}
+
+	UploadManager::Batch UploadManager::CreateBatch()
+	{
+		Batch batch;
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+
+		poolInfo.queueFamilyIndex = mTransferFamily;
+		if (vkCreateCommandPool(mDevice, &poolInfo, nullptr, &batch.transferCommandPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create upload command pool!");
+		}
+		allocInfo.commandPool = batch.transferCommandPool;
+		if (vkAllocateCommandBuffers(mDevice, &allocInfo, &batch.transferCommandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate upload command buffer!");
+		}
+
+		if (HasDedicatedTransferQueue())
+		{
+			poolInfo.queueFamilyIndex = mGraphicsFamily;
+			if (vkCreateCommandPool(mDevice, &poolInfo, nullptr, &batch.acquireCommandPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create upload acquire command pool!");
+			}
+			allocInfo.commandPool = batch.acquireCommandPool;
+			if (vkAllocateCommandBuffers(mDevice, &allocInfo, &batch.acquireCommandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to allocate upload acquire command buffer!");
+			}
+
+			VkSemaphoreCreateInfo semaphoreInfo = {};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			if (vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &batch.transferCompleteSemaphore) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create upload semaphore!");
+			}
+		}
+
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		if (vkCreateFence(mDevice, &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create upload fence!");
+		}
+
+		return batch;
+	}
+
+	void UploadManager::DestroyBatch(Batch& batch)
+	{
+		for (StagingRegion& staging : batch.stagingRegions)
+		{
+			ReleaseStaging(staging);
+		}
+
+		// Destroying pools frees their command buffers
+		vkDestroyCommandPool(mDevice, batch.transferCommandPool, nullptr);
+		vkDestroyCommandPool(mDevice, batch.acquireCommandPool, nullptr);
+		vkDestroySemaphore(mDevice, batch.transferCompleteSemaphore, nullptr);
+		vkDestroyFence(mDevice, batch.fence, nullptr);
+		batch = Batch();
+	}
+
+	void UploadManager::ReleaseStaging(StagingRegion& staging)
+	{
+		if (staging.inRing)
+		{
+			mStagingHeap.Release(staging.ringRegion);
+		}
+		else
+		{
+			vkDestroyBuffer(mDevice, staging.buffer, nullptr);
+			mAllocator->Free(staging.fallbackAllocation);
+		}
+		staging = StagingRegion();
+	}
+
+	void UploadManager::CollectLocked()
+	{
+		while (!mSubmittedBatches.empty() && vkGetFenceStatus(mDevice, mSubmittedBatches.front().fence) == VK_SUCCESS)
+		{
+			Batch& batch = mSubmittedBatches.front();
+			for (StagingRegion& staging : batch.stagingRegions)
+			{
+				ReleaseStaging(staging);
+			}
+			batch.stagingRegions.clear();
+			vkResetFences(mDevice, 1, &batch.fence);
+			mLastCompletedTicket = batch.ticket;
+
+			mFreeBatches.push_back(std::move(batch));
+			mSubmittedBatches.pop_front();
+		}
+	}
+}
@@ -0,0 +1,195 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include "DeviceMemoryAllocator.h"
+#include "StagingHeap.h"
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Batches buffer & image uploads into a single submission, on a dedicated transfer queue when device has one.
+	/// Source data lives in a persistently mapped staging ring; uploads are queued until Flush(), which submits as many
+	/// as fit in the per-frame byte budget without waiting for them. Ownership of uploaded resources is released to
+	/// graphics queue family, whose queue acquires them before any later submission, so consumers on graphics queue
+	/// need no extra wait. Staging space is released once a batch's fence signals.
+	/// </summary>
+	class UploadManager final
+	{
+	public:
+		using Ticket = uint64_t;
+
+		/// <summary>
+		/// Staging memory an upload is read from. Either a slice of staging ring, or a one-off buffer when ring can't fit it.
+		/// Every reserved region must be handed to exactly one Upload call.
+		/// </summary>
+		struct StagingRegion
+		{
+			// Mapped memory to write source data into
+			void* data = nullptr;
+			VkDeviceSize size = 0;
+
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VkDeviceSize offset = 0;
+			bool inRing = false;
+			StagingHeap::Region ringRegion;
+			DeviceMemoryAllocator::Allocation fallbackAllocation;
+		};
+
+		UploadManager() = default;
+		UploadManager(const UploadManager&) = delete;
+		UploadManager& operator=(const UploadManager&) = delete;
+		UploadManager(UploadManager&&) = delete;
+		UploadManager& operator=(UploadManager&&) = delete;
+		~UploadManager() = default;
+
+		/// <summary>Sets queues used for uploads & creates staging ring.</summary>
+		/// <param name="device">Logical device.</param>
+		/// <param name="allocator">Allocator staging memory is taken from.</param>
+		/// <param name="transferFamily">Queue family copies are recorded for. May equal graphicsFamily.</param>
+		/// <param name="transferQueue">Queue of transferFamily.</param>
+		/// <param name="graphicsFamily">Queue family consuming uploaded resources.</param>
+		/// <param name="graphicsQueue">Queue of graphicsFamily.</param>
+		/// <param name="stagingCapacity">Size of staging ring in bytes.</param>
+		/// <param name="frameBudget">Bytes Flush() submits per frame, 0 for no limit.</param>
+		void Initialize(VkDevice device, DeviceMemoryAllocator& allocator, uint32_t transferFamily, VkQueue transferQueue, uint32_t graphicsFamily, VkQueue graphicsQueue,
+			VkDeviceSize stagingCapacity, VkDeviceSize frameBudget);
+
+		/// <summary>Waits for all submitted batches & destroys every Vulkan object owned by manager. Pending uploads are dropped.</summary>
+		void Shutdown();
+
+		/// <summary>Reserves staging memory, e.g. for a decoder to write into directly.</summary>
+		/// <param name="size">Bytes needed.</param>
+		/// <param name="alignment">Alignment of region within staging buffer. 16 satisfies texel & compressed block copies.</param>
+		/// <returns>Mapped region to write source data into.</returns>
+		StagingRegion ReserveStaging(VkDeviceSize size, VkDeviceSize alignment = 16);
+
+		/// <summary>Queues copy of staging region into buffer.</summary>
+		/// <param name="staging">Region returned by ReserveStaging(), filled with source data.</param>
+		/// <param name="buffer">Destination buffer created with TRANSFER_DST usage.</param>
+		/// <param name="dstStage">Pipeline stage which first consumes buffer.</param>
+		/// <param name="dstAccess">Access with which buffer is consumed.</param>
+		/// <param name="dstOffset">Offset into buffer data is copied to. Only this range changes queue family ownership.</param>
+		/// <returns>Ticket of upload.</returns>
+		Ticket UploadBuffer(const StagingRegion& staging, VkBuffer buffer, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, VkDeviceSize dstOffset = 0);
+
+		/// <summary>Copies data into staging memory & queues copy of it into buffer.</summary>
+		Ticket UploadBuffer(const void* data, VkDeviceSize size, VkBuffer buffer, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, VkDeviceSize dstOffset = 0);
+
+		/// <summary>
+		/// Queues copy of tightly packed texels into mips [0, mipLevels) of image & transition into finalLayout.
+		/// Levels follow each other largest first; size of a texel block is whatever makes whole chain fill staging region.
+		/// </summary>
+		/// <param name="staging">Region returned by ReserveStaging(), filled with texels.</param>
+		/// <param name="image">Destination image created with TRANSFER_DST usage, in UNDEFINED layout.</param>
+		/// <param name="width">Image width.</param>
+		/// <param name="height">Image height.</param>
+		/// <param name="mipLevels">Number of levels in staging region & image.</param>
+		/// <param name="blockExtent">Width & height of a texel block, 4 for block compressed formats.</param>
+		/// <param name="finalLayout">Layout image is left in.</param>
+		/// <param name="dstStage">Pipeline stage which first consumes image.</param>
+		/// <param name="dstAccess">Access with which image is consumed.</param>
+		/// <returns>Ticket of upload.</returns>
+		Ticket UploadImage(const StagingRegion& staging, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels = 1, uint32_t blockExtent = 1,
+			VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VkAccessFlags dstAccess = VK_ACCESS_SHADER_READ_BIT);
+
+		/// <summary>Copies texels into staging memory & queues copy of them into image.</summary>
+		Ticket UploadImage(const void* data, VkDeviceSize size, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels = 1, uint32_t blockExtent = 1,
+			VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VkAccessFlags dstAccess = VK_ACCESS_SHADER_READ_BIT);
+
+		/// <summary>Frees staging space of batches GPU has finished & resets per-frame budget.</summary>
+		void BeginFrame();
+
+		/// <summary>
+		/// Submits queued uploads as one batch, oldest first, until frame budget is spent. First upload of a frame always goes,
+		/// so one upload bigger than budget can't stall forever. Acquire barriers are submitted on graphics queue,
+		/// so call it from thread which submits frames.
+		/// </summary>
+		/// <param name="ignoreBudget">Submits every queued upload, e.g. during loading.</param>
+		/// <returns>Ticket of last submitted upload.</returns>
+		Ticket Flush(bool ignoreBudget = false);
+
+		/// <summary>Checks whether upload has finished on GPU.</summary>
+		/// <param name="ticket">Ticket returned by an Upload call.</param>
+		/// <returns>True once upload & every upload before it completed.</returns>
+		bool IsComplete(Ticket ticket);
+
+		/// <summary>Blocks until upload has finished on GPU, flushing it first if still queued.</summary>
+		/// <param name="ticket">Ticket returned by an Upload call.</param>
+		void Wait(Ticket ticket);
+
+		bool HasDedicatedTransferQueue() const;
+
+		/// <summary>Gets bytes submitted since last BeginFrame().</summary>
+		VkDeviceSize BytesUploadedThisFrame() const;
+
+	private:
+		struct PendingUpload
+		{
+			StagingRegion staging;
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VkDeviceSize bufferOffset = 0;
+			VkImage image = VK_NULL_HANDLE;
+			uint32_t width = 0;
+			uint32_t height = 0;
+			uint32_t mipLevels = 1;
+			uint32_t blockExtent = 1;
+			VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkPipelineStageFlags dstStage = 0;
+			VkAccessFlags dstAccess = 0;
+			Ticket ticket = 0;
+		};
+
+		struct Batch
+		{
+			VkCommandPool transferCommandPool = VK_NULL_HANDLE;
+			VkCommandBuffer transferCommandBuffer = VK_NULL_HANDLE;
+			VkCommandPool acquireCommandPool = VK_NULL_HANDLE;
+			VkCommandBuffer acquireCommandBuffer = VK_NULL_HANDLE;
+			VkSemaphore transferCompleteSemaphore = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+
+			std::vector<StagingRegion> stagingRegions;
+			std::vector<VkBufferMemoryBarrier> acquireBufferBarriers;
+			std::vector<VkImageMemoryBarrier> acquireImageBarriers;
+			VkPipelineStageFlags acquireStages = 0;
+
+			// Ticket of last upload in batch
+			Ticket ticket = 0;
+		};
+
+		Ticket Enqueue(PendingUpload&& upload);
+		Ticket FlushLocked(bool ignoreBudget);
+		void RecordBufferUpload(Batch& batch, const PendingUpload& upload);
+		void RecordImageUpload(Batch& batch, const PendingUpload& upload);
+		Batch AcquireBatch();
+		Batch CreateBatch();
+		void DestroyBatch(Batch& batch);
+		void ReleaseStaging(StagingRegion& staging);
+		void CollectLocked();
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		DeviceMemoryAllocator* mAllocator = nullptr;
+		uint32_t mTransferFamily = 0;
+		VkQueue mTransferQueue = VK_NULL_HANDLE;
+		uint32_t mGraphicsFamily = 0;
+		VkQueue mGraphicsQueue = VK_NULL_HANDLE;
+
+		mutable std::mutex mMutex;
+		StagingHeap mStagingHeap;
+		std::deque<PendingUpload> mPendingUploads;
+		std::deque<Batch> mSubmittedBatches;
+		std::vector<Batch> mFreeBatches;
+
+		VkDeviceSize mFrameBudget = 0;
+		VkDeviceSize mBytesThisFrame = 0;
+
+		Ticket mLastQueuedTicket = 0;
+		Ticket mLastSubmittedTicket = 0;
+		Ticket mLastCompletedTicket = 0;
+	};
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Conversions of vertex attributes into compact GPU formats, each matching a fixed function Vulkan vertex format.
+	/// </summary>
+	class VertexPacking final
+	{
+	public:
+		/// <summary>Maps value in [0, 1] onto VK_FORMAT_R16_UNORM.</summary>
+		static uint16_t QuantizeUnorm16(float value);
+
+		/// <summary>Converts to VK_FORMAT_R16_SFLOAT, rounding to nearest even.</summary>
+		static uint16_t FloatToHalf(float value);
+
+		/// <summary>
+		/// Encodes a unit normal as a point of the octahedron unfolded onto a square, in VK_FORMAT_R16G16_SNORM.
+		/// Shader decodes n = (e.x, e.y, 1 - |e.x| - |e.y|), folding back xy by max(-n.z, 0) when z is negative.
+		/// </summary>
+		/// <param name="normal">Normal, need not be normalised.</param>
+		/// <param name="encoded">Two snorm16 components.</param>
+		static void EncodeOctahedral(const glm::vec3& normal, int16_t encoded[2]);
+	};
+}
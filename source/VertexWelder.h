@@ -0,0 +1,174 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <type_traits>
+
+namespace AlphonsoGraphicsEngine
+{
+	/// <summary>
+	/// Merges duplicate vertices through an open addressing hash table over vertex bytes.
+	/// Vertices are kept in order of first occurrence; table & vertex storage grow geometrically,
+	/// so welding allocates nothing per vertex. By default only bitwise equal vertices are welded.
+	/// With a position epsilon positions are snapped to a grid of that cell size for comparison,
+	/// so vertices welding depends on them falling in same cell, not on their exact distance.
+	/// </summary>
+	/// <typeparam name="TVertex">Vertex without padding bytes, with a glm::vec3 member named pos.</typeparam>
+	template <typename TVertex>
+	class VertexWelder final
+	{
+		static_assert(std::is_trivially_copyable<TVertex>::value && sizeof(TVertex) % sizeof(uint32_t) == 0, "vertex must be trivially copyable & a whole number of words");
+
+	public:
+		/// <summary>Creates welder sized for an expected number of unique vertices.</summary>
+		/// <param name="expectedVertexCount">Unique vertices expected, so neither table nor storage has to grow.</param>
+		/// <param name="positionEpsilon">Cell size positions are snapped to, 0 for exact welding.</param>
+		explicit VertexWelder(size_t expectedVertexCount = 0, float positionEpsilon = 0.0f) :
+			mInverseEpsilon(positionEpsilon > 0.0f ? 1.0f / positionEpsilon : 0.0f)
+		{
+			mVertices.reserve(expectedVertexCount);
+			Rehash(SlotCountFor(expectedVertexCount));
+		}
+
+		VertexWelder(const VertexWelder&) = delete;
+		VertexWelder& operator=(const VertexWelder&) = delete;
+		VertexWelder(VertexWelder&&) = default;
+		VertexWelder& operator=(VertexWelder&&) = default;
+		~VertexWelder() = default;
+
+		/// <summary>Finds vertex equal to given one, adding it if there is none.</summary>
+		/// <param name="vertex">Vertex to weld.</param>
+		/// <returns>Index of welded vertex.</returns>
+		uint32_t Weld(const TVertex& vertex)
+		{
+			if ((mVertices.size() + 1) * 2 > mSlots.size())
+			{
+				Rehash(mSlots.size() * 2);
+			}
+
+			TVertex snappedKey;
+			const TVertex& key = Key(vertex, snappedKey);
+			uint64_t hash = Hash(key);
+			uint32_t tag = static_cast<uint32_t>(hash >> 32);
+			size_t mask = mSlots.size() - 1;
+
+			for (size_t slotIndex = static_cast<size_t>(hash) & mask;; slotIndex = (slotIndex + 1) & mask)
+			{
+				Slot& slot = mSlots[slotIndex];
+				if (slot.index == EmptySlot)
+				{
+					slot.index = static_cast<uint32_t>(mVertices.size());
+					slot.tag = tag;
+					mVertices.push_back(vertex);
+					return slot.index;
+				}
+
+				if (slot.tag == tag)
+				{
+					TVertex snappedCandidate;
+					const TVertex& candidate = Key(mVertices[slot.index], snappedCandidate);
+					if (memcmp(&candidate, &key, sizeof(TVertex)) == 0)
+					{
+						return slot.index;
+					}
+				}
+			}
+		}
+
+		const std::vector<TVertex>& Vertices() const
+		{
+			return mVertices;
+		}
+
+		/// <summary>Hands welded vertices over to caller, leaving welder empty.</summary>
+		std::vector<TVertex> TakeVertices()
+		{
+			std::vector<TVertex> vertices = std::move(mVertices);
+			mVertices.clear();
+			Rehash(mSlots.size());
+			return vertices;
+		}
+
+	private:
+		struct Slot
+		{
+			uint32_t index = EmptySlot;
+			// High half of hash, rejects most mismatches without touching vertex
+			uint32_t tag = 0;
+		};
+
+		static constexpr uint32_t EmptySlot = UINT32_MAX;
+
+		static size_t SlotCountFor(size_t vertexCount)
+		{
+			// Keep load factor at most one half
+			size_t slotCount = 16;
+			while (slotCount < vertexCount * 2)
+			{
+				slotCount <<= 1;
+			}
+			return slotCount;
+		}
+
+		// Gets bytes vertex is compared by. Exact welding uses vertex itself, snapped copy is only built with an epsilon.
+		const TVertex& Key(const TVertex& vertex, TVertex& snapped) const
+		{
+			if (mInverseEpsilon == 0.0f)
+			{
+				return vertex;
+			}
+
+			snapped = vertex;
+			snapped.pos.x = std::floor(vertex.pos.x * mInverseEpsilon);
+			snapped.pos.y = std::floor(vertex.pos.y * mInverseEpsilon);
+			snapped.pos.z = std::floor(vertex.pos.z * mInverseEpsilon);
+			return snapped;
+		}
+
+		static uint64_t Hash(const TVertex& key)
+		{
+			uint32_t words[sizeof(TVertex) / sizeof(uint32_t)];
+			memcpy(words, &key, sizeof(TVertex));
+
+			// Two independent multiply-rotate lanes, so consecutive words don't wait on each other's multiply,
+			// followed by murmur3 finalizer, so every bit of every attribute reaches every bit of hash
+			uint64_t lanes[2] = { 0x9e3779b97f4a7c15ull, 0xc2b2ae3d27d4eb4full };
+			for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); ++i)
+			{
+				uint64_t& lane = lanes[i & 1];
+				lane ^= words[i] * 0xff51afd7ed558ccdull;
+				lane = ((lane << 31) | (lane >> 33)) * 0x87c37b91114253d5ull;
+			}
+			uint64_t hash = lanes[0] ^ ((lanes[1] << 29) | (lanes[1] >> 35));
+			hash ^= hash >> 33;
+			hash *= 0xff51afd7ed558ccdull;
+			hash ^= hash >> 33;
+			hash *= 0xc4ceb9fe1a85ec53ull;
+			hash ^= hash >> 33;
+			return hash;
+		}
+
+		void Rehash(size_t slotCount)
+		{
+			mSlots.assign(slotCount, Slot());
+			size_t mask = slotCount - 1;
+			for (uint32_t vertexIndex = 0; vertexIndex < mVertices.size(); ++vertexIndex)
+			{
+				TVertex snappedKey;
+				uint64_t hash = Hash(Key(mVertices[vertexIndex], snappedKey));
+				size_t slotIndex = static_cast<size_t>(hash) & mask;
+				while (mSlots[slotIndex].index != EmptySlot)
+				{
+					slotIndex = (slotIndex + 1) & mask;
+				}
+				mSlots[slotIndex].index = vertexIndex;
+				mSlots[slotIndex].tag = static_cast<uint32_t>(hash >> 32);
+			}
+		}
+
+		std::vector<Slot> mSlots;
+		std::vector<TVertex> mVertices;
+		float mInverseEpsilon = 0.0f;
+	};
+}
@@ -1,5 +1,7 @@
 #include <iostream>
+#include <cstring>
 #include "RendererC.h"
+#include "AssetFileSystem.h"
 
 #if defined(DEBUG) || defined(_DEBUG)
 #define _CRTDBG_MAP_ALLOC
@@ -9,13 +11,31 @@
 
 using namespace AlphonsoGraphicsEngine;
 
-int main() 
+int main(int argc, char* argv[])
 {
 	// Code for Memory Leak Detection.
 #if defined(DEBUG) | defined(_DEBUG)
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 
+	// "--build-pack" packs loose Assets directory into Assets.pack next to it & exits
+	if (argc > 1 && strcmp(argv[1], "--build-pack") == 0)
+	{
+		AssetFileSystem assets;
+		bool found = assets.Initialize() && !assets.AssetRoot().empty();
+		std::string assetRoot = assets.AssetRoot();
+		std::string packPath = assets.PackPath();
+		// Old pack is unmapped first, Windows can't replace a mapped file
+		assets.Shutdown();
+		if (!found || !AssetPack::Build(assetRoot, packPath))
+		{
+			std::cerr << "failed to build asset pack!" << std::endl;
+			return EXIT_FAILURE;
+		}
+		std::cout << "built " << packPath << std::endl;
+		return EXIT_SUCCESS;
+	}
+
 	RendererC renderer;
 	try
 	{